@@ -44,6 +44,9 @@
 #include <gdk/gdkkeysyms.h>
 #include <cairo/cairo-xlib.h>
 #include <freerdp/locale/keyboard.h>
+#ifdef __GLIBC__
+#    include <malloc.h>
+#endif
 
 int remmina_rdp_event_on_map( RemminaProtocolWidget *gp )
 {
@@ -55,6 +58,8 @@ int remmina_rdp_event_on_map( RemminaProtocolWidget *gp )
         return false;
 
     gdi = ( (rdpContext *)rfi )->gdi;
+    if( !gdi )
+        return FALSE;
 
     REMMINA_PLUGIN_DEBUG( "Map event received, disabling TS_SUPPRESS_OUTPUT_PDU " );
     gdi_send_suppress_output( gdi, FALSE );
@@ -71,16 +76,12 @@ int remmina_rdp_event_on_unmap( RemminaProtocolWidget *gp )
     if( rfi == NULL )
         return false;
 
-    GtkWidget *toplevel = gtk_widget_get_toplevel( GTK_WIDGET( gp ) );
-    GdkWindow *window = gtk_widget_get_window( toplevel );
-
-    if( gdk_window_get_fullscreen_mode( window ) == GDK_FULLSCREEN_ON_ALL_MONITORS )
-    {
-        REMMINA_PLUGIN_DEBUG( "Unmap event received, but cannot enable TS_SUPPRESS_OUTPUT_PDU when in fullscreen" );
-        return FALSE;
-    }
-
+    /* This is driven by remmina_protocol_widget_set_visible(), not by raw GDK unmap events,
+     * so it is also safe when fullscreen spans all monitors: the fullscreen window map
+     * handler makes the widget visible again */
     gdi = ( (rdpContext *)rfi )->gdi;
+    if( !gdi )
+        return FALSE;
 
     REMMINA_PLUGIN_DEBUG( "Unmap event received, enabling TS_SUPPRESS_OUTPUT_PDU " );
     gdi_send_suppress_output( gdi, TRUE );
@@ -153,6 +154,10 @@ void remmina_rdp_event_event_push( RemminaProtocolWidget *gp, const RemminaPlugi
         if( write( rfi->event_pipe[1], "\0", 1 ) )
         {
         }
+
+        if( e->type == REMMINA_RDP_EVENT_TYPE_SCANCODE || e->type == REMMINA_RDP_EVENT_TYPE_SCANCODE_UNICODE
+            || e->type == REMMINA_RDP_EVENT_TYPE_MOUSE )
+            remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_INPUT_SENT, 0 );
     }
 }
 
@@ -269,6 +274,14 @@ void remmina_rdp_event_update_regions( RemminaProtocolWidget *gp, RemminaPluginR
     TRACE_CALL( __func__ );
     rfContext *rfi = GET_PLUGIN_DATA( gp );
     gint x, y, w, h, i;
+    gint64 start = 0;
+
+    if( rfi->bench )
+    {
+        start = g_get_monotonic_time();
+        rfi->bench_updates++;
+        rfi->bench_queue_us += start - ui->reg.queued;
+    }
 
     for( i = 0; i < ui->reg.ninvalid; i++ )
     {
@@ -283,6 +296,9 @@ void remmina_rdp_event_update_regions( RemminaProtocolWidget *gp, RemminaPluginR
         gtk_widget_queue_draw_area( rfi->drawing_area, x, y, w, h );
     }
     g_free( ui->reg.ureg );
+
+    if( rfi->bench )
+        rfi->bench_update_us += g_get_monotonic_time() - start;
 }
 
 void remmina_rdp_event_update_rect( RemminaProtocolWidget *gp, gint x, gint y, gint w, gint h )
@@ -338,6 +354,7 @@ static int remmina_rdp_event_on_draw( GtkWidget *widget, cairo_t *context, Remmi
     guint width, height;
     char *msg;
     cairo_text_extents_t extents;
+    gint64 start;
 
     if( !rfi || !rfi->connected )
         return FALSE;
@@ -373,10 +390,19 @@ static int remmina_rdp_event_on_draw( GtkWidget *widget, cairo_t *context, Remmi
         if( rfi->scale == REMMINA_PROTOCOL_WIDGET_SCALE_MODE_SCALED )
             cairo_scale( context, rfi->scale_x, rfi->scale_y );
 
+        start = g_get_monotonic_time();
         cairo_set_source_surface( context, rfi->surface, 0, 0 );
 
         cairo_set_operator( context, CAIRO_OPERATOR_SOURCE ); // Ignore alpha channel from FreeRDP
         cairo_paint( context );
+        if( rfi->bench )
+        {
+            rfi->bench_paints++;
+            rfi->bench_paint_us += g_get_monotonic_time() - start;
+        }
+        remmina_plugin_service->protocol_plugin_perf_add(
+            gp, REMMINA_PERF_CONVERT_US, g_get_monotonic_time() - start );
+        remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_FRAME_PRESENTED, 0 );
     }
 
     return TRUE;
@@ -1006,6 +1032,7 @@ void remmina_rdp_event_init( RemminaProtocolWidget *gp )
     rfi->event_queue = g_async_queue_new_full( g_free );
     rfi->ui_queue = g_async_queue_new();
     pthread_mutex_init( &rfi->ui_queue_mutex, NULL );
+    pthread_mutex_init( &rfi->primary_mutex, NULL );
 
     if( pipe( rfi->event_pipe ) )
     {
@@ -1099,6 +1126,7 @@ void remmina_rdp_event_uninit( RemminaProtocolWidget *gp )
     g_async_queue_unref( rfi->ui_queue );
     rfi->ui_queue = NULL;
     pthread_mutex_destroy( &rfi->ui_queue_mutex );
+    pthread_mutex_destroy( &rfi->primary_mutex );
 
     if( rfi->event_handle )
     {
@@ -1360,6 +1388,55 @@ static void remmina_rdp_ui_event_destroy_cairo_surface( RemminaProtocolWidget *g
     rfi->surface = NULL;
 }
 
+/* Heap in use, to tell how much a replay allocated and never freed per frame.
+ * Allocation counts need an external tool such as heaptrack */
+static gint64 remmina_rdp_event_bench_heap( void )
+{
+#ifdef __GLIBC__
+#    if __GLIBC_PREREQ( 2, 33 )
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+#    endif
+#endif
+    return 0;
+}
+
+void remmina_rdp_event_bench_start( RemminaProtocolWidget *gp )
+{
+    TRACE_CALL( __func__ );
+    rfContext *rfi = GET_PLUGIN_DATA( gp );
+
+    rfi->bench = TRUE;
+    rfi->bench_start = g_get_monotonic_time();
+    rfi->bench_heap_start = remmina_rdp_event_bench_heap();
+}
+
+/* Runs on the main thread once the RDP thread stopped updating its counters */
+static void remmina_rdp_ui_event_bench_report( RemminaProtocolWidget *gp, RemminaPluginRdpUiObject *ui )
+{
+    TRACE_CALL( __func__ );
+    rfContext *rfi = GET_PLUGIN_DATA( gp );
+    gint64 elapsed = MAX( g_get_monotonic_time() - rfi->bench_start, 1 );
+    gint64 heap = remmina_rdp_event_bench_heap() - rfi->bench_heap_start;
+    guint64 frames = MAX( rfi->bench_frames, 1 );
+
+    REMMINA_PLUGIN_INFO( "Transport dump replay: %.3f s, %" G_GUINT64_FORMAT " frames (%.1f/s), %.1f Mpixel damaged",
+                         elapsed / 1e6,
+                         rfi->bench_frames,
+                         rfi->bench_frames * 1e6 / elapsed,
+                         rfi->bench_pixels / 1e6 );
+    REMMINA_PLUGIN_INFO( "  decode (BeginPaint to EndPaint): %.1f ms, %.1f us/frame",
+                         rfi->bench_decode_us / 1e3,
+                         (double)rfi->bench_decode_us / frames );
+    REMMINA_PLUGIN_INFO( "  UI queue wait: %.1f us/update, update regions: %.1f us/update",
+                         (double)rfi->bench_queue_us / MAX( rfi->bench_updates, 1 ),
+                         (double)rfi->bench_update_us / MAX( rfi->bench_updates, 1 ) );
+    REMMINA_PLUGIN_INFO( "  cairo paint: %" G_GUINT64_FORMAT " paints, %.1f us/paint",
+                         rfi->bench_paints,
+                         (double)rfi->bench_paint_us / MAX( rfi->bench_paints, 1 ) );
+    REMMINA_PLUGIN_INFO( "  heap growth: %.1f bytes/frame", (double)heap / frames );
+}
+
 static void remmina_rdp_event_process_event( RemminaProtocolWidget *gp, RemminaPluginRdpUiObject *ui )
 {
     TRACE_CALL( __func__ );
@@ -1371,6 +1448,9 @@ static void remmina_rdp_event_process_event( RemminaProtocolWidget *gp, RemminaP
         case REMMINA_RDP_UI_EVENT_DESTROY_CAIRO_SURFACE:
             remmina_rdp_ui_event_destroy_cairo_surface( gp, ui );
             break;
+        case REMMINA_RDP_UI_EVENT_BENCH_REPORT:
+            remmina_rdp_ui_event_bench_report( gp, ui );
+            break;
     }
 }
 
@@ -1477,6 +1557,8 @@ static void remmina_rdp_event_queue_ui( RemminaProtocolWidget *gp, RemminaPlugin
     ui->complete = FALSE;
 
     g_async_queue_push( rfi->ui_queue, ui );
+    remmina_plugin_service->protocol_plugin_perf_add(
+        gp, REMMINA_PERF_QUEUE_DEPTH, g_async_queue_length( rfi->ui_queue ) );
 
     if( !rfi->ui_handler )
         rfi->ui_handler = IDLE_ADD( (GSourceFunc)remmina_rdp_event_process_ui_queue, gp );
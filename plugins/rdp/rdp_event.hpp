@@ -47,4 +47,5 @@ int remmina_rdp_event_queue_ui_sync_retint( RemminaProtocolWidget *gp, RemminaPl
 void *remmina_rdp_event_queue_ui_sync_retptr( RemminaProtocolWidget *gp, RemminaPluginRdpUiObject *ui );
 int remmina_rdp_event_on_map( RemminaProtocolWidget *gp );
 int remmina_rdp_event_on_unmap( RemminaProtocolWidget *gp );
+void remmina_rdp_event_bench_start( RemminaProtocolWidget *gp );
 
@@ -68,6 +68,7 @@
 
 #include <unistd.h>
 #include <string.h>
+#include <glib/gstdio.h>
 
 #ifdef GDK_WINDOWING_X11
 #    include <X11/Xlib.h>
@@ -357,10 +358,42 @@ static int remmina_rdp_tunnel_init( RemminaProtocolWidget *gp )
     char *cert_host;
     gint cert_port;
     gint port;
+    gint sock;
 
     rfContext *rfi = GET_PLUGIN_DATA( gp );
 
     REMMINA_PLUGIN_DEBUG( "Tunnel init" );
+    if( !remmina_plugin_service->protocol_plugin_start_direct_tunnel_socket( gp, 3389, FALSE, &sock ) )
+        return FALSE;
+    if( sock >= 0 )
+    {
+        /* FreeRDP connects over the already connected socket given as port when the host name is "|" */
+        if( !rfi->is_reconnecting )
+        {
+            remmina_plugin_service->get_server_port(
+                remmina_plugin_service->file_get_string( remmina_plugin_service->protocol_plugin_get_file( gp ),
+                                                         "server" ),
+                3389,
+                &cert_host,
+                &cert_port );
+            freerdp_settings_set_string( rfi->settings, FreeRDP_ServerHostname, "|" );
+            if( cert_port == 3389 )
+            {
+                freerdp_settings_set_string( rfi->settings, FreeRDP_CertificateName, cert_host );
+            }
+            else
+            {
+                s = g_strdup_printf( "%s:%d", cert_host, cert_port );
+                freerdp_settings_set_string( rfi->settings, FreeRDP_CertificateName, s );
+                g_free( s );
+            }
+            g_free( cert_host );
+        }
+        REMMINA_PLUGIN_DEBUG( "Tunnel has been initialized. Now connecting over socket %d", sock );
+        freerdp_settings_set_uint32( rfi->settings, FreeRDP_ServerPort, sock );
+        return TRUE;
+    }
+
     hostport = remmina_plugin_service->protocol_plugin_start_direct_tunnel( gp, 3389, FALSE );
     if( hostport == NULL )
         return FALSE;
@@ -509,6 +542,7 @@ BOOL rf_auto_reconnect( rfContext *rfi )
                 /* Reconnection is successful */
                 REMMINA_PLUGIN_DEBUG( "[%s] reconnected.",
                                       freerdp_settings_get_string( rfi->settings, FreeRDP_ServerHostname ) );
+                remmina_plugin_service->protocol_plugin_perf_add( rfi->protocol_widget, REMMINA_PERF_RECONNECT, 0 );
                 rfi->is_reconnecting = FALSE;
                 return TRUE;
             }
@@ -539,10 +573,14 @@ BOOL rf_begin_paint( rdpContext *context )
     if( !gdi || !gdi->primary || !gdi->primary->hdc || !gdi->primary->hdc->hwnd )
         return FALSE;
 
+    ( (rfContext *)context )->paint_start = g_get_monotonic_time();
+    pthread_mutex_lock( &( (rfContext *)context )->primary_mutex );
+    ( (rfContext *)context )->primary_locked = TRUE;
+
     return TRUE;
 }
 
-BOOL rf_end_paint( rdpContext *context )
+static BOOL rf_end_paint_regions( rdpContext *context )
 {
     TRACE_CALL( __func__ );
     rdpGdi *gdi;
@@ -551,6 +589,9 @@ BOOL rf_end_paint( rdpContext *context )
     int i, ninvalid;
     region *reg;
     HGDI_RGN cinvalid;
+    gint64 damage = 0;
+    gint64 decode_us;
+    UINT64 bytes_in = 0, bytes_out = 0;
 
     gdi = context->gdi;
     rfi = (rfContext *)context;
@@ -573,13 +614,43 @@ BOOL rf_end_paint( rdpContext *context )
         reg[i].y = cinvalid[i].y;
         reg[i].w = cinvalid[i].w;
         reg[i].h = cinvalid[i].h;
-    }
+        damage += (gint64)cinvalid[i].w * cinvalid[i].h;
+    }
+
+    /* Everything between BeginPaint and EndPaint is codec and GDI work */
+    decode_us = g_get_monotonic_time() - rfi->paint_start;
+    rfi->session_decode_us += decode_us;
+    rfi->session_frames++;
+    rfi->session_pixels += damage;
+    remmina_plugin_service->protocol_plugin_perf_add( rfi->protocol_widget, REMMINA_PERF_DECODE_US, decode_us );
+    remmina_plugin_service->protocol_plugin_perf_add( rfi->protocol_widget, REMMINA_PERF_FRAME_RECEIVED, 0 );
+    remmina_plugin_service->protocol_plugin_perf_add( rfi->protocol_widget, REMMINA_PERF_DAMAGE_PIXELS, damage );
+    /* The session totals never reset, keep the last values so that turning the
+     * overlay or the exporter on does not report the bytes of the whole session at once */
+    freerdp_get_stats( context->rdp, &bytes_in, &bytes_out, NULL, NULL );
+    if( remmina_plugin_service->protocol_plugin_perf_enabled( rfi->protocol_widget ) )
+    {
+        remmina_plugin_service->protocol_plugin_perf_add(
+            rfi->protocol_widget, REMMINA_PERF_BYTES_IN, bytes_in - rfi->perf_bytes_in );
+        remmina_plugin_service->protocol_plugin_perf_add(
+            rfi->protocol_widget, REMMINA_PERF_BYTES_OUT, bytes_out - rfi->perf_bytes_out );
+    }
+    rfi->perf_bytes_in = bytes_in;
+    rfi->perf_bytes_out = bytes_out;
 
     ui = g_new0( RemminaPluginRdpUiObject, 1 );
     ui->type = REMMINA_RDP_UI_UPDATE_REGIONS;
     ui->reg.ninvalid = ninvalid;
     ui->reg.ureg = reg;
 
+    if( rfi->bench )
+    {
+        ui->reg.queued = g_get_monotonic_time();
+        rfi->bench_frames++;
+        rfi->bench_pixels += damage;
+        rfi->bench_decode_us += ui->reg.queued - rfi->paint_start;
+    }
+
     remmina_rdp_event_queue_ui_async( rfi->protocol_widget, ui );
 
     gdi->primary->hdc->hwnd->invalid->null = TRUE;
@@ -588,6 +659,21 @@ BOOL rf_end_paint( rdpContext *context )
     return TRUE;
 }
 
+BOOL rf_end_paint( rdpContext *context )
+{
+    TRACE_CALL( __func__ );
+    rfContext *rfi = (rfContext *)context;
+    BOOL ret;
+
+    ret = rf_end_paint_regions( context );
+    if( rfi->primary_locked )
+    {
+        rfi->primary_locked = FALSE;
+        pthread_mutex_unlock( &rfi->primary_mutex );
+    }
+    return ret;
+}
+
 static BOOL rf_desktop_resize( rdpContext *context )
 {
     TRACE_CALL( __func__ );
@@ -611,7 +697,9 @@ static BOOL rf_desktop_resize( rdpContext *context )
 
     /* Tell libfreerdp to change its internal GDI bitmap width and heigt,
 	 * this will also destroy gdi->primary_buffer, making our rfi->surface invalid */
+    pthread_mutex_lock( &rfi->primary_mutex );
     gdi_resize( ( (rdpContext *)rfi )->gdi, w, h );
+    pthread_mutex_unlock( &rfi->primary_mutex );
 
     /* Call to remmina_rdp_event_update_scale(gp) on the main UI thread,
 	 * this will recreate rfi->surface from gdi->primary_buffer */
@@ -1120,6 +1208,23 @@ static void remmina_rdp_main_loop( RemminaProtocolWidget *gp )
     }
     freerdp_disconnect( rfi->instance );
     REMMINA_PLUGIN_DEBUG( "RDP client disconnected" );
+
+    if( rfi->session_frames > 0 )
+        REMMINA_PLUGIN_INFO( "Session decode time %.3f s for %" G_GUINT64_FORMAT " frames "
+                             "(%.2f ms per frame, %.1f ns per pixel, %s codec threads)",
+                             rfi->session_decode_us / 1e6,
+                             rfi->session_frames,
+                             rfi->session_decode_us / 1e3 / rfi->session_frames,
+                             rfi->session_pixels ? rfi->session_decode_us * 1e3 / rfi->session_pixels : 0.0,
+                             rfi->parallel_decoding ? "parallel" : "single" );
+
+    if( rfi->bench )
+    {
+        RemminaPluginRdpUiObject *ui = g_new0( RemminaPluginRdpUiObject, 1 );
+        ui->type = REMMINA_RDP_UI_EVENT;
+        ui->event.type = REMMINA_RDP_UI_EVENT_BENCH_REPORT;
+        remmina_rdp_event_queue_ui_sync_retint( gp, ui );
+    }
 }
 
 int remmina_rdp_load_static_channel_addin( rdpChannels *channels, rdpSettings *settings, const char *name, void *data )
@@ -1458,6 +1563,231 @@ static char *remmina_get_rdp_kbd_remap( const char *keymap )
     return rdp_kbd_remap;
 }
 
+#ifdef WITH_FREERDP3
+/* Persistent bitmap cache.
+ * libfreerdp reads the file named by FreeRDP_BitmapCachePersistFile to send the persistent key list
+ * and the RDPGFX cache import offer, and writes it back when the session is freed. Remmina picks one
+ * file per host, checks it before libfreerdp trusts its content and keeps the cache directory under
+ * a size limit, evicting the least recently used hosts first. */
+
+#    define REMMINA_RDP_BITMAP_CACHE_DEFAULT_SIZE 100 /* MiB */
+
+/* File layouts of libfreerdp/cache/persistent.c: every entry holds a 64x64 32bpp tile,
+ * version 3 files (RDPGFX) start with a signature and use a shorter entry header */
+#    define REMMINA_RDP_BITMAP_CACHE_TILE_SIZE ( 64 * 64 * 4 )
+#    define REMMINA_RDP_BITMAP_CACHE_V3_SIGNATURE "RDP8bmp"
+#    define REMMINA_RDP_BITMAP_CACHE_V3_HEADER 12
+#    define REMMINA_RDP_BITMAP_CACHE_V3_ENTRY 12
+#    define REMMINA_RDP_BITMAP_CACHE_V2_ENTRY 20
+
+struct RemminaRdpBitmapCacheFile
+{
+    char *path;
+    goffset size;
+    gint64 mtime;
+};
+
+/* Cut a cache file after its last consistent entry. A file that is wrong from its first entry is
+ * removed, libfreerdp then starts from an empty cache and writes a new one at the end of the session */
+static void remmina_rdp_bitmap_cache_check( const char *path )
+{
+    TRACE_CALL( __func__ );
+    FILE *fp;
+    GStatBuf st;
+    guint8 header[REMMINA_RDP_BITMAP_CACHE_V2_ENTRY];
+    size_t header_size;
+    goffset start, offset, entry_size;
+    guint width, height;
+
+    if( g_stat( path, &st ) != 0 )
+        return;
+    fp = g_fopen( path, "rb" );
+    if( !fp )
+        return;
+
+    if( fread( header, 1, 8, fp ) == 8 && memcmp( header, REMMINA_RDP_BITMAP_CACHE_V3_SIGNATURE, 8 ) == 0 )
+    {
+        start = REMMINA_RDP_BITMAP_CACHE_V3_HEADER;
+        header_size = REMMINA_RDP_BITMAP_CACHE_V3_ENTRY;
+    }
+    else
+    {
+        start = 0;
+        header_size = REMMINA_RDP_BITMAP_CACHE_V2_ENTRY;
+    }
+    entry_size = header_size + REMMINA_RDP_BITMAP_CACHE_TILE_SIZE;
+
+    /* Both entry headers begin with key64 followed by the little endian tile width and height */
+    for( offset = start; offset + entry_size <= st.st_size; offset += entry_size )
+    {
+        if( fseeko( fp, offset, SEEK_SET ) != 0 || fread( header, 1, header_size, fp ) != header_size )
+            break;
+        width = header[8] | ( header[9] << 8 );
+        height = header[10] | ( header[11] << 8 );
+        if( width == 0 || height == 0 || width > 64 || height > 64 )
+            break;
+    }
+    fclose( fp );
+
+    if( offset == st.st_size )
+        return;
+
+    if( offset == start )
+    {
+        REMMINA_PLUGIN_INFO( "Bitmap cache %s is damaged, removing it", path );
+        g_unlink( path );
+    }
+    else
+    {
+        REMMINA_PLUGIN_INFO( "Bitmap cache %s is damaged, keeping its first %" G_GINT64_FORMAT " bytes",
+                             path,
+                             (gint64)offset );
+        if( truncate( path, offset ) != 0 )
+            g_unlink( path );
+    }
+}
+
+static gint remmina_rdp_bitmap_cache_file_cmp( gconstpointer a, gconstpointer b )
+{
+    const RemminaRdpBitmapCacheFile *fa = (const RemminaRdpBitmapCacheFile *)a;
+    const RemminaRdpBitmapCacheFile *fb = (const RemminaRdpBitmapCacheFile *)b;
+
+    /* Most recently used first */
+    return fa->mtime < fb->mtime ? 1 : ( fa->mtime > fb->mtime ? -1 : 0 );
+}
+
+/* Evict the least recently used caches of dir beyond limit bytes. keep, the cache of
+ * the host being connected, counts towards the limit but is never evicted: FreeRDP
+ * rewrites it when the session ends, removing it would only lose it every time */
+static void remmina_rdp_bitmap_cache_prune( const char *dir, const char *keep, goffset limit )
+{
+    TRACE_CALL( __func__ );
+    GDir *gdir;
+    GArray *files;
+    const char *name;
+    RemminaRdpBitmapCacheFile file;
+    GStatBuf st;
+    goffset total;
+    guint i;
+
+    gdir = g_dir_open( dir, 0, NULL );
+    if( !gdir )
+        return;
+
+    files = g_array_new( FALSE, FALSE, sizeof( RemminaRdpBitmapCacheFile ) );
+    while( ( name = g_dir_read_name( gdir ) ) != NULL )
+    {
+        if( !g_str_has_suffix( name, ".bmc" ) )
+            continue;
+        file.path = g_build_filename( dir, name, NULL );
+        if( g_stat( file.path, &st ) != 0 )
+        {
+            g_free( file.path );
+            continue;
+        }
+        file.size = st.st_size;
+        file.mtime = st.st_mtime;
+        g_array_append_val( files, file );
+    }
+    g_dir_close( gdir );
+
+    g_array_sort( files, remmina_rdp_bitmap_cache_file_cmp );
+    total = 0;
+    for( i = 0; i < files->len; i++ )
+    {
+        RemminaRdpBitmapCacheFile *f = &g_array_index( files, RemminaRdpBitmapCacheFile, i );
+        if( g_strcmp0( f->path, keep ) == 0 )
+            total += f->size;
+    }
+    for( i = 0; i < files->len; i++ )
+    {
+        RemminaRdpBitmapCacheFile *f = &g_array_index( files, RemminaRdpBitmapCacheFile, i );
+        if( g_strcmp0( f->path, keep ) == 0 )
+        {
+            g_free( f->path );
+            continue;
+        }
+        total += f->size;
+        if( total > limit )
+        {
+            REMMINA_PLUGIN_DEBUG( "Evicting bitmap cache %s", f->path );
+            g_unlink( f->path );
+        }
+        g_free( f->path );
+    }
+    g_array_free( files, TRUE );
+}
+#endif
+
+static void remmina_rdp_bitmap_cache_init( rfContext *rfi, RemminaFile *remminafile )
+{
+    TRACE_CALL( __func__ );
+    if( !remmina_plugin_service->file_get_int( remminafile, "bitmap-cache-persist", FALSE ) )
+        return;
+
+#ifdef WITH_FREERDP3
+    const char *server;
+    char *s, *dir, *key, *path;
+    gint size;
+    UINT32 i, ncells;
+
+    server = remmina_plugin_service->file_get_string( remminafile, "server" );
+    if( !server || !server[0] )
+        server = freerdp_settings_get_string( rfi->settings, FreeRDP_ServerHostname );
+    if( !server || !server[0] )
+        return;
+
+    size = REMMINA_RDP_BITMAP_CACHE_DEFAULT_SIZE;
+    if( ( s = remmina_plugin_service->pref_get_value( "rdp_bitmap_cache_size" ) ) != NULL )
+    {
+        if( s[0] )
+            size = atoi( s );
+        g_free( s );
+    }
+    size = remmina_plugin_service->file_get_int( remminafile, "rdp_bitmap_cache_size", size );
+    if( size <= 0 )
+        size = REMMINA_RDP_BITMAP_CACHE_DEFAULT_SIZE;
+
+    dir = g_build_path( "/", g_get_user_cache_dir(), "remmina", "rdp-bitmap-cache", NULL );
+    if( g_mkdir_with_parents( dir, 0700 ) != 0 )
+    {
+        REMMINA_PLUGIN_INFO( "Unable to create %s, the bitmap cache will not be saved", dir );
+        g_free( dir );
+        return;
+    }
+
+    /* The host is the one of the profile, not the local end of an SSH tunnel */
+    key = g_compute_checksum_for_string( G_CHECKSUM_SHA256, server, -1 );
+    s = g_strdup_printf( "%s.bmc", key );
+    path = g_build_filename( dir, s, NULL );
+    g_free( s );
+    g_free( key );
+
+    remmina_rdp_bitmap_cache_check( path );
+    /* Mark this host as the most recently used one */
+    if( g_file_test( path, G_FILE_TEST_EXISTS ) )
+        g_utime( path, NULL );
+    remmina_rdp_bitmap_cache_prune( dir, path, (goffset)size * 1024 * 1024 );
+    REMMINA_PLUGIN_DEBUG( "Persistent bitmap cache for %s is %s", server, path );
+
+    freerdp_settings_set_bool( rfi->settings, FreeRDP_BitmapCachePersistEnabled, TRUE );
+    freerdp_settings_set_string( rfi->settings, FreeRDP_BitmapCachePersistFile, path );
+    ncells = freerdp_settings_get_uint32( rfi->settings, FreeRDP_BitmapCacheV2NumCells );
+    for( i = 0; i < ncells; i++ )
+    {
+        BITMAP_CACHE_V2_CELL_INFO *cell = (BITMAP_CACHE_V2_CELL_INFO *)freerdp_settings_get_pointer_array_writable(
+            rfi->settings, FreeRDP_BitmapCacheV2CellInfo, i );
+        if( cell )
+            cell->persistent = TRUE;
+    }
+
+    g_free( path );
+    g_free( dir );
+#else
+    REMMINA_PLUGIN_INFO( "The persistent bitmap cache needs FreeRDP 3, ignoring it" );
+#endif
+}
+
 static int remmina_rdp_main( RemminaProtocolWidget *gp )
 {
     TRACE_CALL( __func__ );
@@ -1474,6 +1804,8 @@ static int remmina_rdp_main( RemminaProtocolWidget *gp )
     bool status = TRUE;
     char *rdp_kbd_remap;
     gint i;
+    const char *record_file;
+    const char *replay_file;
 
     gint desktopOrientation, desktopScaleFactor, deviceScaleFactor;
 
@@ -1497,7 +1829,33 @@ static int remmina_rdp_main( RemminaProtocolWidget *gp )
     }
 #endif
 
-    if( !remmina_rdp_tunnel_init( gp ) )
+    /* Benchmarking aids, only settable with --set-option. They use the transport dump of libfreerdp,
+     * which holds the PDUs above TLS, so a replay needs no server at all */
+    record_file = remmina_plugin_service->file_get_string( remminafile, "rdprecord" );
+    replay_file = remmina_plugin_service->file_get_string( remminafile, "rdpreplay" );
+#ifdef WITH_FREERDP3
+    if( replay_file )
+    {
+        sm = g_path_get_basename( replay_file );
+        freerdp_settings_set_string( rfi->settings, FreeRDP_ServerHostname, sm );
+        g_free( sm );
+        freerdp_settings_set_string( rfi->settings, FreeRDP_TransportDumpFile, replay_file );
+        freerdp_settings_set_bool( rfi->settings, FreeRDP_TransportDumpReplay, TRUE );
+        REMMINA_PLUGIN_INFO( "Replaying the transport dump %s", replay_file );
+    }
+    else if( record_file )
+    {
+        freerdp_settings_set_string( rfi->settings, FreeRDP_TransportDumpFile, record_file );
+        freerdp_settings_set_bool( rfi->settings, FreeRDP_TransportDump, TRUE );
+        REMMINA_PLUGIN_INFO( "Recording the transport input to %s", record_file );
+    }
+#else
+    if( replay_file || record_file )
+        REMMINA_PLUGIN_INFO( "Transport dumps need FreeRDP 3, ignoring rdprecord and rdpreplay" );
+    replay_file = NULL;
+#endif
+
+    if( !replay_file && !remmina_rdp_tunnel_init( gp ) )
         return FALSE;
 
     freerdp_settings_set_bool(
@@ -1507,6 +1865,12 @@ static int remmina_rdp_main( RemminaProtocolWidget *gp )
     /* Disable RDP auto reconnection when SSH tunnel is enabled */
     if( remmina_plugin_service->file_get_int( remminafile, "ssh_tunnel_enabled", FALSE ) )
         freerdp_settings_set_bool( rfi->settings, FreeRDP_AutoReconnectionEnabled, FALSE );
+    /* The end of a replay is the end of the session */
+    if( replay_file )
+    {
+        freerdp_settings_set_bool( rfi->settings, FreeRDP_AutoReconnectionEnabled, FALSE );
+        remmina_rdp_event_bench_start( gp );
+    }
 
     freerdp_settings_set_uint32(
         rfi->settings, FreeRDP_ColorDepth, remmina_plugin_service->file_get_int( remminafile, "colordepth", 99 ) );
@@ -1779,6 +2143,31 @@ static int remmina_rdp_main( RemminaProtocolWidget *gp )
                                  ( remmina_plugin_service->file_get_int( remminafile, "glyph-cache", 0 )
                                        ? GLYPH_SUPPORT_FULL
                                        : GLYPH_SUPPORT_NONE ) );
+    remmina_rdp_bitmap_cache_init( rfi, remminafile );
+
+    /* RemoteFX, progressive and the YUV conversion of H.264 run on WinPR thread pools, sized on the
+     * number of processors, unless threading is turned off. On a single core the pools only add overhead */
+    cs = remmina_plugin_service->file_get_string( remminafile, "codec-threads" );
+    if( cs && cs[0] )
+    {
+        rfi->parallel_decoding = g_strcmp0( cs, "single" ) != 0;
+    }
+    else
+    {
+        value = remmina_plugin_service->pref_get_value( "rdp_parallel_decoding" );
+        rfi->parallel_decoding = !( value && value[0] == '0' );
+        g_free( value );
+    }
+    if( rfi->parallel_decoding )
+        freerdp_settings_set_uint32( rfi->settings,
+                                     FreeRDP_ThreadingFlags,
+                                     freerdp_settings_get_uint32( rfi->settings, FreeRDP_ThreadingFlags )
+                                         & ~THREADING_FLAGS_DISABLE_THREADS );
+    else
+        freerdp_settings_set_uint32( rfi->settings,
+                                     FreeRDP_ThreadingFlags,
+                                     freerdp_settings_get_uint32( rfi->settings, FreeRDP_ThreadingFlags )
+                                         | THREADING_FLAGS_DISABLE_THREADS );
 
     if( ( cs = remmina_plugin_service->file_get_string( remminafile, "clientname" ) ) )
         freerdp_settings_set_string( rfi->settings, FreeRDP_ClientHostname, cs );
@@ -2919,6 +3308,8 @@ static int remmina_rdp_get_screenshot( RemminaProtocolWidget *gp, RemminaPluginS
     rfContext *rfi = GET_PLUGIN_DATA( gp );
     rdpGdi *gdi;
     size_t szmem;
+    timeval tv;
+    timespec to;
 
     UINT32 bytesPerPixel;
     UINT32 bitsPerPixel;
@@ -2926,20 +3317,34 @@ static int remmina_rdp_get_screenshot( RemminaProtocolWidget *gp, RemminaPluginS
     if( !rfi )
         return FALSE;
 
+    /* The RDP thread holds primary_mutex during a paint, and a paint may wait for
+     * the main thread (pointer updates, resize), so do not wait for it forever */
+    gettimeofday( &tv, NULL );
+    to.tv_sec = tv.tv_sec;
+    to.tv_nsec = tv.tv_usec * 1000 + 200000000; // 200ms
+    if( to.tv_nsec >= 1000000000 )
+    {
+        to.tv_nsec -= 1000000000;
+        to.tv_sec++;
+    }
+    if( pthread_mutex_timedlock( &rfi->primary_mutex, &to ) != 0 )
+    {
+        REMMINA_PLUGIN_DEBUG( "the RDP thread is busy painting, no screenshot" );
+        return FALSE;
+    }
+
     gdi = ( (rdpContext *)rfi )->gdi;
 
     bytesPerPixel = GetBytesPerPixel( gdi->hdc->format );
     bitsPerPixel = GetBitsPerPixel( gdi->hdc->format );
 
-    /** @todo we should lock FreeRDP subthread to update rfi->primary_buffer, rfi->gdi and w/h,
-	 * from here to memcpy, but… how ? */
-
     szmem = gdi->width * gdi->height * bytesPerPixel;
 
     REMMINA_PLUGIN_DEBUG( "allocating %zu bytes for a full screenshot", szmem );
     rpsd->buffer = static_cast<unsigned char *>( malloc( szmem ) );
     if( !rpsd->buffer )
     {
+        pthread_mutex_unlock( &rfi->primary_mutex );
         REMMINA_PLUGIN_DEBUG( "could not set aside %zu bytes for a full screenshot", szmem );
         return FALSE;
     }
@@ -2949,6 +3354,7 @@ static int remmina_rdp_get_screenshot( RemminaProtocolWidget *gp, RemminaPluginS
     rpsd->bytesPerPixel = bytesPerPixel;
 
     memcpy( rpsd->buffer, gdi->primary_buffer, szmem );
+    pthread_mutex_unlock( &rfi->primary_mutex );
 
     /* Returning TRUE instruct also the caller to deallocate rpsd->buffer */
     return TRUE;
@@ -3010,6 +3416,11 @@ static const char *network_list[] = { "none",
                                       N_( "LAN" ),
                                       NULL };
 
+/* Array of key/value pairs for codec threading */
+static const char *codec_threads_list[] = {
+    "", N_( "Use global setting" ), "parallel", N_( "All processor cores" ), "single", N_( "Single thread" ), NULL
+};
+
 /* Array of key/value pairs for sound options */
 static const char *sound_list[] = { "off", N_( "Off" ), "local", N_( "Local" ), "remote", N_( "Remote" ), NULL };
 
@@ -3213,6 +3624,12 @@ static const RemminaProtocolSetting remmina_rdp_advanced_settings[] = {
       FALSE,
       NULL,
       static_cast<void *>( const_cast<char *>( N_( "tag:level[,tag:level[,…]]" ) ) ) },
+    { REMMINA_PROTOCOL_SETTING_TYPE_SELECT,
+      "codec-threads",
+      N_( "Graphics decoding threads" ),
+      FALSE,
+      codec_threads_list,
+      NULL },
     { REMMINA_PROTOCOL_SETTING_TYPE_SELECT, "sound", N_( "Audio output mode" ), FALSE, sound_list, NULL },
     { REMMINA_PROTOCOL_SETTING_TYPE_TEXT,
       "audio-output",
@@ -3357,6 +3774,15 @@ static const RemminaProtocolSetting remmina_rdp_advanced_settings[] = {
       NULL },
     { REMMINA_PROTOCOL_SETTING_TYPE_CHECK, "relax-order-checks", N_( "Relax order checks" ), TRUE, NULL, NULL },
     { REMMINA_PROTOCOL_SETTING_TYPE_CHECK, "glyph-cache", N_( "Glyph cache" ), TRUE, NULL, NULL },
+#ifdef WITH_FREERDP3
+    { REMMINA_PROTOCOL_SETTING_TYPE_CHECK,
+      "bitmap-cache-persist",
+      N_( "Persistent bitmap cache" ),
+      TRUE,
+      NULL,
+      static_cast<void *>(
+          const_cast<char *>( N_( "Keep decoded bitmaps on disk to speed up the next connection to this host" ) ) ) },
+#endif
     { REMMINA_PROTOCOL_SETTING_TYPE_CHECK,
       "multitransport",
       N_( "Enable multitransport protocol (UDP)" ),
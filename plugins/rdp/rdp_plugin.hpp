@@ -103,6 +103,7 @@ struct rfContext;
 
 extern RemminaPluginService *remmina_plugin_service;
 #define REMMINA_PLUGIN_DEBUG( fmt, ... ) remmina_plugin_service->_remmina_debug( __func__, fmt, ##__VA_ARGS__ )
+#define REMMINA_PLUGIN_INFO( fmt, ... ) remmina_plugin_service->_remmina_info( "[RDP] " fmt, ##__VA_ARGS__ )
 
 struct rfClipboard
 {
@@ -242,7 +243,8 @@ enum RemminaPluginRdpUiPointerType
 enum RemminaPluginRdpUiEeventType
 {
     REMMINA_RDP_UI_EVENT_UPDATE_SCALE,
-    REMMINA_RDP_UI_EVENT_DESTROY_CAIRO_SURFACE
+    REMMINA_RDP_UI_EVENT_DESTROY_CAIRO_SURFACE,
+    REMMINA_RDP_UI_EVENT_BENCH_REPORT
 };
 
 struct region
@@ -263,6 +265,8 @@ struct RemminaPluginRdpUiObject
         {
             region *ureg;
             gint ninvalid;
+            /* When rf_end_paint() queued it, only set while benchmarking a replay */
+            gint64 queued;
         } reg;
         struct
         {
@@ -375,6 +379,36 @@ struct rfContext
     pthread_mutex_t ui_queue_mutex;
     guint ui_handler;
 
+    /* Start of the current BeginPaint/EndPaint cycle, for the performance overlay */
+    gint64 paint_start;
+    /* Session byte totals at the last EndPaint */
+    UINT64 perf_bytes_in;
+    UINT64 perf_bytes_out;
+    /* Held by the RDP thread while it writes gdi->primary_buffer or resizes it,
+     * taken by the main thread to copy the buffer for a screenshot */
+    pthread_mutex_t primary_mutex;
+    bool primary_locked;
+
+    /* Codec work of the whole session, logged when it ends. Owned by the RDP thread */
+    bool parallel_decoding;
+    gint64 session_decode_us;
+    guint64 session_frames;
+    guint64 session_pixels;
+
+    /* Transport dump replay benchmark, see remmina_rdp_event_bench_start().
+     * Decode counters belong to the RDP thread, the others to the main thread */
+    bool bench;
+    gint64 bench_start;
+    gint64 bench_heap_start;
+    guint64 bench_frames;
+    guint64 bench_pixels;
+    gint64 bench_decode_us;
+    guint64 bench_updates;
+    gint64 bench_queue_us;
+    gint64 bench_update_us;
+    guint64 bench_paints;
+    gint64 bench_paint_us;
+
     GArray *pressed_keys;
     GAsyncQueue *event_queue;
     gint event_pipe[2];
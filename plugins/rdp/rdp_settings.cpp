@@ -107,6 +107,10 @@ struct RemminaPluginRdpsetGrid
     GtkWidget *use_client_keymap_check;
     GtkWidget *disable_smooth_scrolling_check;
     GtkWidget *reconnect_attempts;
+#ifdef WITH_FREERDP3
+    GtkWidget *bitmap_cache_size;
+#endif
+    GtkWidget *parallel_decoding_check;
     GtkWidget *kbd_remap;
 
     /* FreeRDP /scale-desktop: Scaling of desktop app */
@@ -172,6 +176,15 @@ static void remmina_rdp_settings_grid_destroy( GtkWidget *widget, gpointer data
     remmina_plugin_service->pref_set_value( "rdp_reconnect_attempts",
                                             gtk_entry_get_text( GTK_ENTRY( grid->reconnect_attempts ) ) );
 
+#ifdef WITH_FREERDP3
+    remmina_plugin_service->pref_set_value( "rdp_bitmap_cache_size",
+                                            gtk_entry_get_text( GTK_ENTRY( grid->bitmap_cache_size ) ) );
+#endif
+
+    remmina_plugin_service->pref_set_value(
+        "rdp_parallel_decoding",
+        gtk_toggle_button_get_active( GTK_TOGGLE_BUTTON( grid->parallel_decoding_check ) ) ? "1" : "0" );
+
     remmina_plugin_service->pref_set_value( "rdp_kbd_remap", gtk_entry_get_text( GTK_ENTRY( grid->kbd_remap ) ) );
 
     s = g_strdup_printf( "%X", grid->quality_values[0] );
@@ -704,6 +717,45 @@ static void remmina_rdp_settings_grid_init( RemminaPluginRdpsetGrid *grid )
         gtk_entry_set_text( GTK_ENTRY( widget ), s );
     g_free( s );
     grid->reconnect_attempts = widget;
+
+#ifdef WITH_FREERDP3
+    /* The persistent bitmap cache needs FreeRDP 3, like the profile option */
+    widget = gtk_label_new( _( "Persistent bitmap cache size (MiB)" ) );
+    gtk_widget_show( widget );
+    gtk_widget_set_halign( GTK_WIDGET( widget ), GTK_ALIGN_START );
+    gtk_widget_set_valign( GTK_WIDGET( widget ), GTK_ALIGN_CENTER );
+    gtk_widget_set_margin_start( GTK_WIDGET( widget ), 6 );
+    gtk_grid_attach( GTK_GRID( grid ), widget, 1, 14, 1, 1 );
+    widget = gtk_entry_new();
+    gtk_widget_show( widget );
+    gtk_widget_set_halign( GTK_WIDGET( widget ), GTK_ALIGN_END );
+    gtk_widget_set_valign( GTK_WIDGET( widget ), GTK_ALIGN_CENTER );
+    gtk_grid_attach( GTK_GRID( grid ), widget, 2, 14, 1, 1 );
+    gtk_entry_set_input_purpose( GTK_ENTRY( widget ), GTK_INPUT_PURPOSE_NUMBER );
+    gtk_entry_set_input_hints( GTK_ENTRY( widget ), GTK_INPUT_HINT_NONE );
+    gtk_widget_set_tooltip_text(
+        widget,
+        _( "Disk space shared by the bitmap caches of all RDP hosts, the least recently used are removed first "
+           "(default: 100)" ) );
+    s = remmina_plugin_service->pref_get_value( "rdp_bitmap_cache_size" );
+    if( s && s[0] )
+        gtk_entry_set_text( GTK_ENTRY( widget ), s );
+    g_free( s );
+    grid->bitmap_cache_size = widget;
+#endif
+
+    widget = gtk_check_button_new_with_label( _( "Decode graphics on all processor cores" ) );
+    gtk_widget_show( widget );
+    gtk_widget_set_margin_start( GTK_WIDGET( widget ), 6 );
+    gtk_grid_attach( GTK_GRID( grid ), widget, 1, 15, 2, 1 );
+    gtk_widget_set_tooltip_text( widget,
+                                 _( "Decode RemoteFX, progressive and H.264 tiles and convert their colors on worker "
+                                    "threads. Turn it off on single core clients." ) );
+    grid->parallel_decoding_check = widget;
+
+    s = remmina_plugin_service->pref_get_value( "rdp_parallel_decoding" );
+    gtk_toggle_button_set_active( GTK_TOGGLE_BUTTON( widget ), s && s[0] == '0' ? FALSE : TRUE );
+    g_free( s );
 }
 
 GtkWidget *remmina_rdp_settings_new()
@@ -262,6 +262,37 @@ remmina_plugin_spice_disable_gst_overlay( SpiceChannel *channel, void *pipeline_
     return FALSE;
 }
 
+/* spice-gtk decodes internally, so for the performance overlay each invalidated
+ * area counts as one received update, together with its size and the traffic */
+static void remmina_plugin_spice_display_invalidate_cb(
+    SpiceChannel *channel, gint x, gint y, gint w, gint h, RemminaProtocolWidget *gp )
+{
+    TRACE_CALL( __func__ );
+    RemminaPluginSpiceData *gpdata = GET_PLUGIN_DATA( gp );
+    gulong read_bytes = 0;
+
+    remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_FRAME_RECEIVED, 0 );
+    remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_DAMAGE_PIXELS, (gint64)w * h );
+
+    g_object_get( channel, "total-read-bytes", &read_bytes, NULL );
+    remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_BYTES_IN, read_bytes - gpdata->perf_read_bytes );
+    gpdata->perf_read_bytes = read_bytes;
+}
+
+static gboolean remmina_plugin_spice_display_draw_cb( GtkWidget *widget, cairo_t *cr, RemminaProtocolWidget *gp )
+{
+    TRACE_CALL( __func__ );
+    remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_FRAME_PRESENTED, 0 );
+    return FALSE;
+}
+
+static gboolean remmina_plugin_spice_display_input_cb( GtkWidget *widget, GdkEvent *event, RemminaProtocolWidget *gp )
+{
+    TRACE_CALL( __func__ );
+    remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_INPUT_SENT, 0 );
+    return FALSE;
+}
+
 static void
 remmina_plugin_spice_channel_new_cb( SpiceSession *session, SpiceChannel *channel, RemminaProtocolWidget *gp )
 {
@@ -303,6 +334,14 @@ remmina_plugin_spice_channel_new_cb( SpiceSession *session, SpiceChannel *channe
         g_signal_connect( gpdata->display, "notify::ready", G_CALLBACK( remmina_plugin_spice_display_ready_cb ), gp );
         remmina_plugin_spice_display_ready_cb( G_OBJECT( gpdata->display ), NULL, gp );
 
+        g_signal_connect(
+            channel, "display-invalidate", G_CALLBACK( remmina_plugin_spice_display_invalidate_cb ), gp );
+        g_signal_connect_after( gpdata->display, "draw", G_CALLBACK( remmina_plugin_spice_display_draw_cb ), gp );
+        g_signal_connect(
+            gpdata->display, "key-press-event", G_CALLBACK( remmina_plugin_spice_display_input_cb ), gp );
+        g_signal_connect(
+            gpdata->display, "button-press-event", G_CALLBACK( remmina_plugin_spice_display_input_cb ), gp );
+
         if( remmina_plugin_service->file_get_int( remminafile, "disablegstvideooverlay", FALSE ) )
         {
             g_signal_connect(
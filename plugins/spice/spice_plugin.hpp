@@ -63,6 +63,9 @@ struct RemminaPluginSpiceData
     SpiceSession *session;
     gint fd;
 
+    /* Display channel traffic already reported to the performance overlay */
+    gulong perf_read_bytes;
+
 #ifdef SPICE_GTK_CHECK_VERSION
 #    if SPICE_GTK_CHECK_VERSION( 0, 31, 0 )
     /* key: SpiceFileTransferTask, value: RemminaPluginSpiceXferWidgets */
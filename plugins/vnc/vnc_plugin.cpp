@@ -50,8 +50,7 @@
 
 #define GET_PLUGIN_DATA( gp ) (RemminaPluginVncData *)g_object_get_data( G_OBJECT( gp ), "plugin-data" )
 
-static RemminaPluginService *remmina_plugin_service = NULL;
-#define REMMINA_PLUGIN_DEBUG( fmt, ... ) remmina_plugin_service->_remmina_debug( __func__, fmt, ##__VA_ARGS__ )
+RemminaPluginService *remmina_plugin_service = NULL;
 
 static int dot_cursor_x_hot = 2;
 static int dot_cursor_y_hot = 2;
@@ -169,12 +168,21 @@ remmina_plugin_vnc_event_push( RemminaProtocolWidget *gp, gint event_type, gpoin
         case REMMINA_PLUGIN_VNC_EVENT_CHAT_SEND:
             event->event_data.text.text = g_strdup( (char *)p1 );
             break;
+        case REMMINA_PLUGIN_VNC_EVENT_VISIBILITY:
+            event->event_data.visibility.visible = GPOINTER_TO_INT( p1 );
+            break;
+        case REMMINA_PLUGIN_VNC_EVENT_QUALITY:
+            event->event_data.quality.quality = GPOINTER_TO_INT( p1 );
+            event->event_data.quality.colordepth = GPOINTER_TO_INT( p2 );
+            break;
         default:
             break;
     }
 
     pthread_mutex_lock( &gpdata->vnc_event_queue_mutex );
     g_queue_push_tail( gpdata->vnc_event_queue, event );
+    remmina_plugin_service->protocol_plugin_perf_add(
+        gp, REMMINA_PERF_QUEUE_DEPTH, g_queue_get_length( gpdata->vnc_event_queue ) );
     pthread_mutex_unlock( &gpdata->vnc_event_queue_mutex );
 
     if( write( gpdata->vnc_event_pipe[1], "\0", 1 ) )
@@ -331,45 +339,110 @@ struct RemminaKeyVal
 
 static const uint32_t remmina_plugin_vnc_no_encrypt_auth_types[] = { rfbNoAuth, rfbVncAuth, rfbMSLogon, 0 };
 
-static RemminaPluginVncEvent *remmina_plugin_vnc_event_queue_pop_head( RemminaPluginVncData *gpdata )
+/* Move all the pending events into events, so the queue is locked once per wake up */
+static void remmina_plugin_vnc_event_queue_take( RemminaPluginVncData *gpdata, GQueue *events )
 {
-    RemminaPluginVncEvent *event;
-
     CANCEL_DEFER;
     pthread_mutex_lock( &gpdata->vnc_event_queue_mutex );
 
-    event = static_cast<RemminaPluginVncEvent *>( g_queue_pop_head( gpdata->vnc_event_queue ) );
+    *events = *gpdata->vnc_event_queue;
+    g_queue_init( gpdata->vnc_event_queue );
 
     pthread_mutex_unlock( &gpdata->vnc_event_queue_mutex );
     CANCEL_ASYNC;
+}
 
-    return event;
+/* Key and pointer messages are built here instead of with SendKeyEvent()/SendPointerEvent(),
+ * so that a whole batch of them goes to the server with a single write */
+static void remmina_plugin_vnc_input_append( rfbClient *cl, GByteArray *input, RemminaPluginVncEvent *event )
+{
+    rfbKeyEventMsg ke;
+    rfbPointerEventMsg pe;
+
+    if( event->event_type == REMMINA_PLUGIN_VNC_EVENT_KEY )
+    {
+        if( !SupportsClient2Server( cl, rfbKeyEvent ) )
+            return;
+        memset( &ke, 0, sizeof( ke ) );
+        ke.type = rfbKeyEvent;
+        ke.down = event->event_data.key.pressed ? 1 : 0;
+        ke.key = GUINT32_TO_BE( event->event_data.key.keyval );
+        g_byte_array_append( input, (const guint8 *)&ke, sz_rfbKeyEventMsg );
+    }
+    else
+    {
+        if( !SupportsClient2Server( cl, rfbPointerEvent ) )
+            return;
+        pe.type = rfbPointerEvent;
+        pe.buttonMask = event->event_data.pointer.button_mask;
+        pe.x = GUINT16_TO_BE( MAX( event->event_data.pointer.x, 0 ) );
+        pe.y = GUINT16_TO_BE( MAX( event->event_data.pointer.y, 0 ) );
+        g_byte_array_append( input, (const guint8 *)&pe, sz_rfbPointerEventMsg );
+    }
 }
 
+static void remmina_plugin_vnc_input_flush( RemminaProtocolWidget *gp, rfbClient *cl, GByteArray *input, gint *sent )
+{
+    if( input->len > 0 )
+    {
+        WriteToRFBServer( cl, (const char *)input->data, input->len );
+        g_byte_array_set_size( input, 0 );
+    }
+    if( *sent > 0 )
+    {
+        remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_INPUT_SENT, *sent );
+        *sent = 0;
+    }
+}
+
+static void remmina_plugin_vnc_update_quality( rfbClient *cl, gint quality );
+static void remmina_plugin_vnc_update_colordepth( rfbClient *cl, gint colordepth );
+
 static void remmina_plugin_vnc_process_vnc_event( RemminaProtocolWidget *gp )
 {
     TRACE_CALL( __func__ );
-    RemminaPluginVncEvent *event;
+    RemminaPluginVncEvent *event, *next;
     RemminaPluginVncData *gpdata = GET_PLUGIN_DATA( gp );
     rfbClient *cl;
+    GQueue events;
+    GByteArray *input;
+    gint sent = 0;
+    gint coalesced = 0;
+    gint last_mask = -1;
     char buf[100];
 
     cl = static_cast<rfbClient *>( gpdata->client );
-    while( ( event = static_cast<RemminaPluginVncEvent *>( remmina_plugin_vnc_event_queue_pop_head( gpdata ) ) )
-           != NULL )
+    remmina_plugin_vnc_event_queue_take( gpdata, &events );
+    input = g_byte_array_new();
+    while( ( event = static_cast<RemminaPluginVncEvent *>( g_queue_pop_head( &events ) ) ) != NULL )
     {
         if( cl )
         {
+            /* Keep the order of input and everything else */
+            if( event->event_type != REMMINA_PLUGIN_VNC_EVENT_KEY
+                && event->event_type != REMMINA_PLUGIN_VNC_EVENT_POINTER )
+                remmina_plugin_vnc_input_flush( gp, cl, input, &sent );
+
             switch( event->event_type )
             {
                 case REMMINA_PLUGIN_VNC_EVENT_KEY:
-                    SendKeyEvent( cl, event->event_data.key.keyval, event->event_data.key.pressed );
+                    remmina_plugin_vnc_input_append( cl, input, event );
+                    sent++;
                     break;
                 case REMMINA_PLUGIN_VNC_EVENT_POINTER:
-                    SendPointerEvent( cl,
-                                      event->event_data.pointer.x,
-                                      event->event_data.pointer.y,
-                                      event->event_data.pointer.button_mask );
+                    /* A motion followed by another one with the same buttons is superseded by it.
+                     * An event that changes the mask sent last is a press or a release, and always goes out. */
+                    next = static_cast<RemminaPluginVncEvent *>( g_queue_peek_head( &events ) );
+                    if( event->event_data.pointer.button_mask == last_mask && next
+                        && next->event_type == REMMINA_PLUGIN_VNC_EVENT_POINTER
+                        && next->event_data.pointer.button_mask == last_mask )
+                    {
+                        coalesced++;
+                        break;
+                    }
+                    remmina_plugin_vnc_input_append( cl, input, event );
+                    last_mask = event->event_data.pointer.button_mask;
+                    sent++;
                     break;
                 case REMMINA_PLUGIN_VNC_EVENT_CUTTEXT:
                     if( event->event_data.text.text )
@@ -388,6 +461,28 @@ static void remmina_plugin_vnc_process_vnc_event( RemminaProtocolWidget *gp )
                     TextChatClose( cl );
                     TextChatFinish( cl );
                     break;
+                case REMMINA_PLUGIN_VNC_EVENT_VISIBILITY:
+                    if( event->event_data.visibility.visible && gpdata->hidden )
+                    {
+                        /* Catch up with a single full refresh */
+                        REMMINA_PLUGIN_DEBUG( "Tab visible again, requesting a full framebuffer update" );
+                        SendFramebufferUpdateRequest( cl, 0, 0, cl->width, cl->height, FALSE );
+                    }
+                    gpdata->hidden = !event->event_data.visibility.visible;
+                    break;
+                case REMMINA_PLUGIN_VNC_EVENT_QUALITY:
+                    /* Measurements taken with other settings say nothing about the tiers */
+                    if( event->event_data.quality.quality == REMMINA_PLUGIN_VNC_QUALITY_AUTO )
+                    {
+                        gpdata->auto_votes = 0;
+                        gpdata->auto_window_start = 0;
+                        gpdata->auto_window_us = 0;
+                        gpdata->auto_window_pixels = 0;
+                    }
+                    remmina_plugin_vnc_update_quality( cl, event->event_data.quality.quality );
+                    remmina_plugin_vnc_update_colordepth( cl, event->event_data.quality.colordepth );
+                    SetFormatAndEncodings( cl );
+                    break;
                 default:
                     rfbClientLog( "Ignoring VNC event: 0x%x\n", event->event_type );
                     break;
@@ -395,6 +490,11 @@ static void remmina_plugin_vnc_process_vnc_event( RemminaProtocolWidget *gp )
         }
         remmina_plugin_vnc_event_free( event );
     }
+    if( cl )
+        remmina_plugin_vnc_input_flush( gp, cl, input, &sent );
+    g_byte_array_free( input, TRUE );
+    if( coalesced > 0 )
+        remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_INPUT_COALESCED, coalesced );
     if( read( gpdata->vnc_event_pipe[0], buf, sizeof( buf ) ) )
     {
         /* Ignore */
@@ -408,21 +508,66 @@ struct RemminaPluginVncCuttextParam
     gint textlen;
 };
 
+/* Encodings and levels the automatic quality moves between, from the largest and cheapest
+ * to decode (for fast links) to the most compressed. The first three match "Best", "Good"
+ * and "Medium". "Poor" is left out, as it changes the pixel format. */
+struct RemminaPluginVncQualityTier
+{
+    const char *encodings;
+    gint compress_level;
+    gint quality_level;
+};
+
+static const RemminaPluginVncQualityTier remmina_plugin_vnc_auto_tiers[REMMINA_PLUGIN_VNC_AUTO_TIERS] = {
+    { "copyrect zlib hextile raw", 1, 9 },
+    { "tight zrle ultra copyrect hextile zlib corre rre raw", 2, 7 },
+    { "tight zrle ultra copyrect hextile zlib corre rre raw", 3, 5 },
+    { "tight zrle ultra copyrect hextile zlib corre rre raw", 6, 2 }
+};
+
+/* Measurement window, and the minimum area it must cover to be meaningful */
+#define REMMINA_PLUGIN_VNC_AUTO_WINDOW_US ( 2 * G_USEC_PER_SEC )
+#define REMMINA_PLUGIN_VNC_AUTO_MIN_PIXELS ( 256 * 1024 )
+/* Time spent receiving and decoding updates, per pixel, above which a more compressed tier
+ * is tried and below which a larger one is */
+#define REMMINA_PLUGIN_VNC_AUTO_SLOW_NS 200
+#define REMMINA_PLUGIN_VNC_AUTO_FAST_NS 40
+/* Consecutive windows needed to move down and up */
+#define REMMINA_PLUGIN_VNC_AUTO_DOWN_VOTES 2
+#define REMMINA_PLUGIN_VNC_AUTO_UP_VOTES 4
+/* How long the cost measured on a tier is trusted when deciding to go back to it */
+#define REMMINA_PLUGIN_VNC_AUTO_MEMORY_US ( 60 * G_USEC_PER_SEC )
+
 static void remmina_plugin_vnc_update_quality( rfbClient *cl, gint quality )
 {
     TRACE_CALL( __func__ );
     RemminaProtocolWidget *gp = static_cast<RemminaProtocolWidget *>( rfbClientGetClientData( cl, NULL ) );
+    RemminaPluginVncData *gpdata = GET_PLUGIN_DATA( gp );
+    const RemminaPluginVncQualityTier *tier;
     RemminaFile *remminafile;
     char *enc = NULL;
 
     /**
+   * "-1", "Automatic"
    * "0", "Poor (fastest)
    * "1", "Medium"
    * "2", "Good"
    * "9", "Best
    */
+    gpdata->auto_quality = quality == REMMINA_PLUGIN_VNC_QUALITY_AUTO;
     switch( quality )
     {
+        case REMMINA_PLUGIN_VNC_QUALITY_AUTO:
+            tier = &remmina_plugin_vnc_auto_tiers[gpdata->auto_tier];
+            cl->appData.useBGR233 = 0;
+            /* bpp8 and tight encoding is not supported in libvnc */
+            if( cl->format.depth == 8 && g_str_has_prefix( tier->encodings, "tight " ) )
+                cl->appData.encodingsString = tier->encodings + strlen( "tight " );
+            else
+                cl->appData.encodingsString = tier->encodings;
+            cl->appData.compressLevel = tier->compress_level;
+            cl->appData.qualityLevel = tier->quality_level;
+            break;
         case 9:
             cl->appData.useBGR233 = 0;
             cl->appData.encodingsString = "copyrect zlib hextile raw";
@@ -469,6 +614,67 @@ static void remmina_plugin_vnc_update_quality( rfbClient *cl, gint quality )
     REMMINA_PLUGIN_DEBUG( "Encodings: %s", cl->appData.encodingsString );
 }
 
+static bool remmina_plugin_vnc_auto_tier_worse( RemminaPluginVncData *gpdata, gint tier, gint64 cost, gint64 now )
+{
+    return gpdata->auto_tier_time[tier] && now - gpdata->auto_tier_time[tier] < REMMINA_PLUGIN_VNC_AUTO_MEMORY_US
+           && gpdata->auto_tier_cost[tier] >= cost;
+}
+
+/* Called by the VNC thread after each framebuffer update. libvncclient does not count the
+ * bytes it reads, so the link is judged by the time spent reading and decoding the update,
+ * which includes waiting for the rest of it to arrive, per pixel of updated area. */
+static void remmina_plugin_vnc_auto_quality_sample( RemminaProtocolWidget *gp, gint64 update_us, gint64 pixels )
+{
+    TRACE_CALL( __func__ );
+    RemminaPluginVncData *gpdata = GET_PLUGIN_DATA( gp );
+    rfbClient *cl = (rfbClient *)gpdata->client;
+    gint64 now = g_get_monotonic_time();
+    gint tier = gpdata->auto_tier;
+    gint next = tier;
+    gint64 cost;
+
+    if( !gpdata->auto_quality || gpdata->replaying )
+        return;
+
+    if( !gpdata->auto_window_start )
+        gpdata->auto_window_start = now;
+    gpdata->auto_window_us += update_us;
+    gpdata->auto_window_pixels += pixels;
+    if( now - gpdata->auto_window_start < REMMINA_PLUGIN_VNC_AUTO_WINDOW_US
+        || gpdata->auto_window_pixels < REMMINA_PLUGIN_VNC_AUTO_MIN_PIXELS )
+        return;
+
+    cost = gpdata->auto_window_us * 1000 / gpdata->auto_window_pixels;
+    gpdata->auto_tier_cost[tier] = cost;
+    gpdata->auto_tier_time[tier] = now;
+    gpdata->auto_window_start = 0;
+    gpdata->auto_window_us = 0;
+    gpdata->auto_window_pixels = 0;
+
+    /* Do not go back to a tier that was recently measured as slower than this one */
+    if( cost > REMMINA_PLUGIN_VNC_AUTO_SLOW_NS && tier < REMMINA_PLUGIN_VNC_AUTO_TIERS - 1
+        && !remmina_plugin_vnc_auto_tier_worse( gpdata, tier + 1, cost, now ) )
+        gpdata->auto_votes = MIN( gpdata->auto_votes, 0 ) - 1;
+    else if( cost < REMMINA_PLUGIN_VNC_AUTO_FAST_NS && tier > 0
+             && !remmina_plugin_vnc_auto_tier_worse( gpdata, tier - 1, REMMINA_PLUGIN_VNC_AUTO_SLOW_NS, now ) )
+        gpdata->auto_votes = MAX( gpdata->auto_votes, 0 ) + 1;
+    else
+        gpdata->auto_votes = 0;
+
+    if( gpdata->auto_votes <= -REMMINA_PLUGIN_VNC_AUTO_DOWN_VOTES )
+        next = tier + 1;
+    else if( gpdata->auto_votes >= REMMINA_PLUGIN_VNC_AUTO_UP_VOTES )
+        next = tier - 1;
+    if( next == tier )
+        return;
+
+    REMMINA_PLUGIN_DEBUG( "Automatic quality: %" G_GINT64_FORMAT " ns/pixel, tier %d -> %d", cost, tier, next );
+    gpdata->auto_tier = next;
+    gpdata->auto_votes = 0;
+    remmina_plugin_vnc_update_quality( cl, REMMINA_PLUGIN_VNC_QUALITY_AUTO );
+    SetFormatAndEncodings( cl );
+}
+
 static void remmina_plugin_vnc_update_colordepth( rfbClient *cl, gint colordepth )
 {
     TRACE_CALL( __func__ );
@@ -755,11 +961,13 @@ static void remmina_plugin_vnc_rfb_updatefb( rfbClient *cl, int x, int y, int w,
     gint bytesPerPixel;
     gint rowstride;
     gint width;
+    gint64 start, convert_us;
 
     LOCK_BUFFER( TRUE );
 
     if( w >= 1 || h >= 1 )
     {
+        start = g_get_monotonic_time();
         width = remmina_plugin_service->protocol_plugin_get_width( gp );
         bytesPerPixel = cl->format.bitsPerPixel / 8;
         rowstride = cairo_image_surface_get_stride( gpdata->rgb_buffer );
@@ -773,6 +981,15 @@ static void remmina_plugin_vnc_rfb_updatefb( rfbClient *cl, int x, int y, int w,
                                             w,
                                             h );
         cairo_surface_mark_dirty( gpdata->rgb_buffer );
+
+        convert_us = g_get_monotonic_time() - start;
+        gpdata->perf_convert_us += convert_us;
+        gpdata->perf_pixels += (gint64)w * h;
+        gpdata->perf_updated = TRUE;
+        remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_CONVERT_US, convert_us );
+        remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_DAMAGE_PIXELS, (gint64)w * h );
+        if( gpdata->replaying )
+            gpdata->bench_pixels += (guint64)w * h;
     }
 
     if( ( remmina_plugin_service->remmina_protocol_widget_get_current_scale_mode( gp )
@@ -1004,6 +1221,27 @@ static rfbCredential *remmina_plugin_vnc_rfb_credential( rfbClient *cl, int cred
     return cred;
 }
 
+/* A replayed server accepts whatever the client answers, so never ask the user.
+ * libvncclient refuses empty passwords, hence the placeholder */
+static char *remmina_plugin_vnc_rfb_replay_password( rfbClient *cl )
+{
+    TRACE_CALL( __func__ );
+    return g_strdup( "replay" );
+}
+
+static rfbCredential *remmina_plugin_vnc_rfb_replay_credential( rfbClient *cl, int credentialType )
+{
+    TRACE_CALL( __func__ );
+    rfbCredential *cred;
+
+    if( credentialType != rfbCredentialTypeUser )
+        return NULL;
+    cred = g_new0( rfbCredential, 1 );
+    cred->userCredential.username = g_strdup( "replay" );
+    cred->userCredential.password = g_strdup( "replay" );
+    return cred;
+}
+
 static void
 remmina_plugin_vnc_rfb_cursor_shape( rfbClient *cl, int xhot, int yhot, int width, int height, int bytesPerPixel )
 {
@@ -1243,6 +1481,99 @@ static int remmina_plugin_vnc_incoming_connection( RemminaProtocolWidget *gp, rf
     return TRUE;
 }
 
+/* Feed the recording named by "rfbreplay" to libvncclient instead of a server connection */
+static bool remmina_plugin_vnc_replay_connect( RemminaProtocolWidget *gp, rfbClient *cl, const char *filename )
+{
+    TRACE_CALL( __func__ );
+    RemminaPluginVncData *gpdata = GET_PLUGIN_DATA( gp );
+    RemminaFile *remminafile = remmina_plugin_service->protocol_plugin_get_file( gp );
+    bool realtime = remmina_plugin_service->file_get_int( remminafile, "rfbreplay_realtime", FALSE );
+    char *error = NULL;
+
+    cl->sock = remmina_vnc_replay_start( &gpdata->record, filename, realtime, &error );
+    if( cl->sock < 0 )
+    {
+        remmina_plugin_service->protocol_plugin_set_error( gp, _( "Unable to replay %s" ), error );
+        g_free( error );
+        return FALSE;
+    }
+    if( !SetNonBlocking( cl->sock ) )
+        return FALSE;
+
+    /* Skip the TCP connection in rfbInitClient(), as for incoming connections */
+    cl->listenSpecified = TRUE;
+    cl->serverHost = g_strdup( "" );
+    cl->GetPassword = remmina_plugin_vnc_rfb_replay_password;
+    cl->GetCredential = remmina_plugin_vnc_rfb_replay_credential;
+
+    gpdata->replaying = TRUE;
+    gpdata->bench_start = g_get_monotonic_time();
+    REMMINA_PLUGIN_INFO( "Replaying %s %s", filename, realtime ? "in real time" : "at full speed" );
+    return TRUE;
+}
+
+/* Connect through a recorder which saves the server stream into the file named by "rfbrecord".
+ * When the recorder cannot be started, libvncclient connects as usual */
+static void remmina_plugin_vnc_record_connect( RemminaProtocolWidget *gp, rfbClient *cl, const char *filename )
+{
+    TRACE_CALL( __func__ );
+    RemminaPluginVncData *gpdata = GET_PLUGIN_DATA( gp );
+    char *error = NULL;
+    gint sock;
+
+    sock = remmina_vnc_record_start( &gpdata->record, cl->serverHost, cl->serverPort, filename, &error );
+    if( sock < 0 )
+    {
+        REMMINA_PLUGIN_INFO( "RFB recording disabled: %s", error );
+        g_free( error );
+        return;
+    }
+    if( !SetNonBlocking( sock ) )
+    {
+        close( sock );
+        remmina_vnc_record_stop( gpdata->record );
+        gpdata->record = NULL;
+        return;
+    }
+    cl->sock = sock;
+    cl->listenSpecified = TRUE;
+    REMMINA_PLUGIN_INFO( "Recording the RFB stream of %s:%d to %s", cl->serverHost, cl->serverPort, filename );
+}
+
+static void remmina_plugin_vnc_replay_report( RemminaProtocolWidget *gp )
+{
+    TRACE_CALL( __func__ );
+    RemminaPluginVncData *gpdata = GET_PLUGIN_DATA( gp );
+    gint64 elapsed = MAX( g_get_monotonic_time() - gpdata->bench_start, 1 );
+    guint64 bytes = remmina_vnc_record_get_bytes( gpdata->record );
+    guint64 updates = MAX( gpdata->bench_updates, 1 );
+    guint64 draws;
+    gint64 draw_us;
+
+    LOCK_BUFFER( TRUE );
+    draws = gpdata->bench_draws;
+    draw_us = gpdata->bench_draw_us;
+    UNLOCK_BUFFER( TRUE );
+
+    REMMINA_PLUGIN_INFO( "RFB replay: %.3f s, %.2f MB, %" G_GUINT64_FORMAT " updates (%.1f/s)",
+                         elapsed / 1e6,
+                         bytes / 1e6,
+                         gpdata->bench_updates,
+                         gpdata->bench_updates * 1e6 / elapsed );
+    REMMINA_PLUGIN_INFO( "  decode:  %.1f ms, %.1f us/update, %.2f MB/s",
+                         gpdata->bench_decode_us / 1e3,
+                         (double)gpdata->bench_decode_us / updates,
+                         bytes / (double)MAX( gpdata->bench_decode_us, 1 ) );
+    REMMINA_PLUGIN_INFO( "  convert: %.1f ms, %.1f us/update, %.2f Mpixel/s",
+                         gpdata->bench_convert_us / 1e3,
+                         (double)gpdata->bench_convert_us / updates,
+                         gpdata->bench_pixels / (double)MAX( gpdata->bench_convert_us, 1 ) );
+    REMMINA_PLUGIN_INFO( "  draw:    %.1f ms, %" G_GUINT64_FORMAT " draws, %.1f us/draw",
+                         draw_us / 1e3,
+                         draws,
+                         (double)draw_us / MAX( draws, 1 ) );
+}
+
 static int remmina_plugin_vnc_main_loop( RemminaProtocolWidget *gp )
 {
     TRACE_CALL( __func__ );
@@ -1252,6 +1583,7 @@ static int remmina_plugin_vnc_main_loop( RemminaProtocolWidget *gp )
     rfbClient *cl;
     fd_set fds;
      timeval timeout;
+    gint64 start;
 
     if( !gpdata->connected )
     {
@@ -1269,13 +1601,16 @@ static int remmina_plugin_vnc_main_loop( RemminaProtocolWidget *gp )
    * -
    * https://github.com/apache/guacamole-server/blob/67680bd2d51e7949453f0f7ffc7f4234a1136715/src/protocols/vnc/vnc.cpp#L155
    */
-    if( cl->buffered )
+    if( cl->buffered && !gpdata->hidden )
         goto handle_buffered;
 
     timeout.tv_sec = 10;
     timeout.tv_usec = 0;
     FD_ZERO( &fds );
-    FD_SET( cl->sock, &fds );
+    /* While the tab is hidden the server socket is not read: libvncclient sends the next
+     * FramebufferUpdateRequest only after handling an update, so the server stops sending */
+    if( !gpdata->hidden )
+        FD_SET( cl->sock, &fds );
     FD_SET( gpdata->vnc_event_pipe[0], &fds );
     ret = select( MAX( cl->sock, gpdata->vnc_event_pipe[0] ) + 1, &fds, NULL, NULL, &timeout );
 
@@ -1293,13 +1628,34 @@ static int remmina_plugin_vnc_main_loop( RemminaProtocolWidget *gp )
         if( i < 0 )
             return TRUE;
     handle_buffered:
+        gpdata->perf_updated = FALSE;
+        gpdata->perf_convert_us = 0;
+        gpdata->perf_pixels = 0;
+        start = g_get_monotonic_time();
         if( !HandleRFBServerMessage( cl ) )
         {
+            if( gpdata->replaying )
+                remmina_plugin_vnc_replay_report( gp );
             gpdata->running = FALSE;
             if( gpdata->connected && !remmina_plugin_service->protocol_plugin_is_closed( gp ) )
                 remmina_plugin_service->protocol_plugin_signal_connection_closed( gp );
             return FALSE;
         }
+        if( gpdata->perf_updated )
+        {
+            /* Decoding includes reading the rest of the update from the socket,
+             * the conversion to the cairo surface is reported on its own */
+            remmina_plugin_service->protocol_plugin_perf_add(
+                gp, REMMINA_PERF_DECODE_US, g_get_monotonic_time() - start - gpdata->perf_convert_us );
+            remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_FRAME_RECEIVED, 0 );
+            if( gpdata->replaying )
+            {
+                gpdata->bench_updates++;
+                gpdata->bench_decode_us += g_get_monotonic_time() - start - gpdata->perf_convert_us;
+                gpdata->bench_convert_us += gpdata->perf_convert_us;
+            }
+            remmina_plugin_vnc_auto_quality_sample( gp, g_get_monotonic_time() - start, gpdata->perf_pixels );
+        }
     }
 
     return TRUE;
@@ -1311,8 +1667,11 @@ static int remmina_plugin_vnc_main( RemminaProtocolWidget *gp )
     RemminaPluginVncData *gpdata = GET_PLUGIN_DATA( gp );
     RemminaFile *remminafile;
     rfbClient *cl = NULL;
-    char *host;
+    char *host = NULL;
     char *s = NULL;
+    const char *replay_file;
+    const char *record_file;
+    gint tunnel_sock = -1;
 
     remminafile = remmina_plugin_service->protocol_plugin_get_file( gp );
     gpdata->running = TRUE;
@@ -1322,13 +1681,27 @@ static int remmina_plugin_vnc_main( RemminaProtocolWidget *gp )
     gint colordepth = remmina_plugin_service->file_get_int( remminafile, "colordepth", 32 );
     gint quality = remmina_plugin_service->file_get_int( remminafile, "quality", 9 );
 
+    /* Benchmarking aids, only settable with --set-option: a replay needs no server at all */
+    replay_file = remmina_plugin_service->file_get_string( remminafile, "rfbreplay" );
+    record_file = remmina_plugin_service->file_get_string( remminafile, "rfbrecord" );
+
     while( gpdata->connected )
     {
         gpdata->auth_called = FALSE;
+        remmina_vnc_record_stop( gpdata->record );
+        gpdata->record = NULL;
 
-        host = remmina_plugin_service->protocol_plugin_start_direct_tunnel( gp, 5900, TRUE );
+        tunnel_sock = -1;
+        if( !replay_file
+            && !remmina_plugin_service->protocol_plugin_start_direct_tunnel_socket( gp, 5900, TRUE, &tunnel_sock ) )
+        {
+            gpdata->connected = FALSE;
+            break;
+        }
+        if( !replay_file && tunnel_sock < 0 )
+            host = remmina_plugin_service->protocol_plugin_start_direct_tunnel( gp, 5900, TRUE );
 
-        if( host == NULL )
+        if( host == NULL && !replay_file && tunnel_sock < 0 )
         {
             REMMINA_PLUGIN_DEBUG( "host is null" );
             gpdata->connected = FALSE;
@@ -1383,7 +1756,25 @@ static int remmina_plugin_vnc_main( RemminaProtocolWidget *gp )
 
         rfbClientSetClientData( cl, NULL, gp );
 
-        if( host[0] == '\0' )
+        if( replay_file )
+        {
+            if( !remmina_plugin_vnc_replay_connect( gp, cl, replay_file ) )
+            {
+                rfbClientCleanup( cl );
+                cl = NULL;
+                gpdata->connected = FALSE;
+                break;
+            }
+        }
+        else if( tunnel_sock >= 0 )
+        {
+            /* The SSH tunnel handed one end of a socket pair over, skip the TCP connection */
+            SetNonBlocking( tunnel_sock );
+            cl->sock = tunnel_sock;
+            cl->listenSpecified = TRUE;
+            cl->serverHost = g_strdup( "" );
+        }
+        else if( host[0] == '\0' )
         {
             cl->serverHost = g_strdup( host );
             cl->listenSpecified = TRUE;
@@ -1410,7 +1801,7 @@ static int remmina_plugin_vnc_main( RemminaProtocolWidget *gp )
         g_free( host );
         host = NULL;
 
-        if( remmina_plugin_service->file_get_string( remminafile, "proxy" ) )
+        if( remmina_plugin_service->file_get_string( remminafile, "proxy" ) && !replay_file && tunnel_sock < 0 )
         {
             remmina_plugin_service->get_server_port(
                 remmina_plugin_service->file_get_string( remminafile, "server" ), 5900, &cl->destHost, &cl->destPort );
@@ -1423,6 +1814,10 @@ static int remmina_plugin_vnc_main( RemminaProtocolWidget *gp )
             REMMINA_PLUGIN_DEBUG( "cl->destHost: %s", cl->destHost );
             REMMINA_PLUGIN_DEBUG( "cl->destPort: %d", cl->destPort );
         }
+        else if( record_file && !replay_file && !cl->listenSpecified )
+        {
+            remmina_plugin_vnc_record_connect( gp, cl, record_file );
+        }
 
         cl->appData.useRemoteCursor =
             ( remmina_plugin_service->file_get_int( remminafile, "showcursor", FALSE ) ? FALSE : TRUE );
@@ -1437,6 +1832,8 @@ static int remmina_plugin_vnc_main( RemminaProtocolWidget *gp )
             cl->appData.encodingsString = "zrle ultra copyrect hextile zlib corre rre raw";
         else if( ( cl->format.depth == 8 ) && ( quality == 0 ) )
             cl->appData.encodingsString = "zrle ultra copyrect hextile zlib corre rre raw";
+        else if( ( cl->format.depth == 8 ) && ( quality == REMMINA_PLUGIN_VNC_QUALITY_AUTO ) )
+            remmina_plugin_vnc_update_quality( cl, quality );
         SetFormatAndEncodings( cl );
 
         if( remmina_plugin_service->file_get_int( remminafile, "disableencryption", FALSE ) )
@@ -1494,6 +1891,8 @@ static int remmina_plugin_vnc_main( RemminaProtocolWidget *gp )
     if( !gpdata->connected )
     {
         REMMINA_PLUGIN_DEBUG( "Client not connected with error: %s", vnc_error );
+        remmina_vnc_record_stop( gpdata->record );
+        gpdata->record = NULL;
         if( cl && !gpdata->auth_called && !( remmina_plugin_service->protocol_plugin_has_error( gp ) ) )
             remmina_plugin_service->protocol_plugin_set_error( gp, "%s", vnc_error );
         gpdata->running = FALSE;
@@ -1940,6 +2339,8 @@ static int remmina_plugin_vnc_close_connection_timeout( RemminaProtocolWidget *g
         rfbClientCleanup( (rfbClient *)gpdata->client );
         gpdata->client = NULL;
     }
+    remmina_vnc_record_stop( gpdata->record );
+    gpdata->record = NULL;
     if( gpdata->rgb_buffer )
     {
         cairo_surface_destroy( gpdata->rgb_buffer );
@@ -2013,12 +2414,13 @@ static void remmina_plugin_vnc_call_feature( RemminaProtocolWidget *gp, const Re
     switch( feature->id )
     {
         case REMMINA_PLUGIN_VNC_FEATURE_PREF_QUALITY:
-            remmina_plugin_vnc_update_quality( (rfbClient *)( gpdata->client ),
-                                               remmina_plugin_service->file_get_int( remminafile, "quality", 9 ) );
-            remmina_plugin_vnc_update_colordepth(
-                (rfbClient *)( gpdata->client ),
-                remmina_plugin_service->file_get_int( remminafile, "colordepth", 32 ) );
-            SetFormatAndEncodings( (rfbClient *)( gpdata->client ) );
+            /* The automatic quality state belongs to the VNC thread */
+            remmina_plugin_vnc_event_push(
+                gp,
+                REMMINA_PLUGIN_VNC_EVENT_QUALITY,
+                GINT_TO_POINTER( remmina_plugin_service->file_get_int( remminafile, "quality", 9 ) ),
+                GINT_TO_POINTER( remmina_plugin_service->file_get_int( remminafile, "colordepth", 32 ) ),
+                NULL );
             break;
         case REMMINA_PLUGIN_VNC_FEATURE_PREF_VIEWONLY:
             break;
@@ -2063,6 +2465,32 @@ static void remmina_plugin_vnc_keystroke( RemminaProtocolWidget *gp, const guint
     return;
 }
 
+/* The tab became visible: resume framebuffer updates */
+static int remmina_plugin_vnc_on_map( RemminaProtocolWidget *gp )
+{
+    TRACE_CALL( __func__ );
+    RemminaPluginVncData *gpdata = GET_PLUGIN_DATA( gp );
+
+    if( !gpdata || !gpdata->connected )
+        return FALSE;
+
+    remmina_plugin_vnc_event_push( gp, REMMINA_PLUGIN_VNC_EVENT_VISIBILITY, GINT_TO_POINTER( TRUE ), NULL, NULL );
+    return TRUE;
+}
+
+/* The tab is no longer visible: pause framebuffer updates */
+static int remmina_plugin_vnc_on_unmap( RemminaProtocolWidget *gp )
+{
+    TRACE_CALL( __func__ );
+    RemminaPluginVncData *gpdata = GET_PLUGIN_DATA( gp );
+
+    if( !gpdata || !gpdata->connected )
+        return FALSE;
+
+    remmina_plugin_vnc_event_push( gp, REMMINA_PLUGIN_VNC_EVENT_VISIBILITY, GINT_TO_POINTER( FALSE ), NULL, NULL );
+    return TRUE;
+}
+
 static int remmina_plugin_vnc_on_draw( GtkWidget *widget, cairo_t *context, RemminaProtocolWidget *gp )
 {
     TRACE_CALL( __func__ );
@@ -2070,6 +2498,7 @@ static int remmina_plugin_vnc_on_draw( GtkWidget *widget, cairo_t *context, Remm
     cairo_surface_t *surface;
     gint width, height;
     GtkAllocation widget_allocation;
+    gint64 start;
 
     LOCK_BUFFER( FALSE );
 
@@ -2090,11 +2519,18 @@ static int remmina_plugin_vnc_on_draw( GtkWidget *widget, cairo_t *context, Remm
         cairo_scale( context, (double)widget_allocation.width / width, (double)widget_allocation.height / height );
     }
 
+    start = g_get_monotonic_time();
     cairo_rectangle( context, 0, 0, width, height );
     cairo_set_source_surface( context, surface, 0, 0 );
     cairo_fill( context );
+    if( gpdata->replaying )
+    {
+        gpdata->bench_draws++;
+        gpdata->bench_draw_us += g_get_monotonic_time() - start;
+    }
 
     UNLOCK_BUFFER( FALSE );
+    remmina_plugin_service->protocol_plugin_perf_add( gp, REMMINA_PERF_FRAME_PRESENTED, 0 );
     return TRUE;
 }
 
@@ -2106,6 +2542,8 @@ static void remmina_plugin_vnc_init( RemminaProtocolWidget *gp )
 
     gpdata = g_new0( RemminaPluginVncData, 1 );
     g_object_set_data_full( G_OBJECT( gp ), "plugin-data", gpdata, g_free );
+    /* Automatic quality starts from "Good" */
+    gpdata->auto_tier = 1;
 
     bool disable_smooth_scrolling = FALSE;
     RemminaFile *remminafile = remmina_plugin_service->protocol_plugin_get_file( gp );
@@ -2154,7 +2592,8 @@ static const char *colordepth_list[] =
 
 /* Array of key/value pairs for quality selection */
 static const char *quality_list[] =
-    { "2", N_( "Good" ), "9", N_( "Best (slowest)" ), "1", N_( "Medium" ), "0", N_( "Poor (fastest)" ), NULL };
+    { "2", N_( "Good" ), "9", N_( "Best (slowest)" ), "1", N_( "Medium" ), "0", N_( "Poor (fastest)" ),
+      "-1", N_( "Automatic" ), NULL };
 
 static const char repeater_tooltip[] = N_( "Connect to VNC using a repeater:\n"
                                            "  • The server field must contain the repeater ID, e.g. ID:123456789\n"
@@ -2360,7 +2799,10 @@ static RemminaProtocolPlugin remmina_plugin_vnc = {
     remmina_plugin_vnc_close_connection,  // Plugin close connection
     remmina_plugin_vnc_query_feature,     // Query for available features
     remmina_plugin_vnc_call_feature,      // Call a feature
-    remmina_plugin_vnc_keystroke          // Send a keystroke
+    remmina_plugin_vnc_keystroke,         // Send a keystroke
+    NULL,                                 // No screenshot support available
+    remmina_plugin_vnc_on_map,            // RCW map event
+    remmina_plugin_vnc_on_unmap           // RCW unmap event
 };
 
 /* Protocol plugin definition and features */
@@ -2383,8 +2825,8 @@ static RemminaProtocolPlugin remmina_plugin_vnci = {
     remmina_plugin_vnc_call_feature,             // Call a feature
     remmina_plugin_vnc_keystroke,                // Send a keystroke
     NULL,                                        // No screenshot support available
-    NULL,                                        // RCW map event
-    NULL                                         // RCW unmap event
+    remmina_plugin_vnc_on_map,                   // RCW map event
+    remmina_plugin_vnc_on_unmap                  // RCW unmap event
 };
 
 extern "C"
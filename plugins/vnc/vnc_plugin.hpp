@@ -50,7 +50,17 @@
 #endif
 
 #include <gtk/gtk.h>
+#include "common/remmina_plugin.hpp"
 #include "remmina/types.hpp"
+#include "vnc_record.hpp"
+
+extern RemminaPluginService *remmina_plugin_service;
+#define REMMINA_PLUGIN_DEBUG( fmt, ... ) remmina_plugin_service->_remmina_debug( __func__, fmt, ##__VA_ARGS__ )
+#define REMMINA_PLUGIN_INFO( fmt, ... ) remmina_plugin_service->_remmina_info( "[VNC] " fmt, ##__VA_ARGS__ )
+#define REMMINA_PLUGIN_WARNING( fmt, ... ) remmina_plugin_service->_remmina_warning( __func__, fmt, ##__VA_ARGS__ )
+
+#define REMMINA_PLUGIN_VNC_QUALITY_AUTO -1
+#define REMMINA_PLUGIN_VNC_AUTO_TIERS 4
 
 struct RemminaPluginVncData
 {
@@ -92,6 +102,40 @@ struct RemminaPluginVncData
     pthread_mutex_t buffer_mutex;
 
     float scroll_x_accumulator, scroll_y_accumulator;
+
+    /* Tab is not visible: stop reading updates, so no new FramebufferUpdateRequest
+     * is sent. Only accessed by the VNC thread. */
+    bool hidden;
+
+    /* Performance overlay bookkeeping for the server message being handled,
+     * only accessed by the VNC thread */
+    bool perf_updated;
+    gint64 perf_convert_us;
+    gint64 perf_pixels;
+
+    /* Automatic quality ("quality" set to REMMINA_PLUGIN_VNC_QUALITY_AUTO): the tier in use and
+     * the measurements it is chosen from, only accessed by the VNC thread */
+    bool auto_quality;
+    gint auto_tier;
+    gint auto_votes;
+    gint64 auto_window_start;
+    gint64 auto_window_us;
+    gint64 auto_window_pixels;
+    gint64 auto_tier_cost[REMMINA_PLUGIN_VNC_AUTO_TIERS];
+    gint64 auto_tier_time[REMMINA_PLUGIN_VNC_AUTO_TIERS];
+
+    /* RFB capture or replay, enabled by the hidden "rfbrecord" and "rfbreplay" profile settings */
+    RemminaVncRecord *record;
+    bool replaying;
+    /* Replay benchmark totals. Draw times are protected by buffer_mutex,
+     * the rest is only accessed by the VNC thread */
+    gint64 bench_start;
+    guint64 bench_updates;
+    guint64 bench_pixels;
+    gint64 bench_decode_us;
+    gint64 bench_convert_us;
+    guint64 bench_draws;
+    gint64 bench_draw_us;
 };
 
 enum
@@ -101,7 +145,9 @@ enum
     REMMINA_PLUGIN_VNC_EVENT_CUTTEXT,
     REMMINA_PLUGIN_VNC_EVENT_CHAT_OPEN,
     REMMINA_PLUGIN_VNC_EVENT_CHAT_SEND,
-    REMMINA_PLUGIN_VNC_EVENT_CHAT_CLOSE
+    REMMINA_PLUGIN_VNC_EVENT_CHAT_CLOSE,
+    REMMINA_PLUGIN_VNC_EVENT_VISIBILITY,
+    REMMINA_PLUGIN_VNC_EVENT_QUALITY
 };
 
 struct RemminaPluginVncEvent
@@ -124,6 +170,15 @@ struct RemminaPluginVncEvent
         {
             char *text;
         } text;
+        struct
+        {
+            bool visible;
+        } visibility;
+        struct
+        {
+            gint quality;
+            gint colordepth;
+        } quality;
     } event_data;
 };
 
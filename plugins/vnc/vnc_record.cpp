@@ -0,0 +1,445 @@
+/*
+ * Remmina - The GTK+ Remote Desktop Client
+ * Copyright (C) 2016-2022 Antenore Gatta, Giovanni Panozzo
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ *
+ *  In addition, as a special exception, the copyright holders give
+ *  permission to link the code of portions of this program with the
+ *  OpenSSL library under certain conditions as described in each
+ *  individual source file, and distribute linked combinations
+ *  including the two.
+ *  You must obey the GNU General Public License in all respects
+ *  for all of the code used other than OpenSSL. *  If you modify
+ *  file(s) with this exception, you may extend this exception to your
+ *  version of the file(s), but you are not obligated to do so. *  If you
+ *  do not wish to do so, delete this exception statement from your
+ *  version. *  If you delete this exception statement from all source
+ *  files in the program, then also delete it here.
+ *
+ */
+
+
+#include "common/remmina_plugin.hpp"
+#include <poll.h>
+#include <stdio.h>
+#include "vnc_plugin.hpp"
+
+#define VNC_RECORD_MAGIC "RMNARFB1"
+#define VNC_RECORD_MAGIC_LEN 8
+#define VNC_RECORD_CHUNK 65536
+/* A single recorded read is never larger than the chunk size, anything above this is a corrupt file */
+#define VNC_RECORD_MAX_CHUNK ( 16 * 1024 * 1024 )
+
+struct RemminaVncRecord
+{
+    bool replay;
+    bool realtime;
+
+    /* Server connection, only used when recording */
+    gint peer;
+    /* Our end of the socketpair, the other one belongs to libvncclient */
+    gint fd;
+    /* Written to by remmina_vnc_record_stop() to wake up the pump thread */
+    gint wake[2];
+
+    FILE *fp;
+    gint64 start;
+
+    pthread_mutex_t mutex;
+    guint64 bytes;
+
+    pthread_t thread;
+};
+
+/* Write the whole buffer, waiting on POLLOUT. Returns FALSE on error or when woken up */
+static bool remmina_vnc_record_write_all( RemminaVncRecord *rec, gint fd, const guchar *data, gsize len )
+{
+    TRACE_CALL( __func__ );
+    struct pollfd pfd[2];
+    ssize_t n;
+
+    while( len > 0 )
+    {
+        n = send( fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT );
+        if( n > 0 )
+        {
+            data += n;
+            len -= n;
+            continue;
+        }
+        if( n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+            return FALSE;
+
+        pfd[0].fd = fd;
+        pfd[0].events = POLLOUT;
+        pfd[1].fd = rec->wake[0];
+        pfd[1].events = POLLIN;
+        if( poll( pfd, 2, -1 ) < 0 && errno != EINTR )
+            return FALSE;
+        if( pfd[1].revents )
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Throw away whatever the client sent. Returns FALSE when the client went away */
+static bool remmina_vnc_record_drain( gint fd )
+{
+    TRACE_CALL( __func__ );
+    guchar buf[4096];
+    ssize_t n;
+
+    n = recv( fd, buf, sizeof( buf ), MSG_DONTWAIT );
+    return n > 0 || ( n < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ) );
+}
+
+static void remmina_vnc_record_add_bytes( RemminaVncRecord *rec, gsize len )
+{
+    pthread_mutex_lock( &rec->mutex );
+    rec->bytes += len;
+    pthread_mutex_unlock( &rec->mutex );
+}
+
+static void *remmina_vnc_record_thread( void *data )
+{
+    TRACE_CALL( __func__ );
+    RemminaVncRecord *rec = (RemminaVncRecord *)data;
+    struct pollfd pfd[3];
+    guchar *buf;
+    guint64 ts;
+    guint32 len;
+    ssize_t n;
+    bool write_failed = FALSE;
+
+    buf = (guchar *)g_malloc( VNC_RECORD_CHUNK );
+    for( ;; )
+    {
+        pfd[0].fd = rec->wake[0];
+        pfd[0].events = POLLIN;
+        pfd[1].fd = rec->fd;
+        pfd[1].events = POLLIN;
+        pfd[2].fd = rec->peer;
+        pfd[2].events = POLLIN;
+        if( poll( pfd, 3, -1 ) < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            break;
+        }
+        if( pfd[0].revents )
+            break;
+
+        if( pfd[2].revents )
+        {
+            n = recv( rec->peer, buf, VNC_RECORD_CHUNK, MSG_DONTWAIT );
+            if( n == 0 || ( n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR ) )
+            {
+                /* Server closed, let the client see it */
+                shutdown( rec->fd, SHUT_WR );
+                break;
+            }
+            if( n > 0 )
+            {
+                ts = GUINT64_TO_BE( (guint64)( g_get_monotonic_time() - rec->start ) );
+                len = GUINT32_TO_BE( (guint32)n );
+                if( !write_failed
+                    && ( fwrite( &ts, sizeof( ts ), 1, rec->fp ) != 1 || fwrite( &len, sizeof( len ), 1, rec->fp ) != 1
+                         || fwrite( buf, 1, n, rec->fp ) != (size_t)n ) )
+                {
+                    /* Keep the session going, the recording is truncated */
+                    REMMINA_PLUGIN_WARNING( "Unable to write the RFB recording: %s", g_strerror( errno ) );
+                    write_failed = TRUE;
+                }
+                remmina_vnc_record_add_bytes( rec, n );
+                if( !remmina_vnc_record_write_all( rec, rec->fd, buf, n ) )
+                    break;
+            }
+        }
+
+        if( pfd[1].revents )
+        {
+            n = recv( rec->fd, buf, VNC_RECORD_CHUNK, MSG_DONTWAIT );
+            if( n == 0 || ( n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR ) )
+            {
+                shutdown( rec->peer, SHUT_WR );
+                break;
+            }
+            if( n > 0 && !remmina_vnc_record_write_all( rec, rec->peer, buf, n ) )
+                break;
+        }
+    }
+    g_free( buf );
+    fflush( rec->fp );
+    return NULL;
+}
+
+static void *remmina_vnc_replay_thread( void *data )
+{
+    TRACE_CALL( __func__ );
+    RemminaVncRecord *rec = (RemminaVncRecord *)data;
+    struct pollfd pfd[2];
+    guchar *buf = NULL;
+    gsize buf_size = 0;
+    guint64 ts;
+    guint32 len;
+    gint64 wait;
+
+    for( ;; )
+    {
+        if( fread( &ts, sizeof( ts ), 1, rec->fp ) != 1 || fread( &len, sizeof( len ), 1, rec->fp ) != 1 )
+            break;
+        ts = GUINT64_FROM_BE( ts );
+        len = GUINT32_FROM_BE( len );
+        if( len > VNC_RECORD_MAX_CHUNK )
+        {
+            REMMINA_PLUGIN_WARNING( "Corrupt RFB recording, chunk of %u bytes", len );
+            break;
+        }
+        if( len > buf_size )
+        {
+            buf_size = len;
+            buf = (guchar *)g_realloc( buf, buf_size );
+        }
+        if( fread( buf, 1, len, rec->fp ) != len )
+            break;
+
+        /* Sleep until the chunk is due, while discarding what the client sends */
+        for( ;; )
+        {
+            wait = rec->realtime ? ( rec->start + (gint64)ts - g_get_monotonic_time() ) / 1000 : 0;
+            pfd[0].fd = rec->wake[0];
+            pfd[0].events = POLLIN;
+            pfd[1].fd = rec->fd;
+            pfd[1].events = POLLIN;
+            if( poll( pfd, 2, MAX( wait, 0 ) ) < 0 && errno != EINTR )
+                goto out;
+            if( pfd[0].revents )
+                goto out;
+            if( pfd[1].revents && !remmina_vnc_record_drain( rec->fd ) )
+                goto out;
+            if( wait <= 0 )
+                break;
+        }
+
+        if( !remmina_vnc_record_write_all( rec, rec->fd, buf, len ) )
+            break;
+        remmina_vnc_record_add_bytes( rec, len );
+    }
+
+out:
+    /* End of the recording: the client reads EOF and ends the session */
+    shutdown( rec->fd, SHUT_WR );
+    g_free( buf );
+    return NULL;
+}
+
+static gint remmina_vnc_record_open_pair( RemminaVncRecord *rec, char **error )
+{
+    TRACE_CALL( __func__ );
+    gint sv[2];
+
+    if( socketpair( AF_UNIX, SOCK_STREAM, 0, sv ) < 0 )
+    {
+        *error = g_strdup_printf( "socketpair: %s", g_strerror( errno ) );
+        return -1;
+    }
+    if( pipe( rec->wake ) < 0 )
+    {
+        *error = g_strdup_printf( "pipe: %s", g_strerror( errno ) );
+        close( sv[0] );
+        close( sv[1] );
+        return -1;
+    }
+    rec->fd = sv[0];
+    return sv[1];
+}
+
+static void remmina_vnc_record_free( RemminaVncRecord *rec )
+{
+    TRACE_CALL( __func__ );
+    if( rec->fd >= 0 )
+        close( rec->fd );
+    if( rec->peer >= 0 )
+        close( rec->peer );
+    if( rec->wake[0] >= 0 )
+        close( rec->wake[0] );
+    if( rec->wake[1] >= 0 )
+        close( rec->wake[1] );
+    if( rec->fp )
+        fclose( rec->fp );
+    pthread_mutex_destroy( &rec->mutex );
+    g_free( rec );
+}
+
+static RemminaVncRecord *remmina_vnc_record_new( void )
+{
+    TRACE_CALL( __func__ );
+    RemminaVncRecord *rec = g_new0( RemminaVncRecord, 1 );
+
+    rec->peer = -1;
+    rec->fd = -1;
+    rec->wake[0] = rec->wake[1] = -1;
+    pthread_mutex_init( &rec->mutex, NULL );
+    return rec;
+}
+
+static gint remmina_vnc_record_connect( const char *host, gint port, char **error )
+{
+    TRACE_CALL( __func__ );
+    struct addrinfo hints, *res, *ai;
+    char service[16];
+    gint sock = -1;
+    gint ret;
+
+    memset( &hints, 0, sizeof( hints ) );
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    g_snprintf( service, sizeof( service ), "%d", port );
+    ret = getaddrinfo( host, service, &hints, &res );
+    if( ret != 0 )
+    {
+        *error = g_strdup_printf( "%s: %s", host, gai_strerror( ret ) );
+        return -1;
+    }
+    for( ai = res; ai; ai = ai->ai_next )
+    {
+        sock = socket( ai->ai_family, ai->ai_socktype, ai->ai_protocol );
+        if( sock < 0 )
+            continue;
+        if( connect( sock, ai->ai_addr, ai->ai_addrlen ) == 0 )
+            break;
+        close( sock );
+        sock = -1;
+    }
+    freeaddrinfo( res );
+    if( sock < 0 )
+        *error = g_strdup_printf( "%s:%d: %s", host, port, g_strerror( errno ) );
+    return sock;
+}
+
+gint remmina_vnc_record_start( RemminaVncRecord **rec_out,
+                               const char *host,
+                               gint port,
+                               const char *filename,
+                               char **error )
+{
+    TRACE_CALL( __func__ );
+    RemminaVncRecord *rec = remmina_vnc_record_new();
+    gint client_fd;
+
+    *rec_out = NULL;
+    rec->fp = g_fopen( filename, "wb" );
+    if( !rec->fp )
+    {
+        *error = g_strdup_printf( "%s: %s", filename, g_strerror( errno ) );
+        remmina_vnc_record_free( rec );
+        return -1;
+    }
+    fwrite( VNC_RECORD_MAGIC, 1, VNC_RECORD_MAGIC_LEN, rec->fp );
+
+    rec->peer = remmina_vnc_record_connect( host, port, error );
+    if( rec->peer < 0 )
+    {
+        remmina_vnc_record_free( rec );
+        return -1;
+    }
+
+    client_fd = remmina_vnc_record_open_pair( rec, error );
+    if( client_fd < 0 )
+    {
+        remmina_vnc_record_free( rec );
+        return -1;
+    }
+
+    rec->start = g_get_monotonic_time();
+    if( pthread_create( &rec->thread, NULL, remmina_vnc_record_thread, rec ) )
+    {
+        *error = g_strdup( "Unable to start the RFB recording thread" );
+        close( client_fd );
+        remmina_vnc_record_free( rec );
+        return -1;
+    }
+    *rec_out = rec;
+    return client_fd;
+}
+
+gint remmina_vnc_replay_start( RemminaVncRecord **rec_out, const char *filename, bool realtime, char **error )
+{
+    TRACE_CALL( __func__ );
+    RemminaVncRecord *rec = remmina_vnc_record_new();
+    char magic[VNC_RECORD_MAGIC_LEN];
+    gint client_fd;
+
+    *rec_out = NULL;
+    rec->replay = TRUE;
+    rec->realtime = realtime;
+    rec->fp = g_fopen( filename, "rb" );
+    if( !rec->fp )
+    {
+        *error = g_strdup_printf( "%s: %s", filename, g_strerror( errno ) );
+        remmina_vnc_record_free( rec );
+        return -1;
+    }
+    if( fread( magic, 1, VNC_RECORD_MAGIC_LEN, rec->fp ) != VNC_RECORD_MAGIC_LEN
+        || memcmp( magic, VNC_RECORD_MAGIC, VNC_RECORD_MAGIC_LEN ) != 0 )
+    {
+        *error = g_strdup_printf( "%s is not an RFB recording", filename );
+        remmina_vnc_record_free( rec );
+        return -1;
+    }
+
+    client_fd = remmina_vnc_record_open_pair( rec, error );
+    if( client_fd < 0 )
+    {
+        remmina_vnc_record_free( rec );
+        return -1;
+    }
+
+    rec->start = g_get_monotonic_time();
+    if( pthread_create( &rec->thread, NULL, remmina_vnc_replay_thread, rec ) )
+    {
+        *error = g_strdup( "Unable to start the RFB replay thread" );
+        close( client_fd );
+        remmina_vnc_record_free( rec );
+        return -1;
+    }
+    *rec_out = rec;
+    return client_fd;
+}
+
+guint64 remmina_vnc_record_get_bytes( RemminaVncRecord *rec )
+{
+    TRACE_CALL( __func__ );
+    guint64 bytes;
+
+    pthread_mutex_lock( &rec->mutex );
+    bytes = rec->bytes;
+    pthread_mutex_unlock( &rec->mutex );
+    return bytes;
+}
+
+void remmina_vnc_record_stop( RemminaVncRecord *rec )
+{
+    TRACE_CALL( __func__ );
+    if( !rec )
+        return;
+
+    if( write( rec->wake[1], "", 1 ) < 0 )
+        REMMINA_PLUGIN_WARNING( "Unable to wake up the RFB %s thread", rec->replay ? "replay" : "recording" );
+    pthread_join( rec->thread, NULL );
+    remmina_vnc_record_free( rec );
+}
@@ -0,0 +1,68 @@
+/*
+ * Remmina - The GTK+ Remote Desktop Client
+ * Copyright (C) 2016-2022 Antenore Gatta, Giovanni Panozzo
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ *
+ *  In addition, as a special exception, the copyright holders give
+ *  permission to link the code of portions of this program with the
+ *  OpenSSL library under certain conditions as described in each
+ *  individual source file, and distribute linked combinations
+ *  including the two.
+ *  You must obey the GNU General Public License in all respects
+ *  for all of the code used other than OpenSSL. *  If you modify
+ *  file(s) with this exception, you may extend this exception to your
+ *  version of the file(s), but you are not obligated to do so. *  If you
+ *  do not wish to do so, delete this exception statement from your
+ *  version. *  If you delete this exception statement from all source
+ *  files in the program, then also delete it here.
+ *
+ */
+
+
+#pragma once
+
+#include <glib.h>
+
+/* RFB stream capture and replay, used to benchmark the VNC pixel path without a server.
+ *
+ * Both modes sit between libvncclient and the network: they hand out one end of a
+ * socketpair, which the plugin uses as the client socket, and pump data on a thread.
+ * A recording only contains what the server sent, as a sequence of
+ * [big endian gint64 microseconds since start][big endian guint32 length][data] chunks
+ * after an 8 byte magic. */
+
+struct RemminaVncRecord;
+
+/* Connect to host:port and record everything received from it into filename.
+ * Returns the socket libvncclient must use instead of its own connection, or -1 with *error set */
+gint remmina_vnc_record_start( RemminaVncRecord **rec,
+                               const char *host,
+                               gint port,
+                               const char *filename,
+                               char **error );
+
+/* Play back filename as if it came from a server. With realtime set, chunks are delivered
+ * at their recorded pace, otherwise as fast as the client reads them. Everything the client
+ * sends is discarded. The socket is shut down for writing at the end of the recording. */
+gint remmina_vnc_replay_start( RemminaVncRecord **rec, const char *filename, bool realtime, char **error );
+
+/* Bytes received from the server, or replayed, so far */
+guint64 remmina_vnc_record_get_bytes( RemminaVncRecord *rec );
+
+/* Stop the pump thread and free rec. The socket returned by start is not closed,
+ * it belongs to libvncclient */
+void remmina_vnc_record_stop( RemminaVncRecord *rec );
@@ -868,6 +868,16 @@ static int remmina_plugin_www_open_connection( RemminaProtocolWidget *gp )
     return TRUE;
 }
 
+static void remmina_plugin_www_snapshot_saved( const char *filename, bool success, gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+
+    if( success && g_file_test( filename, G_FILE_TEST_EXISTS ) )
+        www_utils_send_notification( "www-plugin-screenshot-is-ready-id", _( "Screenshot taken" ), filename );
+    else
+        REMMINA_PLUGIN_DEBUG( "WWW: unable to save screenshot %s", filename );
+}
+
 static void remmina_plugin_www_save_snapshot( GObject *object, GAsyncResult *result, RemminaProtocolWidget *gp )
 {
     TRACE_CALL( __func__ );
@@ -878,30 +888,24 @@ static void remmina_plugin_www_save_snapshot( GObject *object, GAsyncResult *res
 
     GError *err = NULL;
     cairo_surface_t *surface;
-    //unsigned char* buffer;
-    int width;
-    int height;
-    GdkPixbuf *screenshot;
     GString *pngstr;
     char *pngname;
-    //cairo_forma_t* cairo_format;
+    char *format;
     GDateTime *date = g_date_time_new_now_utc();
 
     remminafile = remmina_plugin_service->protocol_plugin_get_file( gp );
 
     surface = webkit_web_view_get_snapshot_finish( WEBKIT_WEB_VIEW( webview ), result, &err );
     if( err )
+    {
         g_warning( "An error happened generating the snapshot: %s\n", err->message );
-    //buffer = cairo_image_surface_get_data (surface);
-    width = cairo_image_surface_get_width( surface );
-    height = cairo_image_surface_get_height( surface );
-    //cairo_format = cairo_image_surface_get_format (surface);
-
-    screenshot = gdk_pixbuf_get_from_surface( surface, 0, 0, width, height );
-    if( screenshot == NULL )
-        REMMINA_PLUGIN_DEBUG( "WWW: gdk_pixbuf_get_from_surface failed" );
+        g_clear_error( &err );
+        g_date_time_unref( date );
+        return;
+    }
 
-    pngstr = g_string_new( g_strdup_printf( "%s/%s.png",
+    /* The extension is appended by the screenshot worker, according to the chosen format */
+    pngstr = g_string_new( g_strdup_printf( "%s/%s",
                                             remmina_plugin_service->pref_get_value( "screenshot_path" ),
                                             remmina_plugin_service->pref_get_value( "screenshot_name" ) ) );
     www_utils_string_replace_all( pngstr, "%p", remmina_plugin_service->file_get_string( remminafile, "name" ) );
@@ -916,11 +920,14 @@ static void remmina_plugin_www_save_snapshot( GObject *object, GAsyncResult *res
     pngname = g_string_free( pngstr, FALSE );
     REMMINA_PLUGIN_DEBUG( "Saving screenshot as %s", pngname );
 
-    cairo_surface_write_to_png( surface, pngname );
-    if( g_file_test( pngname, G_FILE_TEST_EXISTS ) )
-        www_utils_send_notification( "www-plugin-screenshot-is-ready-id", _( "Screenshot taken" ), pngname );
+    format = remmina_plugin_service->pref_get_value( "screenshot_format" );
+
+    /* Encoding happens on the Remmina screenshot workers, which also destroy the surface */
+    remmina_plugin_service->screenshot_save_async(
+        surface, pngname, format ? atoi( format ) : 0, remmina_plugin_www_snapshot_saved, NULL );
 
-    cairo_surface_destroy( surface );
+    g_free( format );
+    g_free( pngname );
 }
 static int remmina_plugin_www_get_snapshot( RemminaProtocolWidget *gp, RemminaPluginScreenshotData *rpsd )
 {
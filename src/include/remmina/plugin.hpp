@@ -262,6 +262,17 @@ struct RemminaPluginService
     int ( *gtksocket_available )();
     gint ( *get_profile_remote_width )( RemminaProtocolWidget *gp );
     gint ( *get_profile_remote_height )( RemminaProtocolWidget *gp );
+    void ( *screenshot_save_async )( cairo_surface_t *surface,
+                                     const char *basename,
+                                     gint format,
+                                     RemminaScreenshotDoneFunc done_cb,
+                                     gpointer user_data );
+    void ( *protocol_plugin_perf_add )( RemminaProtocolWidget *gp, RemminaPerfCounter counter, gint64 value );
+    bool ( *protocol_plugin_start_direct_tunnel_socket )( RemminaProtocolWidget *gp,
+                                                          gint default_port,
+                                                          bool port_plus,
+                                                          gint *sock );
+    bool ( *protocol_plugin_perf_enabled )( RemminaProtocolWidget *gp );
 };
 
 /* "Prototype" of the plugin entry function */
@@ -73,6 +73,35 @@ struct RemminaPluginScreenshotData
     int height;
 };
 
+enum RemminaScreenshotFormat
+{
+    REMMINA_SCREENSHOT_FORMAT_PNG = 0,
+    REMMINA_SCREENSHOT_FORMAT_PPM = 1,
+    REMMINA_SCREENSHOT_FORMAT_QOI = 2
+};
+
+/* Called on the main thread once a screenshot has been written (or failed) */
+typedef void ( *RemminaScreenshotDoneFunc )( const char *filename, bool success, gpointer user_data );
+
+/* Counters a protocol plugin feeds to remmina_protocol_widget_perf_add() for the performance overlay.
+ * Values are in microseconds for the _US counters, pixels for DAMAGE_PIXELS, bytes for BYTES_IN/OUT,
+ * pending items for QUEUE_DEPTH, events for INPUT_SENT (0 counts as one) and INPUT_COALESCED.
+ * FRAME_* and RECONNECT ignore the value. */
+enum RemminaPerfCounter
+{
+    REMMINA_PERF_FRAME_RECEIVED = 0,
+    REMMINA_PERF_FRAME_PRESENTED,
+    REMMINA_PERF_DECODE_US,
+    REMMINA_PERF_CONVERT_US,
+    REMMINA_PERF_DAMAGE_PIXELS,
+    REMMINA_PERF_INPUT_SENT,
+    REMMINA_PERF_BYTES_IN,
+    REMMINA_PERF_BYTES_OUT,
+    REMMINA_PERF_QUEUE_DEPTH,
+    REMMINA_PERF_RECONNECT,
+    REMMINA_PERF_INPUT_COALESCED
+};
+
 typedef int ( *RemminaXPortTunnelInitFunc )( RemminaProtocolWidget *gp,
                                              gint remotedisplay,
                                              const char *server,
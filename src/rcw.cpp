@@ -56,6 +56,7 @@
 #include "remmina_pref.hpp"
 #include "remmina_protocol_widget.hpp"
 #include "remmina_public.hpp"
+#include "remmina_screenshot.hpp"
 #include "remmina_scrolled_viewport.hpp"
 #include "remmina_utils.hpp"
 #include "remmina_widget_pool.hpp"
@@ -79,6 +80,11 @@ G_DEFINE_TYPE( RemminaConnectionWindow, rcw, GTK_TYPE_WINDOW )
 /* default timeout used to hide the floating toolbar when switching profile */
 #define TB_HIDE_TIME_TIME 1500
 
+/* Refresh period and placement of the performance overlay */
+#define PERF_HUD_INTERVAL 1000
+#define PERF_HUD_MARGIN 8
+#define PERF_HUD_PADDING 6
+
 #define FULL_SCREEN_TARGET_MONITOR_UNDEFINED -1
 
 struct RemminaConnectionWindowPriv
@@ -171,6 +177,12 @@ struct RemminaConnectionObject
     bool dynres_unlocked;
 
     gulong deferred_open_size_allocate_handler;
+
+    /* Performance overlay drawn on top of the viewport */
+    guint perf_hud_eventsource; // timeout
+    gulong perf_hud_draw_handler;
+    PangoLayout *perf_hud_layout;
+    GdkRectangle perf_hud_area;
 };
 
 enum
@@ -2258,6 +2270,17 @@ static void rcw_toolbar_duplicate( GtkToolItem *toggle, RemminaConnectionWindow
     remmina_exec_command( REMMINA_COMMAND_CONNECT, cnnobj->remmina_file->filename );
 }
 
+static void rcw_screenshot_done( const char *filename, bool success, gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+
+    /* send a desktop notification */
+    if( success && g_file_test( filename, G_FILE_TEST_EXISTS ) )
+        remmina_public_send_notification( "remmina-screenshot-is-ready-id", _( "Screenshot taken" ), filename );
+    else
+        REMMINA_WARNING( "Unable to save screenshot %s", filename );
+}
+
 static void rcw_toolbar_screenshot( GtkToolItem *toggle, RemminaConnectionWindow *cnnwin )
 {
     TRACE_CALL( __func__ );
@@ -2293,6 +2316,22 @@ static void rcw_toolbar_screenshot( GtkToolItem *toggle, RemminaConnectionWindow
 
     GtkClipboard *c = gtk_clipboard_get( GDK_SELECTION_CLIPBOARD );
 
+    //home/antenore/Pictures/remmina_%p_%h_%Y  %m %d-%H%M%S.png pngname
+    //home/antenore/Pictures/remmina_st_  _2018 9 24-151958.240374.png
+
+    /* The extension is appended by the screenshot worker, according to the chosen format */
+    pngstr = g_string_new( g_strdup_printf( "%s/%s", remmina_pref.screenshot_path, remmina_pref.screenshot_name ) );
+    remmina_utils_string_replace_all( pngstr, "%p", remmina_file_get_string( cnnobj->remmina_file, "name" ) );
+    remmina_utils_string_replace_all( pngstr, "%h", remmina_file_get_string( cnnobj->remmina_file, "server" ) );
+    remmina_utils_string_replace_all( pngstr, "%Y", g_strdup_printf( "%d", g_date_time_get_year( date ) ) );
+    remmina_utils_string_replace_all( pngstr, "%m", g_strdup_printf( "%02d", g_date_time_get_month( date ) ) );
+    remmina_utils_string_replace_all( pngstr, "%d", g_strdup_printf( "%02d", g_date_time_get_day_of_month( date ) ) );
+    remmina_utils_string_replace_all( pngstr, "%H", g_strdup_printf( "%02d", g_date_time_get_hour( date ) ) );
+    remmina_utils_string_replace_all( pngstr, "%M", g_strdup_printf( "%02d", g_date_time_get_minute( date ) ) );
+    remmina_utils_string_replace_all( pngstr, "%S", g_strdup_printf( "%02d", g_date_time_get_second( date ) ) );
+    g_date_time_unref( date );
+    pngname = g_string_free( pngstr, FALSE );
+
     // Ask the plugin if it can give us a screenshot
     if( remmina_protocol_widget_plugin_screenshot( gp, &rpsd ) )
     {
@@ -2307,27 +2346,31 @@ static void rcw_toolbar_screenshot( GtkToolItem *toggle, RemminaConnectionWindow
         width = rpsd.width;
         height = rpsd.height;
 
-        if( rpsd.bitsPerPixel == 32 )
-            cairo_format = CAIRO_FORMAT_ARGB32;
-        else if( rpsd.bitsPerPixel == 24 )
-            cairo_format = CAIRO_FORMAT_RGB24;
-        else
-            cairo_format = CAIRO_FORMAT_RGB16_565;
-
-        stride = cairo_format_stride_for_width( cairo_format, width );
-
-        srcsurface = cairo_image_surface_create_for_data( rpsd.buffer, cairo_format, width, height, stride );
         // Transfer the PixBuf in the main clipboard selection
         if( denyclip && ( g_strcmp0( denyclip, "true" ) ) )
+        {
+            if( rpsd.bitsPerPixel == 32 )
+                cairo_format = CAIRO_FORMAT_ARGB32;
+            else if( rpsd.bitsPerPixel == 24 )
+                cairo_format = CAIRO_FORMAT_RGB24;
+            else
+                cairo_format = CAIRO_FORMAT_RGB16_565;
+
+            stride = cairo_format_stride_for_width( cairo_format, width );
+            srcsurface = cairo_image_surface_create_for_data( rpsd.buffer, cairo_format, width, height, stride );
             gtk_clipboard_set_image( c, gdk_pixbuf_get_from_surface( srcsurface, 0, 0, width, height ) );
-        surface = cairo_image_surface_create( CAIRO_FORMAT_RGB24, width, height );
-        cr = cairo_create( surface );
-        cairo_set_source_surface( cr, srcsurface, 0, 0 );
-        cairo_set_operator( cr, CAIRO_OPERATOR_SOURCE );
-        cairo_paint( cr );
-        cairo_surface_destroy( srcsurface );
+            cairo_surface_destroy( srcsurface );
+        }
 
-        free( rpsd.buffer );
+        // The worker takes ownership of rpsd.buffer and encodes it without a repaint
+        remmina_screenshot_save_buffer_async( rpsd.buffer,
+                                              width,
+                                              height,
+                                              rpsd.bitsPerPixel,
+                                              pngname,
+                                              remmina_pref.screenshot_format,
+                                              rcw_screenshot_done,
+                                              NULL );
     }
     else
     {
@@ -2355,7 +2398,11 @@ static void rcw_toolbar_screenshot( GtkToolItem *toggle, RemminaConnectionWindow
 
         screenshot = gdk_pixbuf_get_from_window( active_window, 0, 0, width, height );
         if( screenshot == NULL )
+        {
             g_print( "gdk_pixbuf_get_from_window failed\n" );
+            g_free( pngname );
+            return;
+        }
 
         // Transfer the PixBuf in the main clipboard selection
         if( denyclip && ( g_strcmp0( denyclip, "true" ) ) )
@@ -2367,35 +2414,17 @@ static void rcw_toolbar_screenshot( GtkToolItem *toggle, RemminaConnectionWindow
         // Copy the source pixbuf to the surface and paint it.
         gdk_cairo_set_source_pixbuf( cr, screenshot, 0, 0 );
         cairo_paint( cr );
+        cairo_destroy( cr );
 
         // Deallocate screenshot pixbuf
         g_object_unref( screenshot );
-    }
-
-    //home/antenore/Pictures/remmina_%p_%h_%Y  %m %d-%H%M%S.png pngname
-    //home/antenore/Pictures/remmina_st_  _2018 9 24-151958.240374.png
-
-    pngstr = g_string_new( g_strdup_printf( "%s/%s.png", remmina_pref.screenshot_path, remmina_pref.screenshot_name ) );
-    remmina_utils_string_replace_all( pngstr, "%p", remmina_file_get_string( cnnobj->remmina_file, "name" ) );
-    remmina_utils_string_replace_all( pngstr, "%h", remmina_file_get_string( cnnobj->remmina_file, "server" ) );
-    remmina_utils_string_replace_all( pngstr, "%Y", g_strdup_printf( "%d", g_date_time_get_year( date ) ) );
-    remmina_utils_string_replace_all( pngstr, "%m", g_strdup_printf( "%02d", g_date_time_get_month( date ) ) );
-    remmina_utils_string_replace_all( pngstr, "%d", g_strdup_printf( "%02d", g_date_time_get_day_of_month( date ) ) );
-    remmina_utils_string_replace_all( pngstr, "%H", g_strdup_printf( "%02d", g_date_time_get_hour( date ) ) );
-    remmina_utils_string_replace_all( pngstr, "%M", g_strdup_printf( "%02d", g_date_time_get_minute( date ) ) );
-    remmina_utils_string_replace_all( pngstr, "%S", g_strdup_printf( "%02d", g_date_time_get_second( date ) ) );
-    g_date_time_unref( date );
-    pngname = g_string_free( pngstr, FALSE );
-
-    cairo_surface_write_to_png( surface, pngname );
 
-    /* send a desktop notification */
-    if( g_file_test( pngname, G_FILE_TEST_EXISTS ) )
-        remmina_public_send_notification( "remmina-screenshot-is-ready-id", _( "Screenshot taken" ), pngname );
+        // Encoding is done by the worker, which also destroys the surface
+        remmina_screenshot_save_async(
+            surface, pngname, remmina_pref.screenshot_format, rcw_screenshot_done, NULL );
+    }
 
-    //Clean up and return.
-    cairo_destroy( cr );
-    cairo_surface_destroy( surface );
+    g_free( pngname );
 }
 
 static void rcw_toolbar_minimize( GtkToolItem *toggle, RemminaConnectionWindow *cnnwin )
@@ -3476,8 +3505,7 @@ static int rcw_map_event( GtkWidget *widget, GdkEvent *event, gpointer data )
 
     gp = REMMINA_PROTOCOL_WIDGET( cnnobj->proto );
     REMMINA_DEBUG( "Mapping: %s", gtk_widget_get_name( widget ) );
-    if( remmina_protocol_widget_map_event( gp ) )
-        REMMINA_DEBUG( "Called plugin mapping function" );
+    remmina_protocol_widget_set_visible( gp, TRUE );
     return FALSE;
 }
 
@@ -3496,8 +3524,7 @@ static int rcw_unmap_event( GtkWidget *widget, GdkEvent *event, gpointer data )
 
     gp = REMMINA_PROTOCOL_WIDGET( cnnobj->proto );
     REMMINA_DEBUG( "Unmapping: %s", gtk_widget_get_name( widget ) );
-    if( remmina_protocol_widget_unmap_event( gp ) )
-        REMMINA_DEBUG( "Called plugin mapping function" );
+    remmina_protocol_widget_set_visible( gp, FALSE );
     return FALSE;
 }
 
@@ -3506,6 +3533,7 @@ static int rcw_map_event_fullscreen( GtkWidget *widget, GdkEvent *event, gpointe
     TRACE_CALL( __func__ );
     RemminaConnectionObject *cnnobj;
     gint target_monitor;
+    bool all_monitors;
 
     REMMINA_DEBUG( "Mapping: %s", gtk_widget_get_name( widget ) );
 
@@ -3529,43 +3557,42 @@ static int rcw_map_event_fullscreen( GtkWidget *widget, GdkEvent *event, gpointe
     if( !gp )
         REMMINA_DEBUG( "Remmina Protocol Widget undefined, cannot go fullscreen" );
 
-    if( remmina_protocol_widget_get_multimon( gp ) >= 1 )
+    all_monitors = remmina_protocol_widget_get_multimon( gp ) >= 1;
+    if( all_monitors )
     {
         REMMINA_DEBUG( "Fullscreen on all monitor" );
         gdk_window_set_fullscreen_mode( gtk_widget_get_window( widget ), GDK_FULLSCREEN_ON_ALL_MONITORS );
         gdk_window_fullscreen( gtk_widget_get_window( widget ) );
-        return TRUE;
     }
     else
     {
         REMMINA_DEBUG( "Fullscreen on one monitor" );
-    }
-
-    target_monitor = GPOINTER_TO_INT( data );
+        target_monitor = GPOINTER_TO_INT( data );
 
 #if GTK_CHECK_VERSION( 3, 18, 0 )
-    if( remmina_pref.fullscreen_on_auto )
-    {
-        if( target_monitor == FULL_SCREEN_TARGET_MONITOR_UNDEFINED )
-            gtk_window_fullscreen( GTK_WINDOW( widget ) );
+        if( remmina_pref.fullscreen_on_auto )
+        {
+            if( target_monitor == FULL_SCREEN_TARGET_MONITOR_UNDEFINED )
+                gtk_window_fullscreen( GTK_WINDOW( widget ) );
+            else
+                gtk_window_fullscreen_on_monitor(
+                    GTK_WINDOW( widget ), gtk_window_get_screen( GTK_WINDOW( widget ) ), target_monitor );
+        }
         else
-            gtk_window_fullscreen_on_monitor(
-                GTK_WINDOW( widget ), gtk_window_get_screen( GTK_WINDOW( widget ) ), target_monitor );
-    }
-    else
-    {
-        REMMINA_DEBUG( "Fullscreen managed by WM or by the user, as per settings" );
-        gtk_window_fullscreen( GTK_WINDOW( widget ) );
-    }
+        {
+            REMMINA_DEBUG( "Fullscreen managed by WM or by the user, as per settings" );
+            gtk_window_fullscreen( GTK_WINDOW( widget ) );
+        }
 #else
-    REMMINA_DEBUG( "Cannot fullscreen on a specific monitor, feature available from GTK 3.18" );
-    gtk_window_fullscreen( GTK_WINDOW( widget ) );
+        REMMINA_DEBUG( "Cannot fullscreen on a specific monitor, feature available from GTK 3.18" );
+        gtk_window_fullscreen( GTK_WINDOW( widget ) );
 #endif
+    }
 
-    if( remmina_protocol_widget_map_event( gp ) )
-        REMMINA_DEBUG( "Called plugin mapping function" );
+    /* Both paths, rcw_unmap_event() suppressed the output whatever the fullscreen mode */
+    remmina_protocol_widget_set_visible( gp, TRUE );
 
-    return FALSE;
+    return all_monitors;
 }
 
 static RemminaConnectionWindow *rcw_new( bool fullscreen, int full_screen_target_monitor )
@@ -3664,12 +3691,147 @@ static GtkWidget *nb_find_page_by_cnnobj( GtkNotebook *notebook, RemminaConnecti
     return found_page;
 }
 
+static gboolean rco_perf_hud_draw( GtkWidget *widget, cairo_t *cr, RemminaConnectionObject *cnnobj )
+{
+    TRACE_CALL( __func__ );
+    GdkRectangle *area = &cnnobj->perf_hud_area;
+
+    if( !cnnobj->perf_hud_layout )
+        return FALSE;
+
+    cairo_save( cr );
+    cairo_set_source_rgba( cr, 0.0, 0.0, 0.0, 0.65 );
+    cairo_rectangle( cr, area->x, area->y, area->width, area->height );
+    cairo_fill( cr );
+    cairo_set_source_rgb( cr, 1.0, 1.0, 1.0 );
+    cairo_move_to( cr, area->x + PERF_HUD_PADDING, area->y + PERF_HUD_PADDING );
+    pango_cairo_show_layout( cr, cnnobj->perf_hud_layout );
+    cairo_restore( cr );
+
+    return FALSE;
+}
+
+static void rco_perf_hud_stop( RemminaConnectionObject *cnnobj )
+{
+    TRACE_CALL( __func__ );
+    GdkRectangle *area = &cnnobj->perf_hud_area;
+
+    if( cnnobj->perf_hud_eventsource )
+    {
+        g_source_remove( cnnobj->perf_hud_eventsource );
+        cnnobj->perf_hud_eventsource = 0;
+    }
+    if( cnnobj->perf_hud_draw_handler && cnnobj->viewport )
+    {
+        g_signal_handler_disconnect( cnnobj->viewport, cnnobj->perf_hud_draw_handler );
+        gtk_widget_queue_draw_area( cnnobj->viewport, area->x, area->y, area->width, area->height );
+    }
+    cnnobj->perf_hud_draw_handler = 0;
+    if( cnnobj->perf_hud_layout )
+    {
+        g_object_unref( cnnobj->perf_hud_layout );
+        cnnobj->perf_hud_layout = NULL;
+    }
+    if( cnnobj->proto )
+        remmina_protocol_widget_perf_enable( REMMINA_PROTOCOL_WIDGET( cnnobj->proto ), FALSE );
+}
+
+static gboolean rco_perf_hud_update( gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    RemminaConnectionObject *cnnobj = (RemminaConnectionObject *)user_data;
+    RemminaPerfStats s;
+    GdkRectangle *area = &cnnobj->perf_hud_area;
+    GdkRectangle old_area = *area;
+    GString *text;
+    char *in, *out;
+    double secs;
+    gint w, h;
+
+    if( !cnnobj->proto || !cnnobj->viewport )
+    {
+        cnnobj->perf_hud_eventsource = 0;
+        rco_perf_hud_stop( cnnobj );
+        return G_SOURCE_REMOVE;
+    }
+
+    remmina_protocol_widget_perf_take( REMMINA_PROTOCOL_WIDGET( cnnobj->proto ), &s );
+    secs = MAX( s.period_us, 1 ) / 1000000.0;
+    in = g_format_size( (guint64)( s.bytes_in / secs ) );
+    out = g_format_size( (guint64)( s.bytes_out / secs ) );
+
+    text = g_string_new( NULL );
+    g_string_append_printf(
+        text, _( "FPS %.1f presented / %.1f received\n" ), s.frames_presented / secs, s.frames_received / secs );
+    g_string_append_printf( text,
+                            _( "Decode %.2f ms, convert %.2f ms per frame\n" ),
+                            s.decode_samples ? s.decode_us / 1000.0 / s.decode_samples : 0.0,
+                            s.convert_samples ? s.convert_us / 1000.0 / s.convert_samples : 0.0 );
+    g_string_append_printf( text, _( "Damage %.2f Mpixel/s\n" ), s.damage_pixels / secs / 1000000.0 );
+    if( s.latency_samples )
+        g_string_append_printf( text,
+                                _( "Input latency %.1f ms (max %.1f ms)\n" ),
+                                s.latency_us / 1000.0 / s.latency_samples,
+                                s.latency_max_us / 1000.0 );
+    else
+        g_string_append( text, _( "Input latency -\n" ) );
+    g_string_append_printf( text, _( "Input %u sent, %u coalesced\n" ), s.input_sent, s.input_coalesced );
+    g_string_append_printf( text, _( "In %s/s, out %s/s\n" ), in, out );
+    g_string_append_printf( text, _( "Queue %d (max %d)" ), (int)s.queue_depth, (int)s.queue_depth_max );
+    g_free( in );
+    g_free( out );
+
+    if( !cnnobj->perf_hud_layout )
+    {
+        PangoFontDescription *font = pango_font_description_from_string( "Monospace 9" );
+        cnnobj->perf_hud_layout = gtk_widget_create_pango_layout( cnnobj->viewport, NULL );
+        pango_layout_set_font_description( cnnobj->perf_hud_layout, font );
+        pango_font_description_free( font );
+    }
+    pango_layout_set_text( cnnobj->perf_hud_layout, text->str, -1 );
+    g_string_free( text, TRUE );
+
+    pango_layout_get_pixel_size( cnnobj->perf_hud_layout, &w, &h );
+    area->x = PERF_HUD_MARGIN;
+    area->y = PERF_HUD_MARGIN;
+    area->width = w + 2 * PERF_HUD_PADDING;
+    area->height = h + 2 * PERF_HUD_PADDING;
+
+    /* Only repaint the box, not the whole remote desktop below it */
+    gdk_rectangle_union( &old_area, area, &old_area );
+    gtk_widget_queue_draw_area( cnnobj->viewport, old_area.x, old_area.y, old_area.width, old_area.height );
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void rco_perf_hud_toggle( RemminaConnectionObject *cnnobj )
+{
+    TRACE_CALL( __func__ );
+
+    if( cnnobj->perf_hud_eventsource )
+    {
+        rco_perf_hud_stop( cnnobj );
+        return;
+    }
+    if( !cnnobj->proto || !cnnobj->viewport )
+        return;
+
+    remmina_protocol_widget_perf_enable( REMMINA_PROTOCOL_WIDGET( cnnobj->proto ), TRUE );
+    cnnobj->perf_hud_draw_handler =
+        g_signal_connect_after( G_OBJECT( cnnobj->viewport ), "draw", G_CALLBACK( rco_perf_hud_draw ), cnnobj );
+    cnnobj->perf_hud_eventsource = g_timeout_add( PERF_HUD_INTERVAL, rco_perf_hud_update, cnnobj );
+}
+
 void rco_closewin( RemminaProtocolWidget *gp )
 {
     TRACE_CALL( __func__ );
     RemminaConnectionObject *cnnobj = gp->cnnobj;
     GtkWidget *page_to_remove;
 
+    /* The overlay is attached to the viewport, which goes away with the page */
+    if( cnnobj )
+        rco_perf_hud_stop( cnnobj );
+
     if( cnnobj && cnnobj->cnnwin )
     {
         page_to_remove = nb_find_page_by_cnnobj( cnnobj->cnnwin->priv->notebook, cnnobj );
@@ -3838,6 +4000,28 @@ static int rcw_on_switch_page_finalsel( gpointer user_data )
     return FALSE;
 }
 
+/* Only the current page of a mapped window is visible, tell every other
+ * protocol widget to stop rendering updates nobody can see */
+static void rcw_update_pages_visibility( RemminaConnectionWindow *cnnwin, GtkWidget *curpage )
+{
+    TRACE_CALL( __func__ );
+    RemminaConnectionObject *cnnobj;
+    GtkNotebook *notebook = GTK_NOTEBOOK( cnnwin->priv->notebook );
+    GtkWidget *page;
+    bool mapped = gtk_widget_get_mapped( GTK_WIDGET( cnnwin ) );
+    gint i, n;
+
+    n = gtk_notebook_get_n_pages( notebook );
+    for( i = 0; i < n; i++ )
+    {
+        page = gtk_notebook_get_nth_page( notebook, i );
+        cnnobj = static_cast<RemminaConnectionObject *>( g_object_get_data( G_OBJECT( page ), "cnnobj" ) );
+        if( !cnnobj || !cnnobj->proto )
+            continue;
+        remmina_protocol_widget_set_visible( REMMINA_PROTOCOL_WIDGET( cnnobj->proto ), mapped && page == curpage );
+    }
+}
+
 static void
 rcw_on_switch_page( GtkNotebook *notebook, GtkWidget *newpage, guint page_num, RemminaConnectionWindow *cnnwin )
 {
@@ -3846,6 +4030,7 @@ rcw_on_switch_page( GtkNotebook *notebook, GtkWidget *newpage, guint page_num, R
     RemminaConnectionObject *cnnobj_newpage;
 
     cnnobj_newpage = static_cast<RemminaConnectionObject *>( g_object_get_data( G_OBJECT( newpage ), "cnnobj" ) );
+    rcw_update_pages_visibility( cnnwin, newpage );
     if( priv->spf_eventsourceid )
         g_source_remove( priv->spf_eventsourceid );
     priv->spf_eventsourceid = g_idle_add( rcw_on_switch_page_finalsel, cnnobj_newpage );
@@ -4449,6 +4634,10 @@ static int rcw_hostkey_func( RemminaProtocolWidget *gp, guint keyval, bool relea
             rcw_set_toolbar_visibility( cnnobj->cnnwin );
         }
     }
+    else if( keyval == remmina_pref.shortcutkey_perf_hud )
+    {
+        rco_perf_hud_toggle( cnnobj );
+    }
     else
     {
         for( feature = remmina_protocol_widget_get_features( REMMINA_PROTOCOL_WIDGET( cnnobj->proto ) );
@@ -4588,6 +4777,7 @@ void rco_on_disconnect( RemminaProtocolWidget *gp, gpointer data )
         RemminaMessagePanel *mp;
         /* Destroy scrolled_container (and viewport) and all its children the plugin created
 		 * on it, so they will not receive GUI signals */
+        rco_perf_hud_stop( cnnobj );
         if( cnnobj->scrolled_container )
         {
             gtk_widget_destroy( cnnobj->scrolled_container );
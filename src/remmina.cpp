@@ -46,6 +46,8 @@
 #include "remmina_icon.hpp"
 #include "remmina_main.hpp"
 #include "remmina_masterthread_exec.hpp"
+#include "remmina_metrics.hpp"
+#include "remmina_persist.hpp"
 #include "remmina_plugin_manager.hpp"
 #include "remmina_plugin_native.hpp"
 #ifdef WITH_PYTHONLIBS
@@ -303,6 +305,7 @@ static void remmina_on_startup( GApplication *app )
     g_application_hold( app );
 
     rmnews_schedule();
+    remmina_metrics_init();
 
     /* Check for secret plugin and service initialization and show console warnings if
 	 * something is missing */
@@ -477,5 +480,9 @@ int main( int argc, char *argv[] )
     status = g_application_run( G_APPLICATION( app ), argc, argv );
     g_object_unref( app );
 
+    remmina_metrics_shutdown();
+    /* Preferences and states saved in the last moments are still in memory */
+    remmina_persist_flush();
+
     return status;
 }
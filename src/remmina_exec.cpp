@@ -49,6 +49,7 @@
 #include "remmina_file.hpp"
 #include "remmina_file_manager.hpp"
 #include "remmina_file_editor.hpp"
+#include "remmina_launcher.hpp"
 #include "rcw.hpp"
 #include "remmina_about.hpp"
 #include "remmina_plugin_manager.hpp"
@@ -224,7 +225,7 @@ static void remmina_exec_autostart_cb( RemminaFile *remminafile, gpointer user_d
     if( remmina_file_get_int( remminafile, "enable-autostart", FALSE ) )
     {
         REMMINA_DEBUG( "Profile %s is set to autostart", remminafile->filename );
-        rcw_open_from_filename( remminafile->filename );
+        remmina_launcher_queue( remminafile->filename );
     }
 }
 
@@ -264,7 +265,8 @@ static void remmina_exec_connect( const char *data )
         char *filename = g_filename_from_uri( data, NULL, &error );
         if( filename != NULL )
         {
-            rcw_open_from_filename( filename );
+            remmina_launcher_queue( filename );
+            g_free( filename );
         }
         else
             REMMINA_DEBUG( "Opening URI %s failed with error %s", data, error->message );
@@ -274,7 +276,7 @@ static void remmina_exec_connect( const char *data )
 
     if( protocol == NULL )
     {
-        rcw_open_from_filename( data );
+        remmina_launcher_queue( data );
         return;
     }
 
@@ -59,6 +59,7 @@
 #include "remmina_pref.hpp"
 #include "remmina_main.hpp"
 #include "remmina_masterthread_exec.hpp"
+#include "remmina_persist.hpp"
 #include "remmina_utils.hpp"
 #include "remmina/remmina_trace_calls.hpp"
 
@@ -681,21 +682,6 @@ static GKeyFile *remmina_file_get_keyfile( RemminaFile *remminafile )
     return gkeyfile;
 }
 
-static GKeyFile *remmina_file_get_keystate( RemminaFile *remminafile )
-{
-    TRACE_CALL( __func__ );
-    GKeyFile *gkeyfile;
-
-    if( remminafile->statefile == NULL )
-        return NULL;
-    gkeyfile = g_key_file_new();
-    if( !g_key_file_load_from_file( gkeyfile, remminafile->statefile, G_KEY_FILE_NONE, NULL ) )
-    {
-        /* it will fail if it’s a new file, but shouldn’t matter. */
-    }
-    return gkeyfile;
-}
-
 void remmina_file_free( RemminaFile *remminafile )
 {
     TRACE_CALL( __func__ );
@@ -726,16 +712,19 @@ void remmina_file_save( RemminaFile *remminafile )
     gint nopasswdsave;
     GKeyFile *gkeyfile;
     GKeyFile *gkeystate;
+    GKeyFile *gkeypref;
+    char **keys;
+    gsize i;
     gsize length = 0;
     GError *err = NULL;
 
     if( remminafile->prevent_saving )
         return;
 
-    if( ( gkeyfile = remmina_file_get_keyfile( remminafile ) ) == NULL )
+    if( remminafile->statefile == NULL )
         return;
 
-    if( ( gkeystate = remmina_file_get_keystate( remminafile ) ) == NULL )
+    if( ( gkeyfile = remmina_file_get_keyfile( remminafile ) ) == NULL )
         return;
 
     REMMINA_DEBUG( "Saving profile" );
@@ -821,29 +810,45 @@ void remmina_file_save( RemminaFile *remminafile )
     g_key_file_remove_key( gkeyfile, KEYFILE_GROUP_REMMINA, "save_ssh_server", NULL );
     g_key_file_remove_key( gkeyfile, KEYFILE_GROUP_REMMINA, "save_ssh_username", NULL );
 
-    /* Store gkeyfile to disk (password are already sent to keyring) */
-    content = g_key_file_to_data( gkeyfile, &length, NULL );
-
-    if( g_file_set_contents( remminafile->filename, content, length, &err ) )
-        REMMINA_DEBUG( "Profile saved" );
+    if( g_strcmp0( remminafile->filename, remmina_pref_file ) == 0 )
+    {
+        /* The profile defaults live in remmina.pref, which the persist worker rewrites too.
+         * Queue just their group, the other ones may have newer values pending */
+        gkeypref = g_key_file_new();
+        keys = g_key_file_get_keys( gkeyfile, KEYFILE_GROUP_REMMINA, NULL, NULL );
+        for( i = 0; keys && keys[i]; i++ )
+        {
+            s = g_key_file_get_value( gkeyfile, KEYFILE_GROUP_REMMINA, keys[i], NULL );
+            g_key_file_set_value( gkeypref, KEYFILE_GROUP_REMMINA, keys[i], s );
+            g_free( s );
+        }
+        g_strfreev( keys );
+        remmina_persist_merge( remmina_pref_file, gkeypref );
+        g_key_file_free( gkeypref );
+        REMMINA_DEBUG( "Profile defaults queued for saving" );
+    }
     else
-        REMMINA_WARNING( "Remmina connection profile cannot be saved, with error %d (%s)", err->code, err->message );
-    if( err != NULL )
-        g_error_free( err );
+    {
+        /* Store gkeyfile to disk (password are already sent to keyring) */
+        content = g_key_file_to_data( gkeyfile, &length, NULL );
+
+        if( g_file_set_contents( remminafile->filename, content, length, &err ) )
+            REMMINA_DEBUG( "Profile saved" );
+        else
+            REMMINA_WARNING(
+                "Remmina connection profile cannot be saved, with error %d (%s)", err->code, err->message );
+        if( err != NULL )
+            g_error_free( err );
 
-    g_free( content ), content = NULL;
-    /* Saving states */
+        g_free( content ), content = NULL;
+    }
+    /* Saving states, through the persist queue like every other state file writer,
+     * which merges them with the keys already on disk */
+    gkeystate = g_key_file_new();
     g_hash_table_iter_init( &iter, remminafile->states );
     while( g_hash_table_iter_next( &iter, (gpointer *)&key, (gpointer *)&value ) )
-        g_key_file_set_string( gkeyfile, KEYFILE_GROUP_STATE, key, value );
-    content = g_key_file_to_data( gkeystate, &length, NULL );
-    if( g_file_set_contents( remminafile->statefile, content, length, &err ) )
-        REMMINA_DEBUG( "Connection profile states saved" );
-    else
-        REMMINA_WARNING( "Remmina connection profile cannot be saved, with error %d (%s)", err->code, err->message );
-    if( err != NULL )
-        g_error_free( err );
-    g_free( content ), content = NULL;
+        g_key_file_set_string( gkeystate, KEYFILE_GROUP_STATE, key, value );
+    remmina_persist_merge( remminafile->statefile, gkeystate );
     g_key_file_free( gkeyfile );
     g_key_file_free( gkeystate );
 
@@ -936,7 +941,7 @@ const char *remmina_file_get_state( RemminaFile *remminafile, const char *settin
     g_autoptr( GError ) error = NULL;
     g_autoptr( GKeyFile ) key_file = g_key_file_new();
 
-    if( !g_key_file_load_from_file( key_file, remminafile->statefile, G_KEY_FILE_NONE, &error ) )
+    if( !remmina_persist_load( key_file, remminafile->statefile, &error ) )
     {
         if( !g_error_matches( error, G_FILE_ERROR, G_FILE_ERROR_NOENT ) )
             REMMINA_CRITICAL( "Could not load the state file. %s", error->message );
@@ -958,31 +963,28 @@ void remmina_file_state_last_success( RemminaFile *remminafile )
 {
     TRACE_CALL( __func__ );
 
-    g_autoptr( GKeyFile ) key_statefile = g_key_file_new();
-    g_autoptr( GKeyFile ) key_remminafile = g_key_file_new();
-    GError *error = NULL;
-
-    const char *date = NULL;
+    g_autofree char *date = NULL;
     GDateTime *d = g_date_time_new_now_utc();
 
     date = g_strdup_printf(
         "%d%02d%02d", g_date_time_get_year( d ), g_date_time_get_month( d ), g_date_time_get_day_of_month( d ) );
+    g_date_time_unref( d );
 
-    g_key_file_set_string( key_statefile, KEYFILE_GROUP_STATE, "last_success", date );
-
+    /* Written later, together with the other states of the file */
     REMMINA_DEBUG( "State file %s.", remminafile->statefile );
-    if( !g_key_file_save_to_file( key_statefile, remminafile->statefile, &error ) )
-    {
-        REMMINA_CRITICAL( "Could not save the key file. %s", error->message );
-        g_error_free( error );
-        error = NULL;
-        return;
-    }
-    /* Delete old pre-1.5 keys */
-    g_key_file_remove_key( key_remminafile, KEYFILE_GROUP_REMMINA, "last_success", NULL );
+    remmina_persist_set_string( remminafile->statefile, KEYFILE_GROUP_STATE, "last_success", date );
     REMMINA_DEBUG( "Last connection made on %s.", date );
 }
 
+void remmina_file_state_save_int( const char *statefile, const char *setting, gint value )
+{
+    TRACE_CALL( __func__ );
+
+    if( !statefile )
+        return;
+    remmina_persist_set_integer( statefile, KEYFILE_GROUP_STATE, setting, value );
+}
+
 void remmina_file_unsave_passwords( RemminaFile *remminafile )
 {
     /* Delete all saved secrets for this profile */
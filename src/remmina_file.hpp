@@ -85,6 +85,8 @@ void remmina_file_generate_filename( RemminaFile *remminafile );
 void remmina_file_set_filename( RemminaFile *remminafile, const char *filename );
 void remmina_file_set_statefile( RemminaFile *remminafile );
 void remmina_file_state_last_success( RemminaFile *remminafile );
+/* Update a single key of a state file without loading its profile */
+void remmina_file_state_save_int( const char *statefile, const char *setting, gint value );
 const char *remmina_file_get_filename( RemminaFile *remminafile );
 const char *remmina_file_get_statefile( RemminaFile *remminafile );
 /* Load a new .remmina file and return the allocated RemminaFile object */
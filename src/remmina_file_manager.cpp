@@ -254,119 +254,6 @@ char *remmina_file_manager_get_groups()
     return groups;
 }
 
-static void remmina_file_manager_add_group( GNode *node, const char *group )
-{
-    TRACE_CALL( __func__ );
-    gint cmp;
-    char *p1;
-    char *p2;
-    GNode *child;
-    bool found;
-    RemminaGroupData *data;
-
-    if( node == NULL )
-        return;
-
-    if( group == NULL || group[0] == '\0' )
-        return;
-
-    p1 = g_strdup( group );
-    p2 = strchr( p1, '/' );
-
-    if( p2 )
-        *p2++ = '\0';
-
-    found = FALSE;
-
-    for( child = g_node_first_child( node ); child; child = g_node_next_sibling( child ) )
-    {
-        cmp = g_strcmp0( ( (RemminaGroupData *)child->data )->name, p1 );
-
-        if( cmp == 0 )
-        {
-            found = TRUE;
-            break;
-        }
-
-        if( cmp > 0 )
-            break;
-    }
-
-    if( !found )
-    {
-        data = g_new0( RemminaGroupData, 1 );
-        data->name = p1;
-        if( node->data )
-            data->group = g_strdup_printf( "%s/%s", ( (RemminaGroupData *)node->data )->group, p1 );
-        else
-            data->group = g_strdup( p1 );
-        if( child )
-            child = g_node_insert_data_before( node, child, data );
-        else
-            child = g_node_append_data( node, data );
-    }
-    remmina_file_manager_add_group( child, p2 );
-
-    if( found )
-        g_free( p1 );
-}
-
-GNode *remmina_file_manager_get_group_tree()
-{
-    TRACE_CALL( __func__ );
-    char filename[MAX_PATH_LEN];
-    GDir *dir;
-    g_autofree char *datadir = NULL;
-    const char *name;
-    RemminaFile *remminafile;
-    const char *group;
-    GNode *root;
-
-    root = g_node_new( NULL );
-
-    datadir = g_strdup( remmina_file_get_datadir() );
-    dir = g_dir_open( datadir, 0, NULL );
-
-    if( dir == NULL )
-        return root;
-    while( ( name = g_dir_read_name( dir ) ) != NULL )
-    {
-        if( !g_str_has_suffix( name, ".remmina" ) )
-            continue;
-        g_snprintf( filename, MAX_PATH_LEN, "%s/%s", datadir, name );
-        remminafile = remmina_file_load( filename );
-        if( remminafile )
-        {
-            group = remmina_file_get_string( remminafile, "group" );
-            remmina_file_manager_add_group( root, group );
-            remmina_file_free( remminafile );
-        }
-    }
-    g_dir_close( dir );
-    return root;
-}
-
-void remmina_file_manager_free_group_tree( GNode *node )
-{
-    TRACE_CALL( __func__ );
-    RemminaGroupData *data;
-    GNode *child;
-
-    if( !node )
-        return;
-    data = (RemminaGroupData *)node->data;
-    if( data )
-    {
-        g_free( data->name );
-        g_free( data->group );
-        g_free( data );
-        node->data = NULL;
-    }
-    for( child = g_node_first_child( node ); child; child = g_node_next_sibling( child ) )
-        remmina_file_manager_free_group_tree( child );
-    g_node_unlink( node );
-}
-
 RemminaFile *remmina_file_manager_load_file( const char *filename )
 {
     TRACE_CALL( __func__ );
@@ -37,13 +37,6 @@
 
 #include "remmina_file.hpp"
 
-struct RemminaGroupData
-{
-    char *name;
-    char *group;
-    char *datetime;
-};
-
 /* Initialize */
 char *remmina_file_get_datadir();
 void remmina_file_manager_init();
@@ -51,7 +44,5 @@ void remmina_file_manager_init();
 gint remmina_file_manager_iterate( GFunc func, gpointer user_data );
 /* Get a list of groups */
 char *remmina_file_manager_get_groups();
-GNode *remmina_file_manager_get_group_tree();
-void remmina_file_manager_free_group_tree( GNode *node );
 /* Load or import a file */
 RemminaFile *remmina_file_manager_load_file( const char *filename );
@@ -47,6 +47,7 @@
 #include "remmina_file.hpp"
 #include "remmina_ftp_client.hpp"
 #include "remmina_masterthread_exec.hpp"
+#include "remmina_log.hpp"
 #include "remmina/remmina_trace_calls.hpp"
 
 /* -------------------- RemminaCellRendererPixbuf ----------------------- */
@@ -126,6 +127,514 @@ static GtkCellRenderer *remmina_cell_renderer_pixbuf_new()
     return renderer;
 }
 
+/* -------------------- RemminaFTPFileModel ----------------------- */
+/* A flat tree model for the remote file list. Entries are kept in a single array, with
+ * their strings in one chunk and their sort key computed once. The visible rows are an
+ * index over the array, without hidden files when they are not shown, and are sorted as
+ * a whole: rows appended by a listing are merged in once per main loop iteration instead
+ * of being sorted in one at a time, so very large folders stay cheap to fill and scroll. */
+
+#define REMMINA_TYPE_FTP_FILE_MODEL ( remmina_ftp_file_model_get_type() )
+#define REMMINA_FTP_FILE_MODEL( obj ) \
+    ( G_TYPE_CHECK_INSTANCE_CAST( ( obj ), REMMINA_TYPE_FTP_FILE_MODEL, RemminaFTPFileModel ) )
+
+struct RemminaFTPFileEntry
+{
+    const char *name;
+    /* Type followed by the collation key of the name, stored in the model's string chunk */
+    const char *key;
+    /* Interned, there are few of them */
+    const char *owner;
+    const char *group;
+    gfloat size;
+    gint permission;
+    gint type;
+};
+
+struct RemminaFTPFileModel
+{
+    GObject parent;
+
+    GArray *entries;
+    GStringChunk *strings;
+    /* Visible rows as indexes into entries, the first sorted_rows are in order */
+    GArray *rows;
+    guint sorted_rows;
+    guint sort_source;
+    gint stamp;
+    gint sort_column;
+    GtkSortType sort_order;
+    bool show_hidden;
+};
+
+struct RemminaFTPFileModelClass
+{
+    GObjectClass parent_class;
+};
+
+GType remmina_ftp_file_model_get_type() G_GNUC_CONST;
+
+static void remmina_ftp_file_model_tree_model_init( GtkTreeModelIface *iface );
+static void remmina_ftp_file_model_sortable_init( GtkTreeSortableIface *iface );
+
+G_DEFINE_TYPE_WITH_CODE( RemminaFTPFileModel,
+                         remmina_ftp_file_model,
+                         G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE( GTK_TYPE_TREE_MODEL, remmina_ftp_file_model_tree_model_init );
+                         G_IMPLEMENT_INTERFACE( GTK_TYPE_TREE_SORTABLE, remmina_ftp_file_model_sortable_init ); );
+
+#define REMMINA_FTP_FILE_MODEL_ENTRY( model, pos ) \
+    ( &g_array_index( ( model )->entries, RemminaFTPFileEntry, g_array_index( ( model )->rows, guint, pos ) ) )
+
+static GtkTreeModelFlags remmina_ftp_file_model_get_flags( GtkTreeModel *tree_model )
+{
+    return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint remmina_ftp_file_model_get_n_columns( GtkTreeModel *tree_model )
+{
+    return REMMINA_FTP_FILE_N_COLUMNS;
+}
+
+static GType remmina_ftp_file_model_get_column_type( GtkTreeModel *tree_model, gint index )
+{
+    switch( index )
+    {
+        case REMMINA_FTP_FILE_COLUMN_TYPE:
+        case REMMINA_FTP_FILE_COLUMN_PERMISSION:
+            return G_TYPE_INT;
+        case REMMINA_FTP_FILE_COLUMN_SIZE:
+            return G_TYPE_FLOAT;
+        default:
+            return G_TYPE_STRING;
+    }
+}
+
+static gboolean remmina_ftp_file_model_set_iter( RemminaFTPFileModel *model, GtkTreeIter *iter, guint pos )
+{
+    if( pos >= model->rows->len )
+        return FALSE;
+    iter->stamp = model->stamp;
+    iter->user_data = GUINT_TO_POINTER( pos );
+    return TRUE;
+}
+
+static gboolean remmina_ftp_file_model_get_iter( GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreePath *path )
+{
+    if( gtk_tree_path_get_depth( path ) != 1 )
+        return FALSE;
+    return remmina_ftp_file_model_set_iter(
+        REMMINA_FTP_FILE_MODEL( tree_model ), iter, gtk_tree_path_get_indices( path )[0] );
+}
+
+static GtkTreePath *remmina_ftp_file_model_get_path( GtkTreeModel *tree_model, GtkTreeIter *iter )
+{
+    return gtk_tree_path_new_from_indices( GPOINTER_TO_UINT( iter->user_data ), -1 );
+}
+
+static void remmina_ftp_file_model_get_value( GtkTreeModel *tree_model, GtkTreeIter *iter, gint column, GValue *value )
+{
+    RemminaFTPFileModel *model = (RemminaFTPFileModel *)tree_model;
+    RemminaFTPFileEntry *entry = REMMINA_FTP_FILE_MODEL_ENTRY( model, GPOINTER_TO_UINT( iter->user_data ) );
+
+    g_value_init( value, remmina_ftp_file_model_get_column_type( tree_model, column ) );
+    switch( column )
+    {
+        case REMMINA_FTP_FILE_COLUMN_TYPE:
+            g_value_set_int( value, entry->type );
+            break;
+        case REMMINA_FTP_FILE_COLUMN_NAME:
+            g_value_set_static_string( value, entry->name );
+            break;
+        case REMMINA_FTP_FILE_COLUMN_SIZE:
+            g_value_set_float( value, entry->size );
+            break;
+        case REMMINA_FTP_FILE_COLUMN_USER:
+            g_value_set_static_string( value, entry->owner );
+            break;
+        case REMMINA_FTP_FILE_COLUMN_GROUP:
+            g_value_set_static_string( value, entry->group );
+            break;
+        case REMMINA_FTP_FILE_COLUMN_PERMISSION:
+            g_value_set_int( value, entry->permission );
+            break;
+        case REMMINA_FTP_FILE_COLUMN_NAME_SORT:
+            g_value_set_static_string( value, entry->key );
+            break;
+    }
+}
+
+static gboolean remmina_ftp_file_model_iter_next( GtkTreeModel *tree_model, GtkTreeIter *iter )
+{
+    return remmina_ftp_file_model_set_iter(
+        REMMINA_FTP_FILE_MODEL( tree_model ), iter, GPOINTER_TO_UINT( iter->user_data ) + 1 );
+}
+
+static gboolean remmina_ftp_file_model_iter_previous( GtkTreeModel *tree_model, GtkTreeIter *iter )
+{
+    guint pos = GPOINTER_TO_UINT( iter->user_data );
+
+    if( pos == 0 )
+        return FALSE;
+    return remmina_ftp_file_model_set_iter( REMMINA_FTP_FILE_MODEL( tree_model ), iter, pos - 1 );
+}
+
+static gboolean remmina_ftp_file_model_iter_nth_child( GtkTreeModel *tree_model,
+                                                       GtkTreeIter *iter,
+                                                       GtkTreeIter *parent,
+                                                       gint n )
+{
+    if( parent || n < 0 )
+        return FALSE;
+    return remmina_ftp_file_model_set_iter( REMMINA_FTP_FILE_MODEL( tree_model ), iter, n );
+}
+
+static gboolean remmina_ftp_file_model_iter_children( GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreeIter *parent )
+{
+    return remmina_ftp_file_model_iter_nth_child( tree_model, iter, parent, 0 );
+}
+
+static gboolean remmina_ftp_file_model_iter_has_child( GtkTreeModel *tree_model, GtkTreeIter *iter )
+{
+    return FALSE;
+}
+
+static gint remmina_ftp_file_model_iter_n_children( GtkTreeModel *tree_model, GtkTreeIter *iter )
+{
+    return iter ? 0 : REMMINA_FTP_FILE_MODEL( tree_model )->rows->len;
+}
+
+static gboolean remmina_ftp_file_model_iter_parent( GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreeIter *child )
+{
+    return FALSE;
+}
+
+static void remmina_ftp_file_model_tree_model_init( GtkTreeModelIface *iface )
+{
+    iface->get_flags = remmina_ftp_file_model_get_flags;
+    iface->get_n_columns = remmina_ftp_file_model_get_n_columns;
+    iface->get_column_type = remmina_ftp_file_model_get_column_type;
+    iface->get_iter = remmina_ftp_file_model_get_iter;
+    iface->get_path = remmina_ftp_file_model_get_path;
+    iface->get_value = remmina_ftp_file_model_get_value;
+    iface->iter_next = remmina_ftp_file_model_iter_next;
+    iface->iter_previous = remmina_ftp_file_model_iter_previous;
+    iface->iter_children = remmina_ftp_file_model_iter_children;
+    iface->iter_has_child = remmina_ftp_file_model_iter_has_child;
+    iface->iter_n_children = remmina_ftp_file_model_iter_n_children;
+    iface->iter_nth_child = remmina_ftp_file_model_iter_nth_child;
+    iface->iter_parent = remmina_ftp_file_model_iter_parent;
+}
+
+/* Compare two visible rows by their position */
+static gint remmina_ftp_file_model_compare( gconstpointer a, gconstpointer b, gpointer data )
+{
+    RemminaFTPFileModel *model = (RemminaFTPFileModel *)data;
+    RemminaFTPFileEntry *ea = REMMINA_FTP_FILE_MODEL_ENTRY( model, *(const gint *)a );
+    RemminaFTPFileEntry *eb = REMMINA_FTP_FILE_MODEL_ENTRY( model, *(const gint *)b );
+    gint ret = 0;
+
+    switch( model->sort_column )
+    {
+        case REMMINA_FTP_FILE_COLUMN_SIZE:
+            ret = ( ea->size > eb->size ) - ( ea->size < eb->size );
+            break;
+        case REMMINA_FTP_FILE_COLUMN_USER:
+            ret = g_strcmp0( ea->owner, eb->owner );
+            break;
+        case REMMINA_FTP_FILE_COLUMN_GROUP:
+            ret = g_strcmp0( ea->group, eb->group );
+            break;
+        case REMMINA_FTP_FILE_COLUMN_PERMISSION:
+            ret = ea->permission - eb->permission;
+            break;
+    }
+    if( ret == 0 )
+        ret = strcmp( ea->key, eb->key );
+    return model->sort_order == GTK_SORT_DESCENDING ? -ret : ret;
+}
+
+/* Sort the visible rows from position start on and merge them with the ones before it,
+ * which must already be sorted. Returns the new order, as old positions, or NULL if
+ * nothing moved */
+static gint *remmina_ftp_file_model_sort_rows( RemminaFTPFileModel *model, guint start )
+{
+    TRACE_CALL( __func__ );
+    guint n = model->rows->len;
+    GArray *rows;
+    gint *order, *merged;
+    guint i, j, k;
+
+    model->sorted_rows = n;
+    if( model->sort_column < 0 || start >= n || n < 2 )
+        return NULL;
+
+    order = g_new( gint, n );
+    for( i = 0; i < n; i++ )
+        order[i] = i;
+    g_qsort_with_data( order + start, n - start, sizeof( gint ), remmina_ftp_file_model_compare, model );
+
+    if( start > 0 )
+    {
+        merged = g_new( gint, n );
+        for( i = 0, j = start, k = 0; k < n; k++ )
+        {
+            if( j >= n || ( i < start && remmina_ftp_file_model_compare( &order[i], &order[j], model ) <= 0 ) )
+                merged[k] = order[i++];
+            else
+                merged[k] = order[j++];
+        }
+        g_free( order );
+        order = merged;
+    }
+
+    for( i = 0; i < n && order[i] == (gint)i; i++ )
+        ;
+    if( i == n )
+    {
+        g_free( order );
+        return NULL;
+    }
+
+    rows = g_array_sized_new( FALSE, FALSE, sizeof( guint ), n );
+    for( i = 0; i < n; i++ )
+        g_array_append_val( rows, g_array_index( model->rows, guint, order[i] ) );
+    g_array_free( model->rows, TRUE );
+    model->rows = rows;
+    model->stamp++;
+    return order;
+}
+
+static void remmina_ftp_file_model_resort( RemminaFTPFileModel *model, guint start )
+{
+    TRACE_CALL( __func__ );
+    GtkTreePath *path;
+    gint *order;
+
+    order = remmina_ftp_file_model_sort_rows( model, start );
+    if( !order )
+        return;
+    path = gtk_tree_path_new();
+    gtk_tree_model_rows_reordered_with_length( GTK_TREE_MODEL( model ), path, NULL, order, model->rows->len );
+    gtk_tree_path_free( path );
+    g_free( order );
+}
+
+static gboolean remmina_ftp_file_model_sort_idle( gpointer data )
+{
+    TRACE_CALL( __func__ );
+    RemminaFTPFileModel *model = REMMINA_FTP_FILE_MODEL( data );
+
+    model->sort_source = 0;
+    remmina_ftp_file_model_resort( model, model->sorted_rows );
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+remmina_ftp_file_model_get_sort_column_id( GtkTreeSortable *sortable, gint *sort_column_id, GtkSortType *order )
+{
+    RemminaFTPFileModel *model = REMMINA_FTP_FILE_MODEL( sortable );
+
+    if( sort_column_id )
+        *sort_column_id = model->sort_column;
+    if( order )
+        *order = model->sort_order;
+    return model->sort_column >= 0;
+}
+
+static void
+remmina_ftp_file_model_set_sort_column_id( GtkTreeSortable *sortable, gint sort_column_id, GtkSortType order )
+{
+    TRACE_CALL( __func__ );
+    RemminaFTPFileModel *model = REMMINA_FTP_FILE_MODEL( sortable );
+
+    if( model->sort_column == sort_column_id && model->sort_order == order )
+        return;
+    model->sort_column = sort_column_id;
+    model->sort_order = order;
+    gtk_tree_sortable_sort_column_changed( sortable );
+    remmina_ftp_file_model_resort( model, 0 );
+}
+
+static void remmina_ftp_file_model_set_sort_func( GtkTreeSortable *sortable,
+                                                  gint sort_column_id,
+                                                  GtkTreeIterCompareFunc func,
+                                                  gpointer data,
+                                                  GDestroyNotify destroy )
+{
+    REMMINA_WARNING( "RemminaFTPFileModel only sorts by its own columns" );
+}
+
+static void remmina_ftp_file_model_set_default_sort_func( GtkTreeSortable *sortable,
+                                                          GtkTreeIterCompareFunc func,
+                                                          gpointer data,
+                                                          GDestroyNotify destroy )
+{
+    REMMINA_WARNING( "RemminaFTPFileModel only sorts by its own columns" );
+}
+
+static gboolean remmina_ftp_file_model_has_default_sort_func( GtkTreeSortable *sortable )
+{
+    return FALSE;
+}
+
+static void remmina_ftp_file_model_sortable_init( GtkTreeSortableIface *iface )
+{
+    iface->get_sort_column_id = remmina_ftp_file_model_get_sort_column_id;
+    iface->set_sort_column_id = remmina_ftp_file_model_set_sort_column_id;
+    iface->set_sort_func = remmina_ftp_file_model_set_sort_func;
+    iface->set_default_sort_func = remmina_ftp_file_model_set_default_sort_func;
+    iface->has_default_sort_func = remmina_ftp_file_model_has_default_sort_func;
+}
+
+static void remmina_ftp_file_model_finalize( GObject *object )
+{
+    TRACE_CALL( __func__ );
+    RemminaFTPFileModel *model = REMMINA_FTP_FILE_MODEL( object );
+
+    if( model->sort_source )
+        g_source_remove( model->sort_source );
+    g_array_free( model->entries, TRUE );
+    g_array_free( model->rows, TRUE );
+    g_string_chunk_free( model->strings );
+
+    G_OBJECT_CLASS( remmina_ftp_file_model_parent_class )->finalize( object );
+}
+
+static void remmina_ftp_file_model_class_init( RemminaFTPFileModelClass *klass )
+{
+    TRACE_CALL( __func__ );
+    G_OBJECT_CLASS( klass )->finalize = remmina_ftp_file_model_finalize;
+}
+
+static void remmina_ftp_file_model_init( RemminaFTPFileModel *model )
+{
+    TRACE_CALL( __func__ );
+    model->entries = g_array_new( FALSE, FALSE, sizeof( RemminaFTPFileEntry ) );
+    model->rows = g_array_new( FALSE, FALSE, sizeof( guint ) );
+    model->strings = g_string_chunk_new( 64 * 1024 );
+    model->stamp = g_random_int();
+    model->sort_column = REMMINA_FTP_FILE_COLUMN_NAME_SORT;
+    model->sort_order = GTK_SORT_ASCENDING;
+    model->show_hidden = FALSE;
+}
+
+static RemminaFTPFileModel *remmina_ftp_file_model_new()
+{
+    TRACE_CALL( __func__ );
+    return REMMINA_FTP_FILE_MODEL( g_object_new( REMMINA_TYPE_FTP_FILE_MODEL, NULL ) );
+}
+
+static bool remmina_ftp_file_model_is_visible( RemminaFTPFileModel *model, RemminaFTPFileEntry *entry )
+{
+    return model->show_hidden || entry->name[0] != '.';
+}
+
+static void remmina_ftp_file_model_append( RemminaFTPFileModel *model,
+                                           gint type,
+                                           const char *name,
+                                           gfloat size,
+                                           const char *owner,
+                                           const char *group,
+                                           gint permission )
+{
+    TRACE_CALL( __func__ );
+    RemminaFTPFileEntry entry;
+    GtkTreePath *path;
+    GtkTreeIter iter;
+    char *key, *tmp;
+    guint index;
+
+    if( !name )
+        name = "";
+    key = g_utf8_collate_key_for_filename( name, -1 );
+    tmp = g_strdup_printf( "%i%s", type, key );
+    entry.name = g_string_chunk_insert( model->strings, name );
+    entry.key = g_string_chunk_insert( model->strings, tmp );
+    entry.owner = g_intern_string( owner );
+    entry.group = g_intern_string( group );
+    entry.size = size;
+    entry.permission = permission;
+    entry.type = type;
+    g_free( tmp );
+    g_free( key );
+
+    g_array_append_val( model->entries, entry );
+    if( !remmina_ftp_file_model_is_visible( model, &entry ) )
+        return;
+
+    index = model->entries->len - 1;
+    g_array_append_val( model->rows, index );
+    remmina_ftp_file_model_set_iter( model, &iter, model->rows->len - 1 );
+    path = gtk_tree_path_new_from_indices( model->rows->len - 1, -1 );
+    gtk_tree_model_row_inserted( GTK_TREE_MODEL( model ), path, &iter );
+    gtk_tree_path_free( path );
+
+    /* Sort everything appended in this main loop iteration at once, before it is drawn */
+    if( !model->sort_source && model->sort_column >= 0 )
+        model->sort_source =
+            g_idle_add_full( G_PRIORITY_HIGH_IDLE, remmina_ftp_file_model_sort_idle, model, NULL );
+}
+
+static void remmina_ftp_file_model_remove_rows( RemminaFTPFileModel *model )
+{
+    TRACE_CALL( __func__ );
+    GtkTreePath *path;
+
+    if( model->sort_source )
+    {
+        g_source_remove( model->sort_source );
+        model->sort_source = 0;
+    }
+
+    /* Removing from the end does not move the remaining rows */
+    while( model->rows->len > 0 )
+    {
+        g_array_set_size( model->rows, model->rows->len - 1 );
+        path = gtk_tree_path_new_from_indices( model->rows->len, -1 );
+        gtk_tree_model_row_deleted( GTK_TREE_MODEL( model ), path );
+        gtk_tree_path_free( path );
+    }
+    model->sorted_rows = 0;
+    model->stamp++;
+}
+
+static void remmina_ftp_file_model_clear( RemminaFTPFileModel *model )
+{
+    TRACE_CALL( __func__ );
+    remmina_ftp_file_model_remove_rows( model );
+    g_array_set_size( model->entries, 0 );
+    g_string_chunk_clear( model->strings );
+}
+
+static void remmina_ftp_file_model_set_show_hidden( RemminaFTPFileModel *model, bool show_hidden )
+{
+    TRACE_CALL( __func__ );
+    GtkTreePath *path;
+    GtkTreeIter iter;
+    guint i;
+
+    if( model->show_hidden == show_hidden )
+        return;
+
+    remmina_ftp_file_model_remove_rows( model );
+    model->show_hidden = show_hidden;
+    for( i = 0; i < model->entries->len; i++ )
+    {
+        if( remmina_ftp_file_model_is_visible( model, &g_array_index( model->entries, RemminaFTPFileEntry, i ) ) )
+            g_array_append_val( model->rows, i );
+    }
+    g_free( remmina_ftp_file_model_sort_rows( model, 0 ) );
+
+    for( i = 0; i < model->rows->len; i++ )
+    {
+        remmina_ftp_file_model_set_iter( model, &iter, i );
+        path = gtk_tree_path_new_from_indices( i, -1 );
+        gtk_tree_model_row_inserted( GTK_TREE_MODEL( model ), path, &iter );
+        gtk_tree_path_free( path );
+    }
+}
+
 /* --------------------- RemminaFTPClient ----------------------------*/
 G_DEFINE_TYPE( RemminaFTPClient, remmina_ftp_client, GTK_TYPE_GRID )
 
@@ -148,14 +657,16 @@ struct RemminaFTPClientPriv
     GtkWidget *directory_combo;
     GtkWidget *vpaned;
 
-    GtkTreeModel *file_list_model;
-    GtkTreeModel *file_list_filter;
-    GtkTreeModel *file_list_sort;
+    RemminaFTPFileModel *file_list_model;
     GtkWidget *file_list_view;
     bool file_list_show_hidden;
 
     GtkTreeModel *task_list_model;
     GtkWidget *task_list_view;
+    /* Index over task_list_model, which relies on its iters being persistent:
+     * ids of waiting tasks in FIFO order, and the row of every task by id */
+    GQueue *task_waiting;
+    GHashTable *task_rows;
 
     char *current_directory;
     char *working_directory;
@@ -234,6 +745,8 @@ static void remmina_ftp_client_destroy( RemminaFTPClient *client, gpointer data
     RemminaFTPClientPriv *priv = (RemminaFTPClientPriv *)client->priv;
     g_free( priv->current_directory );
     g_free( priv->working_directory );
+    g_queue_free( priv->task_waiting );
+    g_hash_table_destroy( priv->task_rows );
     g_free( priv );
 }
 
@@ -297,6 +810,38 @@ static char *remmina_ftp_client_size_to_str( gfloat size )
     return g_format_size_full( (guint64)size, G_FORMAT_SIZE_IEC_UNITS );
 }
 
+/* Fixed width sizing spares the view from measuring every row of very large folders,
+ * the width comes from a typical cell instead. extra is room for icons in the column. */
+static void remmina_ftp_client_column_set_fixed( GtkTreeViewColumn *column,
+                                                 GtkWidget *view,
+                                                 const char *sample,
+                                                 gint extra )
+{
+    TRACE_CALL( __func__ );
+    PangoLayout *layout;
+    gint sample_width, title_width;
+    gint xpad, padding = 0;
+    GList *renderers, *element;
+
+    layout = gtk_widget_create_pango_layout( view, sample );
+    pango_layout_get_pixel_size( layout, &sample_width, NULL );
+    pango_layout_set_text( layout, gtk_tree_view_column_get_title( column ), -1 );
+    pango_layout_get_pixel_size( layout, &title_width, NULL );
+    g_object_unref( layout );
+
+    renderers = gtk_cell_layout_get_cells( GTK_CELL_LAYOUT( column ) );
+    for( element = renderers; element; element = element->next )
+    {
+        gtk_cell_renderer_get_padding( GTK_CELL_RENDERER( element->data ), &xpad, NULL );
+        padding += 2 * xpad;
+    }
+    g_list_free( renderers );
+
+    /* The header button has its own padding and the sort arrow, about an icon */
+    gtk_tree_view_column_set_sizing( column, GTK_TREE_VIEW_COLUMN_FIXED );
+    gtk_tree_view_column_set_fixed_width( column, MAX( sample_width + extra + padding, title_width + 32 ) );
+}
+
 static void remmina_ftp_client_cell_data_size( GtkTreeViewColumn *col,
                                                GtkCellRenderer *renderer,
                                                GtkTreeModel *model,
@@ -499,6 +1044,15 @@ static char *remmina_ftp_client_get_download_dir( RemminaFTPClient *client )
     return localdir;
 }
 
+static void remmina_ftp_client_queue_task( RemminaFTPClient *client, GtkTreeIter *iter, gint taskid )
+{
+    TRACE_CALL( __func__ );
+    RemminaFTPClientPriv *priv = (RemminaFTPClientPriv *)client->priv;
+
+    g_hash_table_insert( priv->task_rows, GINT_TO_POINTER( taskid ), g_memdup2( iter, sizeof( GtkTreeIter ) ) );
+    g_queue_push_tail( priv->task_waiting, GINT_TO_POINTER( taskid ) );
+}
+
 static void remmina_ftp_client_download( RemminaFTPClient *client, GtkTreeIter *piter, const char *localdir )
 {
     TRACE_CALL( __func__ );
@@ -508,8 +1062,9 @@ static void remmina_ftp_client_download( RemminaFTPClient *client, GtkTreeIter *
     gint type;
     char *name;
     gfloat size;
+    gint taskid = remmina_ftp_client_taskid++;
 
-    gtk_tree_model_get( priv->file_list_sort,
+    gtk_tree_model_get( GTK_TREE_MODEL( priv->file_list_model ),
                         piter,
                         REMMINA_FTP_FILE_COLUMN_TYPE,
                         &type,
@@ -529,7 +1084,7 @@ static void remmina_ftp_client_download( RemminaFTPClient *client, GtkTreeIter *
                         REMMINA_FTP_TASK_COLUMN_SIZE,
                         size,
                         REMMINA_FTP_TASK_COLUMN_TASKID,
-                        remmina_ftp_client_taskid++,
+                        taskid,
                         REMMINA_FTP_TASK_COLUMN_TASKTYPE,
                         REMMINA_FTP_TASK_TYPE_DOWNLOAD,
                         REMMINA_FTP_TASK_COLUMN_REMOTEDIR,
@@ -543,6 +1098,7 @@ static void remmina_ftp_client_download( RemminaFTPClient *client, GtkTreeIter *
                         REMMINA_FTP_TASK_COLUMN_TOOLTIP,
                         NULL,
                         -1 );
+    remmina_ftp_client_queue_task( client, &iter, taskid );
 
     g_free( name );
 
@@ -626,7 +1182,7 @@ static void remmina_ftp_client_action_download( GObject *object, RemminaFTPClien
     list_iter = g_list_first( list );
     while( list_iter )
     {
-        gtk_tree_model_get_iter( priv->file_list_sort, &iter, (GtkTreePath *)list_iter->data );
+        gtk_tree_model_get_iter( GTK_TREE_MODEL( priv->file_list_model ), &iter, (GtkTreePath *)list_iter->data );
         remmina_ftp_client_download( client, &iter, localdir );
         list_iter = g_list_next( list_iter );
     }
@@ -670,10 +1226,15 @@ static void remmina_ftp_client_action_delete( GObject *object, RemminaFTPClient
     list_iter = g_list_first( list );
     while( list_iter )
     {
-        gtk_tree_model_get_iter( priv->file_list_sort, &iter, (GtkTreePath *)list_iter->data );
+        gtk_tree_model_get_iter( GTK_TREE_MODEL( priv->file_list_model ), &iter, (GtkTreePath *)list_iter->data );
 
-        gtk_tree_model_get(
-            priv->file_list_sort, &iter, REMMINA_FTP_FILE_COLUMN_TYPE, &type, REMMINA_FTP_FILE_COLUMN_NAME, &name, -1 );
+        gtk_tree_model_get( GTK_TREE_MODEL( priv->file_list_model ),
+                            &iter,
+                            REMMINA_FTP_FILE_COLUMN_TYPE,
+                            &type,
+                            REMMINA_FTP_FILE_COLUMN_NAME,
+                            &name,
+                            -1 );
 
         path = remmina_public_combine_path( priv->current_directory, name );
         g_signal_emit( G_OBJECT( client ), remmina_ftp_client_signals[DELETE_FILE_SIGNAL], 0, type, path, &ret );
@@ -715,6 +1276,7 @@ static void remmina_ftp_client_action_upload( GObject *object, RemminaFTPClient
     GSList *element;
     char *path;
     char *dir, *name;
+    gint taskid;
     struct stat st;
 
     dialog = gtk_file_chooser_dialog_new( _( "Choose a file to upload" ),
@@ -766,6 +1328,7 @@ static void remmina_ftp_client_action_upload( GObject *object, RemminaFTPClient
             dir = NULL;
         }
 
+        taskid = remmina_ftp_client_taskid++;
         gtk_list_store_append( store, &iter );
         gtk_list_store_set( store,
                             &iter,
@@ -776,7 +1339,7 @@ static void remmina_ftp_client_action_upload( GObject *object, RemminaFTPClient
                             REMMINA_FTP_TASK_COLUMN_SIZE,
                             (gfloat)st.st_size,
                             REMMINA_FTP_TASK_COLUMN_TASKID,
-                            remmina_ftp_client_taskid++,
+                            taskid,
                             REMMINA_FTP_TASK_COLUMN_TASKTYPE,
                             REMMINA_FTP_TASK_TYPE_UPLOAD,
                             REMMINA_FTP_TASK_COLUMN_REMOTEDIR,
@@ -790,6 +1353,7 @@ static void remmina_ftp_client_action_upload( GObject *object, RemminaFTPClient
                             REMMINA_FTP_TASK_COLUMN_TOOLTIP,
                             NULL,
                             -1 );
+        remmina_ftp_client_queue_task( client, &iter, taskid );
 
         g_free( path );
     }
@@ -855,8 +1419,8 @@ remmina_ftp_client_file_list_on_button_press( GtkWidget *widget, GdkEventButton
             gtk_tree_view_get_selection( GTK_TREE_VIEW( priv->file_list_view ) ), NULL );
         if( list )
         {
-            gtk_tree_model_get_iter( priv->file_list_sort, &iter, (GtkTreePath *)list->data );
-            gtk_tree_model_get( priv->file_list_sort,
+            gtk_tree_model_get_iter( GTK_TREE_MODEL( priv->file_list_model ), &iter, (GtkTreePath *)list->data );
+            gtk_tree_model_get( GTK_TREE_MODEL( priv->file_list_model ),
                                 &iter,
                                 REMMINA_FTP_FILE_COLUMN_TYPE,
                                 &type,
@@ -906,6 +1470,8 @@ remmina_ftp_client_task_list_cell_on_activate( GtkCellRenderer *renderer, char *
 
     if( ret )
     {
+        /* A waiting task is left in task_waiting, it is skipped when its row is not found */
+        g_hash_table_remove( priv->task_rows, GINT_TO_POINTER( taskid ) );
         gtk_list_store_remove( GTK_LIST_STORE( priv->task_list_model ), &iter );
     }
 }
@@ -963,25 +1529,7 @@ void remmina_ftp_client_set_show_hidden( RemminaFTPClient *client, bool show_hid
 {
     TRACE_CALL( __func__ );
     client->priv->file_list_show_hidden = show_hidden;
-    gtk_tree_model_filter_refilter( GTK_TREE_MODEL_FILTER( client->priv->file_list_filter ) );
-}
-
-static int remmina_ftp_client_filter_visible_func( GtkTreeModel *model, GtkTreeIter *iter, RemminaFTPClient *client )
-{
-    TRACE_CALL( __func__ );
-    char *name;
-    bool result = TRUE;
-
-    if( client->priv->file_list_show_hidden )
-        return TRUE;
-
-    gtk_tree_model_get( model, iter, REMMINA_FTP_FILE_COLUMN_NAME, &name, -1 );
-    if( name && name[0] == '.' )
-    {
-        result = FALSE;
-    }
-    g_free( name );
-    return result;
+    remmina_ftp_file_model_set_show_hidden( client->priv->file_list_model, show_hidden );
 }
 
 /* Set the overwrite_all status */
@@ -1023,6 +1571,8 @@ static void remmina_ftp_client_init( RemminaFTPClient *client )
     GtkCellRenderer *renderer;
     GtkTreeViewColumn *column;
     GtkWidget *vbox;
+    char *size_sample;
+    gint icon_width;
 
     priv = g_new0( RemminaFTPClientPriv, 1 );
     client->priv = priv;
@@ -1121,26 +1671,28 @@ static void remmina_ftp_client_init( RemminaFTPClient *client )
     gtk_tree_view_column_set_sort_column_id( column, REMMINA_FTP_FILE_COLUMN_PERMISSION );
     gtk_tree_view_append_column( GTK_TREE_VIEW( priv->file_list_view ), column );
 
-    /* Remote File List - Model */
-    priv->file_list_model = GTK_TREE_MODEL( gtk_list_store_new( REMMINA_FTP_FILE_N_COLUMNS,
-                                                                G_TYPE_INT,
-                                                                G_TYPE_STRING,
-                                                                G_TYPE_FLOAT,
-                                                                G_TYPE_STRING,
-                                                                G_TYPE_STRING,
-                                                                G_TYPE_INT,
-                                                                G_TYPE_STRING ) );
-
-    priv->file_list_filter = gtk_tree_model_filter_new( priv->file_list_model, NULL );
-    gtk_tree_model_filter_set_visible_func( GTK_TREE_MODEL_FILTER( priv->file_list_filter ),
-                                            (GtkTreeModelFilterVisibleFunc)remmina_ftp_client_filter_visible_func,
-                                            client,
-                                            NULL );
+    /* Fixed height rows need fixed width columns */
+    gtk_icon_size_lookup( GTK_ICON_SIZE_MENU, &icon_width, NULL );
+    size_sample = remmina_ftp_client_size_to_str( 1023.9 * 1024 * 1024 );
+    remmina_ftp_client_column_set_fixed( gtk_tree_view_get_column( GTK_TREE_VIEW( priv->file_list_view ), 0 ),
+                                         priv->file_list_view,
+                                         "a-typical-file-name-1.0.tar.gz",
+                                         icon_width );
+    remmina_ftp_client_column_set_fixed(
+        gtk_tree_view_get_column( GTK_TREE_VIEW( priv->file_list_view ), 1 ), priv->file_list_view, size_sample, 0 );
+    remmina_ftp_client_column_set_fixed(
+        gtk_tree_view_get_column( GTK_TREE_VIEW( priv->file_list_view ), 2 ), priv->file_list_view, "username", 0 );
+    remmina_ftp_client_column_set_fixed(
+        gtk_tree_view_get_column( GTK_TREE_VIEW( priv->file_list_view ), 3 ), priv->file_list_view, "username", 0 );
+    remmina_ftp_client_column_set_fixed(
+        gtk_tree_view_get_column( GTK_TREE_VIEW( priv->file_list_view ), 4 ), priv->file_list_view, "drwxr-xr-x", 0 );
+    g_free( size_sample );
+    gtk_tree_view_set_fixed_height_mode( GTK_TREE_VIEW( priv->file_list_view ), TRUE );
 
-    priv->file_list_sort = gtk_tree_model_sort_new_with_model( priv->file_list_filter );
-    gtk_tree_sortable_set_sort_column_id(
-        GTK_TREE_SORTABLE( priv->file_list_sort ), REMMINA_FTP_FILE_COLUMN_NAME_SORT, GTK_SORT_ASCENDING );
-    gtk_tree_view_set_model( GTK_TREE_VIEW( priv->file_list_view ), priv->file_list_sort );
+    /* Remote File List - Model */
+    priv->file_list_model = remmina_ftp_file_model_new();
+    gtk_tree_view_set_model( GTK_TREE_VIEW( priv->file_list_view ), GTK_TREE_MODEL( priv->file_list_model ) );
+    g_object_unref( priv->file_list_model );
 
     /* Task List */
     scrolledwindow = gtk_scrolled_window_new( NULL, NULL );
@@ -1224,6 +1776,8 @@ static void remmina_ftp_client_init( RemminaFTPClient *client )
                                                                 G_TYPE_FLOAT,
                                                                 G_TYPE_STRING ) );
     gtk_tree_view_set_model( GTK_TREE_VIEW( priv->task_list_view ), priv->task_list_model );
+    priv->task_waiting = g_queue_new();
+    priv->task_rows = g_hash_table_new_full( g_direct_hash, g_direct_equal, NULL, g_free );
 
     /* Setup the internal signals */
     g_signal_connect( G_OBJECT( client ), "destroy", G_CALLBACK( remmina_ftp_client_destroy ), NULL );
@@ -1289,7 +1843,7 @@ void remmina_ftp_client_clear_file_list( RemminaFTPClient *client )
     TRACE_CALL( __func__ );
     RemminaFTPClientPriv *priv = (RemminaFTPClientPriv *)client->priv;
 
-    gtk_list_store_clear( GTK_LIST_STORE( priv->file_list_model ) );
+    remmina_ftp_file_model_clear( priv->file_list_model );
     remmina_ftp_client_set_file_action_sensitive( client, FALSE );
 }
 
@@ -1297,25 +1851,47 @@ void remmina_ftp_client_add_file( RemminaFTPClient *client, ... )
 {
     TRACE_CALL( __func__ );
     RemminaFTPClientPriv *priv = (RemminaFTPClientPriv *)client->priv;
-    GtkListStore *store = GTK_LIST_STORE( priv->file_list_model );
-    GtkTreeIter iter;
     va_list args;
-    gint type;
-    char *name;
-    char *ptr;
+    gint column;
+    gint type = REMMINA_FTP_FILE_TYPE_FILE;
+    const char *name = NULL;
+    gfloat size = 0;
+    const char *owner = NULL;
+    const char *group = NULL;
+    gint permission = 0;
 
     va_start( args, client );
-    gtk_list_store_append( store, &iter );
-    gtk_list_store_set_valist( store, &iter, args );
+    while( ( column = va_arg( args, gint ) ) != -1 )
+    {
+        switch( column )
+        {
+            case REMMINA_FTP_FILE_COLUMN_TYPE:
+                type = va_arg( args, gint );
+                break;
+            case REMMINA_FTP_FILE_COLUMN_NAME:
+                name = va_arg( args, const char * );
+                break;
+            case REMMINA_FTP_FILE_COLUMN_SIZE:
+                size = (gfloat)va_arg( args, gdouble );
+                break;
+            case REMMINA_FTP_FILE_COLUMN_USER:
+                owner = va_arg( args, const char * );
+                break;
+            case REMMINA_FTP_FILE_COLUMN_GROUP:
+                group = va_arg( args, const char * );
+                break;
+            case REMMINA_FTP_FILE_COLUMN_PERMISSION:
+                permission = va_arg( args, gint );
+                break;
+            default:
+                /* REMMINA_FTP_FILE_COLUMN_NAME_SORT is computed by the model */
+                va_arg( args, const char * );
+                break;
+        }
+    }
     va_end( args );
 
-    gtk_tree_model_get(
-        GTK_TREE_MODEL( store ), &iter, REMMINA_FTP_FILE_COLUMN_TYPE, &type, REMMINA_FTP_FILE_COLUMN_NAME, &name, -1 );
-
-    ptr = g_strdup_printf( "%i%s", type, name );
-    gtk_list_store_set( store, &iter, REMMINA_FTP_FILE_COLUMN_NAME_SORT, ptr, -1 );
-    g_free( ptr );
-    g_free( name );
+    remmina_ftp_file_model_append( priv->file_list_model, type, name, size, owner, group, permission );
 }
 
 void remmina_ftp_client_set_dir( RemminaFTPClient *client, const char *dir )
@@ -1362,9 +1938,9 @@ RemminaFTPTask *remmina_ftp_client_get_waiting_task( RemminaFTPClient *client )
 {
     TRACE_CALL( __func__ );
     RemminaFTPClientPriv *priv = (RemminaFTPClientPriv *)client->priv;
-    GtkTreePath *path;
-    GtkTreeIter iter;
+    GtkTreeIter *iter;
     RemminaFTPTask task;
+    gint taskid;
 
     if( !remmina_masterthread_exec_is_main_thread() )
     {
@@ -1380,13 +1956,14 @@ RemminaFTPTask *remmina_ftp_client_get_waiting_task( RemminaFTPClient *client )
         return retval;
     }
 
-    if( !gtk_tree_model_get_iter_first( priv->task_list_model, &iter ) )
-        return NULL;
-
-    while( 1 )
+    while( !g_queue_is_empty( priv->task_waiting ) )
     {
+        taskid = GPOINTER_TO_INT( g_queue_pop_head( priv->task_waiting ) );
+        iter = (GtkTreeIter *)g_hash_table_lookup( priv->task_rows, GINT_TO_POINTER( taskid ) );
+        if( !iter )
+            continue;
         gtk_tree_model_get( priv->task_list_model,
-                            &iter,
+                            iter,
                             REMMINA_FTP_TASK_COLUMN_TYPE,
                             &task.type,
                             REMMINA_FTP_TASK_COLUMN_NAME,
@@ -1409,14 +1986,11 @@ RemminaFTPTask *remmina_ftp_client_get_waiting_task( RemminaFTPClient *client )
                             &task.tooltip,
                             -1 );
         if( task.status == REMMINA_FTP_TASK_STATUS_WAIT )
-        {
-            path = gtk_tree_model_get_path( priv->task_list_model, &iter );
-            task.rowref = gtk_tree_row_reference_new( priv->task_list_model, path );
-            gtk_tree_path_free( path );
             return (RemminaFTPTask *)g_memdup2( &task, sizeof( RemminaFTPTask ) );
-        }
-        if( !gtk_tree_model_iter_next( priv->task_list_model, &iter ) )
-            break;
+        g_free( task.name );
+        g_free( task.remotedir );
+        g_free( task.localdir );
+        g_free( task.tooltip );
     }
 
     return NULL;
@@ -1427,8 +2001,7 @@ void remmina_ftp_client_update_task( RemminaFTPClient *client, RemminaFTPTask *t
     TRACE_CALL( __func__ );
     RemminaFTPClientPriv *priv = (RemminaFTPClientPriv *)client->priv;
     GtkListStore *store = GTK_LIST_STORE( priv->task_list_model );
-    GtkTreePath *path;
-    GtkTreeIter iter;
+    GtkTreeIter *iter;
 
     if( !remmina_masterthread_exec_is_main_thread() )
     {
@@ -1443,13 +2016,11 @@ void remmina_ftp_client_update_task( RemminaFTPClient *client, RemminaFTPTask *t
         return;
     }
 
-    path = gtk_tree_row_reference_get_path( task->rowref );
-    if( path == NULL )
+    iter = (GtkTreeIter *)g_hash_table_lookup( priv->task_rows, GINT_TO_POINTER( task->taskid ) );
+    if( iter == NULL )
         return;
-    gtk_tree_model_get_iter( priv->task_list_model, &iter, path );
-    gtk_tree_path_free( path );
     gtk_list_store_set( store,
-                        &iter,
+                        iter,
                         REMMINA_FTP_TASK_COLUMN_SIZE,
                         task->size,
                         REMMINA_FTP_TASK_COLUMN_STATUS,
@@ -125,7 +125,6 @@ struct RemminaFTPTask
     gint tasktype;
     char *remotedir;
     char *localdir;
-    GtkTreeRowReference *rowref;
     /* Updatable */
     gfloat size;
     gint status;
@@ -0,0 +1,237 @@
+/*
+ * Remmina - The GTK+ Remote Desktop Client
+ * Copyright (C) 2016-2022 Antenore Gatta, Giovanni Panozzo
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ *
+ *  In addition, as a special exception, the copyright holders give
+ *  permission to link the code of portions of this program with the
+ *  OpenSSL library under certain conditions as described in each
+ *  individual source file, and distribute linked combinations
+ *  including the two.
+ *  You must obey the GNU General Public License in all respects
+ *  for all of the code used other than OpenSSL. *  If you modify
+ *  file(s) with this exception, you may extend this exception to your
+ *  version of the file(s), but you are not obligated to do so. *  If you
+ *  do not wish to do so, delete this exception statement from your
+ *  version. *  If you delete this exception statement from all source
+ *  files in the program, then also delete it here.
+ *
+ */
+
+
+/* Batch launcher used by autostart and by "remmina -c a.remmina -c b.remmina ...".
+ *
+ * Opening a profile is mostly waiting: DNS, TCP handshake, SSH tunnel and
+ * authentication all happen in the plugin thread, each one paying the full
+ * round trip. Every profile has its own plugin thread, so by default all of
+ * them are opened at once and the waits overlap. No DNS or SSH work is done
+ * ahead of the plugins: they resolve and verify the host themselves, and an
+ * SSH tunnel may need credentials only the connection window can ask for.
+ *
+ * launcher_max_parallel in remmina.pref optionally caps the profiles in flight,
+ * for hosts that throttle bursts of logins. A job then holds its slot until the
+ * protocol widget reports "connect" or "disconnect", or until
+ * REMMINA_LAUNCHER_SLOT_TIMEOUT expires, so that a profile stuck on an
+ * authentication prompt does not stall the whole batch.
+ *
+ * Either way, how long each profile waited and took to connect is logged.
+ * A single profile is opened directly. */
+
+#include "config.h"
+#include <gtk/gtk.h>
+#include "remmina/remmina_trace_calls.hpp"
+#include "remmina_file.hpp"
+#include "remmina_file_manager.hpp"
+#include "remmina_launcher.hpp"
+#include "remmina_log.hpp"
+#include "remmina_pref.hpp"
+#include "rcw.hpp"
+
+#define REMMINA_LAUNCHER_SLOT_TIMEOUT 30
+
+struct RemminaLauncherJob
+{
+    char *filename;
+    GtkWidget *proto;
+    gulong connect_handler;
+    gulong disconnect_handler;
+    guint timeout_source;
+    gint64 queued_at;
+    gint64 started_at;
+};
+
+static GQueue launcher_queue = G_QUEUE_INIT;
+static gint launcher_running = 0;
+static gint launcher_batch_count = 0;
+static gint64 launcher_batch_start = 0;
+
+static void remmina_launcher_schedule( void );
+
+static void remmina_launcher_job_free( RemminaLauncherJob *job )
+{
+    TRACE_CALL( __func__ );
+    g_free( job->filename );
+    g_free( job );
+}
+
+static void remmina_launcher_job_done( RemminaLauncherJob *job, const char *result )
+{
+    TRACE_CALL( __func__ );
+    gint64 now = g_get_monotonic_time();
+
+    if( job->timeout_source )
+    {
+        g_source_remove( job->timeout_source );
+        job->timeout_source = 0;
+    }
+    if( job->proto )
+    {
+        g_signal_handler_disconnect( job->proto, job->connect_handler );
+        g_signal_handler_disconnect( job->proto, job->disconnect_handler );
+        g_object_remove_weak_pointer( G_OBJECT( job->proto ), (gpointer *)&job->proto );
+        job->proto = NULL;
+    }
+
+    if( job->started_at )
+        REMMINA_INFO( "Launcher: %s waited %" G_GINT64_FORMAT " ms, %s after %" G_GINT64_FORMAT " ms",
+                      job->filename,
+                      ( job->started_at - job->queued_at ) / 1000,
+                      result,
+                      ( now - job->started_at ) / 1000 );
+    else
+        REMMINA_INFO( "Launcher: %s %s", job->filename, result );
+
+    remmina_launcher_job_free( job );
+    launcher_running--;
+    remmina_launcher_schedule();
+}
+
+static void remmina_launcher_on_connect( GtkWidget *widget, RemminaLauncherJob *job )
+{
+    TRACE_CALL( __func__ );
+    remmina_launcher_job_done( job, "connected" );
+}
+
+static void remmina_launcher_on_disconnect( GtkWidget *widget, RemminaLauncherJob *job )
+{
+    TRACE_CALL( __func__ );
+    remmina_launcher_job_done( job, "disconnected" );
+}
+
+static gboolean remmina_launcher_on_timeout( gpointer data )
+{
+    TRACE_CALL( __func__ );
+    RemminaLauncherJob *job = (RemminaLauncherJob *)data;
+
+    /* Still waiting for credentials or for a slow host, let the next one start */
+    job->timeout_source = 0;
+    remmina_launcher_job_done(
+        job, remmina_pref.launcher_max_parallel > 0 ? "still connecting, slot released" : "still connecting" );
+    return G_SOURCE_REMOVE;
+}
+
+static void remmina_launcher_job_start( RemminaLauncherJob *job )
+{
+    TRACE_CALL( __func__ );
+    RemminaFile *remminafile;
+
+    job->started_at = g_get_monotonic_time();
+    remminafile = remmina_file_manager_load_file( job->filename );
+    if( !remminafile )
+    {
+        /* Let rcw show the usual error dialog */
+        rcw_open_from_filename( job->filename );
+        remmina_launcher_job_done( job, "could not be loaded" );
+        return;
+    }
+
+    /* rcw takes ownership of the RemminaFile */
+    job->proto = rcw_open_from_file_full( remminafile, NULL, NULL, NULL );
+    if( !job->proto )
+    {
+        remmina_launcher_job_done( job, "failed to open" );
+        return;
+    }
+
+    g_object_add_weak_pointer( G_OBJECT( job->proto ), (gpointer *)&job->proto );
+    job->connect_handler =
+        g_signal_connect( G_OBJECT( job->proto ), "connect", G_CALLBACK( remmina_launcher_on_connect ), job );
+    job->disconnect_handler =
+        g_signal_connect( G_OBJECT( job->proto ), "disconnect", G_CALLBACK( remmina_launcher_on_disconnect ), job );
+    job->timeout_source =
+        g_timeout_add_seconds( REMMINA_LAUNCHER_SLOT_TIMEOUT, remmina_launcher_on_timeout, job );
+}
+
+static void remmina_launcher_schedule( void )
+{
+    TRACE_CALL( __func__ );
+    RemminaLauncherJob *job;
+
+    while( ( remmina_pref.launcher_max_parallel <= 0 || launcher_running < remmina_pref.launcher_max_parallel )
+           && !g_queue_is_empty( &launcher_queue ) )
+    {
+        job = (RemminaLauncherJob *)g_queue_pop_head( &launcher_queue );
+        launcher_running++;
+        remmina_launcher_job_start( job );
+    }
+
+    if( launcher_running == 0 && g_queue_is_empty( &launcher_queue ) && launcher_batch_count > 0 )
+    {
+        REMMINA_INFO( "Launcher: %d profile(s) launched in %" G_GINT64_FORMAT " ms",
+                      launcher_batch_count,
+                      ( g_get_monotonic_time() - launcher_batch_start ) / 1000 );
+        launcher_batch_count = 0;
+    }
+}
+
+static gboolean remmina_launcher_schedule_idle( gpointer data )
+{
+    TRACE_CALL( __func__ );
+    RemminaLauncherJob *job;
+
+    /* A lone profile, e.g. a single -c, needs no slot bookkeeping */
+    if( launcher_running == 0 && launcher_batch_count == 1 && g_queue_get_length( &launcher_queue ) == 1 )
+    {
+        job = (RemminaLauncherJob *)g_queue_pop_head( &launcher_queue );
+        launcher_batch_count = 0;
+        rcw_open_from_filename( job->filename );
+        remmina_launcher_job_free( job );
+        return G_SOURCE_REMOVE;
+    }
+
+    remmina_launcher_schedule();
+    return G_SOURCE_REMOVE;
+}
+
+void remmina_launcher_queue( const char *filename )
+{
+    TRACE_CALL( __func__ );
+    RemminaLauncherJob *job;
+
+    if( launcher_batch_count == 0 )
+        launcher_batch_start = g_get_monotonic_time();
+    launcher_batch_count++;
+
+    job = g_new0( RemminaLauncherJob, 1 );
+    job->filename = g_strdup( filename );
+    job->queued_at = g_get_monotonic_time();
+    g_queue_push_tail( &launcher_queue, job );
+
+    /* Callers usually queue a whole batch in a loop, start it once the loop is over */
+    if( g_queue_get_length( &launcher_queue ) == 1 )
+        g_idle_add( remmina_launcher_schedule_idle, NULL );
+}
@@ -38,9 +38,29 @@
 #include <glib/gi18n.h>
 #include "remmina_public.hpp"
 #include "remmina_log.hpp"
+#include "remmina_pref.hpp"
 #include "remmina_stats.hpp"
 #include "remmina/remmina_trace_calls.hpp"
 
+/* Lines for the log window go through a bounded ring, filled without locks by
+ * any thread and drained by the GTK thread every REMMINA_LOG_DRAIN_INTERVAL ms.
+ * Lines that do not fit are counted and dropped instead of piling up. */
+#define REMMINA_LOG_RING_SIZE 8192
+#define REMMINA_LOG_DRAIN_INTERVAL 100
+
+struct RemminaLogSlot
+{
+    /* Position this slot is ready for: pos when free, pos + 1 when filled */
+    gint sequence;
+    char *line;
+};
+
+static RemminaLogSlot log_ring[REMMINA_LOG_RING_SIZE];
+static gint log_ring_head = 0;
+static guint log_ring_tail = 0;
+static gint log_ring_dropped = 0;
+static guint log_drain_source = 0;
+
 bool logstart;
 
 /***** Define the log window GUI *****/
@@ -102,10 +122,138 @@ static GtkWidget *remmina_log_window_new()
     return GTK_WIDGET( g_object_new( REMMINA_TYPE_LOG_WINDOW, NULL ) );
 }
 
+static char *remmina_log_ring_pop();
+
 static void remmina_log_end( GtkWidget *widget, gpointer data )
 {
     TRACE_CALL( __func__ );
+    char *line;
+
     log_window = NULL;
+    if( log_drain_source )
+    {
+        g_source_remove( log_drain_source );
+        log_drain_source = 0;
+    }
+    while( ( line = remmina_log_ring_pop() ) )
+        g_free( line );
+}
+
+/* Whether lines for the log window are wanted at all */
+static bool remmina_log_window_active()
+{
+    return log_window != NULL && logstart;
+}
+
+static void remmina_log_ring_init()
+{
+    static bool initialized = FALSE;
+    guint i;
+
+    if( initialized )
+        return;
+    for( i = 0; i < REMMINA_LOG_RING_SIZE; i++ )
+        log_ring[i].sequence = i;
+    initialized = TRUE;
+}
+
+/* Multiple producers: claim a position with a CAS on the head, then publish
+ * the line by advancing the slot sequence. Takes ownership of line. */
+static void remmina_log_ring_push( char *line )
+{
+    RemminaLogSlot *slot;
+    guint pos;
+    gint diff;
+
+    pos = (guint)g_atomic_int_get( &log_ring_head );
+    for( ;; )
+    {
+        slot = &log_ring[pos & ( REMMINA_LOG_RING_SIZE - 1 )];
+        diff = (gint)( (guint)g_atomic_int_get( &slot->sequence ) - pos );
+        if( diff == 0 )
+        {
+            if( g_atomic_int_compare_and_exchange( &log_ring_head, (gint)pos, (gint)( pos + 1 ) ) )
+                break;
+            pos = (guint)g_atomic_int_get( &log_ring_head );
+        }
+        else if( diff < 0 )
+        {
+            /* Full, the window is behind */
+            g_atomic_int_inc( &log_ring_dropped );
+            g_free( line );
+            return;
+        }
+        else
+        {
+            pos = (guint)g_atomic_int_get( &log_ring_head );
+        }
+    }
+    slot->line = line;
+    g_atomic_int_set( &slot->sequence, (gint)( pos + 1 ) );
+}
+
+/* Single consumer, the GTK thread */
+static char *remmina_log_ring_pop()
+{
+    RemminaLogSlot *slot;
+    char *line;
+
+    slot = &log_ring[log_ring_tail & ( REMMINA_LOG_RING_SIZE - 1 )];
+    if( (gint)( (guint)g_atomic_int_get( &slot->sequence ) - ( log_ring_tail + 1 ) ) < 0 )
+        return NULL;
+    line = slot->line;
+    slot->line = NULL;
+    g_atomic_int_set( &slot->sequence, (gint)( log_ring_tail + REMMINA_LOG_RING_SIZE ) );
+    log_ring_tail++;
+    return line;
+}
+
+static int remmina_log_drain( gpointer data )
+{
+    TRACE_CALL( __func__ );
+    GtkTextBuffer *buffer;
+    GtkTextIter start, end;
+    GString *batch;
+    char *line;
+    gint dropped, excess;
+
+    if( !log_window )
+    {
+        log_drain_source = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    batch = g_string_new( NULL );
+    while( ( line = remmina_log_ring_pop() ) )
+    {
+        g_string_append( batch, line );
+        g_free( line );
+    }
+    dropped = g_atomic_int_and( (guint *)&log_ring_dropped, 0 );
+    if( dropped > 0 )
+        g_string_append_printf( batch, "(%d log lines dropped)\n", dropped );
+
+    if( batch->len > 0 )
+    {
+        buffer = REMMINA_LOG_WINDOW( log_window )->log_buffer;
+        gtk_text_buffer_get_end_iter( buffer, &end );
+        gtk_text_buffer_insert( buffer, &end, batch->str, batch->len );
+
+        /* Keep only the last log_max_lines lines */
+        excess = gtk_text_buffer_get_line_count( buffer ) - remmina_pref.log_max_lines;
+        if( excess > 0 )
+        {
+            gtk_text_buffer_get_start_iter( buffer, &start );
+            gtk_text_buffer_get_iter_at_line( buffer, &end, excess );
+            gtk_text_buffer_delete( buffer, &start, &end );
+        }
+
+        gtk_text_buffer_get_end_iter( buffer, &end );
+        gtk_text_view_scroll_to_iter(
+            GTK_TEXT_VIEW( REMMINA_LOG_WINDOW( log_window )->log_view ), &end, 0.0, FALSE, 0.0, 0.0 );
+    }
+    g_string_free( batch, TRUE );
+    return G_SOURCE_CONTINUE;
 }
 
 static void remmina_log_start_stop( GtkSwitch *logswitch, gpointer user_data )
@@ -153,6 +301,9 @@ void remmina_log_start()
         g_signal_connect( start, "notify::active", G_CALLBACK( remmina_log_start_stop ), NULL );
         g_signal_connect( G_OBJECT( log_window ), "destroy", G_CALLBACK( remmina_log_end ), NULL );
         gtk_widget_show_all( log_window );
+
+        remmina_log_ring_init();
+        log_drain_source = g_timeout_add( REMMINA_LOG_DRAIN_INTERVAL, remmina_log_drain, NULL );
     }
 
     remmina_log_print(
@@ -169,94 +320,73 @@ int remmina_log_running()
     return ( log_window != NULL );
 }
 
-static int remmina_log_scroll_to_end( gpointer data )
+// Only prints into Remmina's own debug window. (Not stdout!)
+// See _remmina_{debug, info, error, critical, warning}
+void remmina_log_print( const char *text )
 {
     TRACE_CALL( __func__ );
-    GtkTextIter iter;
+    if( !remmina_log_window_active() )
+        return;
 
-    if( log_window )
-    {
-        gtk_text_buffer_get_end_iter( REMMINA_LOG_WINDOW( log_window )->log_buffer, &iter );
-        gtk_text_view_scroll_to_iter(
-            GTK_TEXT_VIEW( REMMINA_LOG_WINDOW( log_window )->log_view ), &iter, 0.0, FALSE, 0.0, 0.0 );
-    }
-    return FALSE;
+    remmina_log_ring_push( g_strdup( text ) );
 }
 
-static int remmina_log_print_real( gpointer data )
+/* Whether the default GLib writer prints this level, debug and info depend on G_MESSAGES_DEBUG */
+static bool remmina_log_terminal_active( GLogLevelFlags level )
 {
-    TRACE_CALL( __func__ );
-    GtkTextIter iter;
-
-    if( log_window && logstart )
-    {
-        gtk_text_buffer_get_end_iter( REMMINA_LOG_WINDOW( log_window )->log_buffer, &iter );
-        gtk_text_buffer_insert( REMMINA_LOG_WINDOW( log_window )->log_buffer, &iter, (const char *)data, -1 );
-        IDLE_ADD( remmina_log_scroll_to_end, NULL );
-    }
-    g_free( data );
-    return FALSE;
+#if GLIB_CHECK_VERSION( 2, 68, 0 )
+    return !g_log_writer_default_would_drop( level, G_LOG_DOMAIN );
+#else
+    return TRUE;
+#endif
 }
 
-// Only prints into Remmina's own debug window. (Not stdout!)
-// See _remmina_{debug, info, error, critical, warning}
-void remmina_log_print( const char *text )
+static void remmina_log_emit( GLogLevelFlags level, const char *tag, const char *fun, const char *fmt, va_list args )
 {
     TRACE_CALL( __func__ );
-    if( !log_window )
+    bool window = remmina_log_window_active();
+    char *text;
+
+    /* Nobody would read it, do not even format it */
+    if( !window && !remmina_log_terminal_active( level ) )
         return;
 
-    IDLE_ADD( remmina_log_print_real, g_strdup( text ) );
+    text = g_strdup_vprintf( fmt, args );
+
+    // always appends newline
+    if( fun )
+        g_log( G_LOG_DOMAIN, level, "(%s) - %s", fun, text );
+    else
+        g_log( G_LOG_DOMAIN, level, "%s", text );
+
+    if( window )
+    {
+        if( fun )
+            remmina_log_ring_push( g_strdup_printf( "(%s) - (%s) - %s\n", tag, fun, text ) );
+        else
+            remmina_log_ring_push( g_strdup_printf( "(%s) - %s\n", tag, text ) );
+    }
+    g_free( text );
 }
 
 void _remmina_info( const char *fmt, ... )
 {
     TRACE_CALL( __func__ );
-
     va_list args;
-    g_autofree char *text;
+
     va_start( args, fmt );
-    text = g_strdup_vprintf( fmt, args );
+    remmina_log_emit( G_LOG_LEVEL_INFO, "INFO", NULL, fmt, args );
     va_end( args );
-
-    // always appends newline
-    g_info( "%s", text );
-
-    g_autofree char *buf_tmp = g_strconcat( text, "\n", NULL );
-    /* freed in remmina_log_print_real */
-    char *bufn = g_strconcat( "(INFO) - ", buf_tmp, NULL );
-
-    if( !log_window )
-    {
-        free( bufn );
-        return;
-    }
-    IDLE_ADD( remmina_log_print_real, bufn );
 }
 
 void _remmina_message( const char *fmt, ... )
 {
     TRACE_CALL( __func__ );
-
     va_list args;
-    g_autofree char *text;
+
     va_start( args, fmt );
-    text = g_strdup_vprintf( fmt, args );
+    remmina_log_emit( G_LOG_LEVEL_MESSAGE, "MESSAGE", NULL, fmt, args );
     va_end( args );
-
-    // always appends newline
-    g_message( "%s", text );
-
-    if( !log_window )
-    {
-        return;
-    }
-
-    g_autofree char *buf_tmp = g_strconcat( text, "\n", NULL );
-    /* freed in remmina_log_print_real */
-    char *bufn = g_strconcat( "(MESSAGE) - ", buf_tmp, NULL );
-
-    IDLE_ADD( remmina_log_print_real, bufn );
 }
 
 /**
@@ -267,57 +397,21 @@ void _remmina_message( const char *fmt, ... )
 void _remmina_debug( const char *fun, const char *fmt, ... )
 {
     TRACE_CALL( __func__ );
-
     va_list args;
-    char *text;
+
     va_start( args, fmt );
-    text = g_strdup_vprintf( fmt, args );
+    remmina_log_emit( G_LOG_LEVEL_DEBUG, "DEBUG", fun, fmt, args );
     va_end( args );
-
-    g_autofree char *buf = g_strconcat( "(", fun, ") - ", text, NULL );
-    g_free( text );
-
-    // always appends newline
-    g_debug( "%s", buf );
-
-    if( !log_window )
-    {
-        return;
-    }
-
-    g_autofree char *buf_tmp = g_strconcat( buf, "\n", NULL );
-    /* freed in remmina_log_print_real */
-    char *bufn = g_strconcat( "(DEBUG) - ", buf_tmp, NULL );
-
-    IDLE_ADD( remmina_log_print_real, bufn );
 }
 
 void _remmina_warning( const char *fun, const char *fmt, ... )
 {
     TRACE_CALL( __func__ );
-
     va_list args;
-    char *text;
+
     va_start( args, fmt );
-    text = g_strdup_vprintf( fmt, args );
+    remmina_log_emit( G_LOG_LEVEL_WARNING, "WARN", fun, fmt, args );
     va_end( args );
-
-    g_autofree char *buf = g_strconcat( "(", fun, ") - ", text, NULL );
-    g_free( text );
-
-    // always appends newline
-    g_warning( "%s", buf );
-
-    if( !log_window )
-    {
-        return;
-    }
-
-    g_autofree char *buf_tmp = g_strconcat( buf, "\n", NULL );
-    /* freed in remmina_log_print_real */
-    char *bufn = g_strconcat( "(WARN) - ", buf_tmp, NULL );
-
-    IDLE_ADD( remmina_log_print_real, bufn );
 }
 
 // !!! Calling this function will crash Remmina !!!
@@ -325,57 +419,21 @@ void _remmina_warning( const char *fun, const char *fmt, ... )
 void _remmina_error( const char *fun, const char *fmt, ... )
 {
     TRACE_CALL( __func__ );
-
     va_list args;
-    char *text;
+
     va_start( args, fmt );
-    text = g_strdup_vprintf( fmt, args );
+    remmina_log_emit( G_LOG_LEVEL_ERROR, "ERROR", fun, fmt, args );
     va_end( args );
-
-    g_autofree char *buf = g_strconcat( "(", fun, ") - ", text, NULL );
-    g_free( text );
-
-    // always appends newline
-    g_error( "%s", buf );
-
-    if( !log_window )
-    {
-        return;
-    }
-
-    g_autofree char *buf_tmp = g_strconcat( buf, "\n", NULL );
-    /* freed in remmina_log_print_real */
-    char *bufn = g_strconcat( "(ERROR) - ", buf_tmp, NULL );
-
-    IDLE_ADD( remmina_log_print_real, bufn );
 }
 
 void _remmina_critical( const char *fun, const char *fmt, ... )
 {
     TRACE_CALL( __func__ );
-
     va_list args;
-    char *text;
+
     va_start( args, fmt );
-    text = g_strdup_vprintf( fmt, args );
+    remmina_log_emit( G_LOG_LEVEL_CRITICAL, "CRIT", fun, fmt, args );
     va_end( args );
-
-    g_autofree char *buf = g_strconcat( "(", fun, ") - ", text, NULL );
-    g_free( text );
-
-    // always appends newline
-    g_critical( "%s", buf );
-
-    if( !log_window )
-    {
-        return;
-    }
-
-    g_autofree char *buf_tmp = g_strconcat( buf, "\n", NULL );
-    /* freed in remmina_log_print_real */
-    char *bufn = g_strconcat( "(CRIT) - ", buf_tmp, NULL );
-
-    IDLE_ADD( remmina_log_print_real, bufn );
 }
 
 // Only prints into Remmina's own debug window. (Not stdout!)
@@ -384,16 +442,13 @@ void remmina_log_printf( const char *fmt, ... )
 {
     TRACE_CALL( __func__ );
     va_list args;
-    char *text;
 
-    if( !log_window )
+    if( !remmina_log_window_active() )
         return;
 
     va_start( args, fmt );
-    text = g_strdup_vprintf( fmt, args );
+    remmina_log_ring_push( g_strdup_vprintf( fmt, args ) );
     va_end( args );
-
-    IDLE_ADD( remmina_log_print_real, text );
 }
 
 static int remmina_log_on_keypress( GtkWidget *widget, GdkEvent *event, gpointer user_data )
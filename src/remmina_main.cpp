@@ -52,6 +52,7 @@
 #include "remmina_about.hpp"
 #include "remmina_pref.hpp"
 #include "remmina_pref_dialog.hpp"
+#include "remmina_prewarm.hpp"
 #include "remmina_widget_pool.hpp"
 #include "remmina_plugin_manager.hpp"
 #include "remmina_log.hpp"
@@ -76,9 +77,14 @@ enum
     PLUGIN_COLUMN,
     DATE_COLUMN,
     FILENAME_COLUMN,
+    LATENCY_COLUMN,
+    SEARCH_COLUMN,
     N_COLUMNS
 };
 
+/* Sort id of the quick search ranking, outside of the column range */
+#define SEARCH_SORT_COLUMN_ID 100
+
 static const char *supported_mime_types[] = { "x-scheme-handler/rdp",
                                               "x-scheme-handler/spice",
                                               "x-scheme-handler/vnc",
@@ -194,6 +200,24 @@ void remmina_main_destroy()
             gtk_widget_destroy( GTK_WIDGET( remminamain->window ) );
 
         g_object_unref( remminamain->builder );
+        remmina_monitor_set_probe_callback( remminamain->monitor, NULL, NULL );
+        if( remminamain->priv->latency_update_source )
+            g_source_remove( remminamain->priv->latency_update_source );
+        g_hash_table_destroy( remminamain->priv->latency_updates );
+        if( remminamain->priv->changed_files_source )
+            g_source_remove( remminamain->priv->changed_files_source );
+        g_hash_table_destroy( remminamain->priv->changed_files );
+        g_hash_table_destroy( remminamain->priv->file_iters );
+        g_hash_table_destroy( remminamain->priv->group_iters );
+        g_hash_table_destroy( remminamain->priv->search_rejected );
+        g_hash_table_destroy( remminamain->priv->search_scores );
+        g_free( remminamain->priv->search_text );
+        if( remminamain->priv->datadir_monitor )
+        {
+            g_file_monitor_cancel( remminamain->priv->datadir_monitor );
+            g_object_unref( remminamain->priv->datadir_monitor );
+        }
+        g_free( remminamain->priv->monitored_datadir );
         remmina_string_array_free( remminamain->priv->expanded_group );
         remminamain->priv->expanded_group = NULL;
         if( remminamain->priv->file_model )
@@ -360,6 +384,7 @@ static gboolean remmina_main_selection_func( GtkTreeSelection *selection,
     gtk_statusbar_pop( remminamain->statusbar_main, context_id );
     if( remminamain->priv->selected_filename )
     {
+        remmina_prewarm_profile( remminamain->priv->selected_filename );
         g_snprintf(
             buf, sizeof( buf ), "%s (%s)", remminamain->priv->selected_name, remminamain->priv->selected_filename );
         gtk_statusbar_push( remminamain->statusbar_main, context_id, buf );
@@ -372,188 +397,291 @@ static gboolean remmina_main_selection_func( GtkTreeSelection *selection,
     return TRUE;
 }
 
-static void remmina_main_load_file_list_callback( RemminaFile *remminafile, gpointer user_data )
+static void remmina_main_latency_cell_data_func( GtkTreeViewColumn *column,
+                                                GtkCellRenderer *renderer,
+                                                GtkTreeModel *model,
+                                                GtkTreeIter *iter,
+                                                gpointer user_data )
 {
     TRACE_CALL( __func__ );
-    GtkTreeIter iter;
-    GtkListStore *store;
-
-    store = GTK_LIST_STORE( user_data );
-    char *datetime;
+    gint latency;
+    char *text;
 
-    datetime = remmina_file_get_datetime( remminafile );
-    gtk_list_store_append( store, &iter );
-    gtk_list_store_set( store,
-                        &iter,
-                        PROTOCOL_COLUMN,
-                        remmina_file_get_icon_name( remminafile ),
-                        NAME_COLUMN,
-                        remmina_file_get_string( remminafile, "name" ),
-                        GROUP_COLUMN,
-                        remmina_file_get_string( remminafile, "group" ),
-                        SERVER_COLUMN,
-                        remmina_file_get_string( remminafile, "server" ),
-                        PLUGIN_COLUMN,
-                        remmina_file_get_string( remminafile, "protocol" ),
-                        DATE_COLUMN,
-                        datetime,
-                        FILENAME_COLUMN,
-                        remmina_file_get_filename( remminafile ),
-                        -1 );
-    g_free( datetime );
+    gtk_tree_model_get( model, iter, LATENCY_COLUMN, &latency, -1 );
+    if( latency >= 0 )
+    {
+        // TRANSLATORS: Round trip time of a TCP connection, in milliseconds
+        text = g_strdup_printf( _( "%d ms" ), latency );
+        g_object_set( renderer, "text", text, NULL );
+        g_free( text );
+    }
+    else if( latency == REMMINA_MONITOR_LATENCY_UNREACHABLE )
+        g_object_set( renderer, "text", _( "Offline" ), NULL );
+    else
+        g_object_set( renderer, "text", "", NULL );
 }
 
-static int remmina_main_load_file_tree_traverse( GNode *node, GtkTreeStore *store, GtkTreeIter *parent )
+static int remmina_main_apply_latency_func( GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, gpointer data )
 {
     TRACE_CALL( __func__ );
-    GtkTreeIter *iter;
-    RemminaGroupData *data;
-    GNode *child;
+    char *filename;
+    gpointer latency;
 
-    iter = NULL;
-    if( node->data )
+    gtk_tree_model_get( model, iter, FILENAME_COLUMN, &filename, -1 );
+    if( filename && g_hash_table_lookup_extended( remminamain->priv->latency_updates, filename, NULL, &latency ) )
     {
-        data = (RemminaGroupData *)node->data;
-        iter = g_new0( GtkTreeIter, 1 );
-        gtk_tree_store_append( store, iter, parent );
-        gtk_tree_store_set( store,
+        if( GTK_IS_LIST_STORE( model ) )
+            gtk_list_store_set( GTK_LIST_STORE( model ), iter, LATENCY_COLUMN, GPOINTER_TO_INT( latency ), -1 );
+        else
+            gtk_tree_store_set( GTK_TREE_STORE( model ), iter, LATENCY_COLUMN, GPOINTER_TO_INT( latency ), -1 );
+    }
+    g_free( filename );
+    return FALSE;
+}
+
+static gboolean remmina_main_apply_latency_updates( gpointer data )
+{
+    TRACE_CALL( __func__ );
+
+    remminamain->priv->latency_update_source = 0;
+    if( remminamain->priv->file_model )
+        gtk_tree_model_foreach( remminamain->priv->file_model, remmina_main_apply_latency_func, NULL );
+    g_hash_table_remove_all( remminamain->priv->latency_updates );
+    return G_SOURCE_REMOVE;
+}
+
+static void remmina_main_on_probe_result( GSList *filenames, gint latency, gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    GSList *l;
+
+    if( !remminamain )
+        return;
+
+    /* Probes complete in bursts, walk the model once for all of them */
+    for( l = filenames; l; l = l->next )
+        g_hash_table_replace(
+            remminamain->priv->latency_updates, g_strdup( (const char *)l->data ), GINT_TO_POINTER( latency ) );
+    if( !remminamain->priv->latency_update_source )
+        remminamain->priv->latency_update_source = g_timeout_add( 250, remmina_main_apply_latency_updates, NULL );
+}
+
+/* Case folded text matched by the quick search, the name comes first so that
+ * a match there gets a lower offset and ranks higher */
+static char *remmina_main_get_search_key( RemminaFile *remminafile, const char *datetime )
+{
+    TRACE_CALL( __func__ );
+    const char *name, *group, *server, *protocol;
+    char *key, *folded;
+
+    name = remmina_file_get_string( remminafile, "name" );
+    group = remmina_file_get_string( remminafile, "group" );
+    server = remmina_file_get_string( remminafile, "server" );
+    protocol = remmina_file_get_string( remminafile, "protocol" );
+    key = g_strjoin( "\n",
+                     name ? name : "",
+                     group ? group : "",
+                     server ? server : "",
+                     protocol ? protocol : "",
+                     datetime ? datetime : "",
+                     NULL );
+    folded = g_utf8_casefold( key, -1 );
+    g_free( key );
+    return folded;
+}
+
+/* Fill a profile row of either the list or the tree store */
+static void remmina_main_set_file_row( GtkTreeModel *model, GtkTreeIter *iter, RemminaFile *remminafile )
+{
+    TRACE_CALL( __func__ );
+    char *datetime;
+    char *search_key;
+    gint latency = REMMINA_MONITOR_LATENCY_UNKNOWN;
+
+    if( remmina_pref.show_latency )
+        latency = remmina_monitor_probe( remminamain->monitor, remminafile );
+    datetime = remmina_file_get_datetime( remminafile );
+    search_key = remmina_main_get_search_key( remminafile, datetime );
+
+    if( GTK_IS_LIST_STORE( model ) )
+        gtk_list_store_set( GTK_LIST_STORE( model ),
                             iter,
                             PROTOCOL_COLUMN,
-                            "folder-symbolic",
+                            remmina_file_get_icon_name( remminafile ),
                             NAME_COLUMN,
-                            data->name,
+                            remmina_file_get_string( remminafile, "name" ),
                             GROUP_COLUMN,
-                            data->group,
+                            remmina_file_get_string( remminafile, "group" ),
+                            SERVER_COLUMN,
+                            remmina_file_get_string( remminafile, "server" ),
+                            PLUGIN_COLUMN,
+                            remmina_file_get_string( remminafile, "protocol" ),
                             DATE_COLUMN,
-                            data->datetime,
+                            datetime,
                             FILENAME_COLUMN,
-                            NULL,
+                            remmina_file_get_filename( remminafile ),
+                            LATENCY_COLUMN,
+                            latency,
+                            SEARCH_COLUMN,
+                            search_key,
                             -1 );
-    }
-    for( child = g_node_first_child( node ); child; child = g_node_next_sibling( child ) )
-        remmina_main_load_file_tree_traverse( child, store, iter );
-    g_free( iter );
-    return FALSE;
+    else
+        gtk_tree_store_set( GTK_TREE_STORE( model ),
+                            iter,
+                            PROTOCOL_COLUMN,
+                            remmina_file_get_icon_name( remminafile ),
+                            NAME_COLUMN,
+                            remmina_file_get_string( remminafile, "name" ),
+                            GROUP_COLUMN,
+                            remmina_file_get_string( remminafile, "group" ),
+                            SERVER_COLUMN,
+                            remmina_file_get_string( remminafile, "server" ),
+                            PLUGIN_COLUMN,
+                            remmina_file_get_string( remminafile, "protocol" ),
+                            DATE_COLUMN,
+                            datetime,
+                            FILENAME_COLUMN,
+                            remmina_file_get_filename( remminafile ),
+                            LATENCY_COLUMN,
+                            latency,
+                            SEARCH_COLUMN,
+                            search_key,
+                            -1 );
+
+    g_free( datetime );
+    g_free( search_key );
+    g_hash_table_replace( remminamain->priv->file_iters,
+                          g_strdup( remmina_file_get_filename( remminafile ) ),
+                          g_memdup2( iter, sizeof( GtkTreeIter ) ) );
 }
 
-static void remmina_main_load_file_tree_group( GtkTreeStore *store )
+static void remmina_main_load_file_list_callback( RemminaFile *remminafile, gpointer user_data )
 {
     TRACE_CALL( __func__ );
-    GNode *root;
+    GtkTreeIter iter;
+    GtkListStore *store;
 
-    root = remmina_file_manager_get_group_tree();
-    remmina_main_load_file_tree_traverse( root, store, NULL );
-    remmina_file_manager_free_group_tree( root );
+    store = GTK_LIST_STORE( user_data );
+    gtk_list_store_append( store, &iter );
+    remmina_main_set_file_row( GTK_TREE_MODEL( store ), &iter, remminafile );
 }
 
-static void remmina_main_expand_group_traverse( GtkTreeIter *iter )
+/* Iter of the folder row of group, creating it and its parents in the store when missing.
+ * Folders are created parents first, so the ones to be expanded are queued in a usable order. */
+static GtkTreeIter *remmina_main_get_group_iter( GtkTreeStore *store, const char *group )
 {
     TRACE_CALL( __func__ );
-    GtkTreeModel *tree;
-    bool ret;
-    char *group, *filename;
-    GtkTreeIter child;
-    GtkTreePath *path;
+    GtkTreeIter *iter, *parent;
+    const char *name;
+    char *parent_group;
+    char **parts;
+    guint i, n;
+
+    if( !group || !group[0] )
+        return NULL;
+    iter = (GtkTreeIter *)g_hash_table_lookup( remminamain->priv->group_iters, group );
+    if( iter )
+        return iter;
 
-    tree = remminamain->priv->file_model_sort;
-    ret = TRUE;
-    while( ret )
+    /* "a/", "/a" and "a//b" carry empty components, which must not become folders */
+    if( group[0] == '/' || g_str_has_suffix( group, "/" ) || strstr( group, "//" ) )
     {
-        gtk_tree_model_get( tree, iter, GROUP_COLUMN, &group, FILENAME_COLUMN, &filename, -1 );
-        if( filename == NULL )
+        parts = g_strsplit( group, "/", -1 );
+        for( i = 0, n = 0; parts[i]; i++ )
         {
-            if( remmina_string_array_find( remminamain->priv->expanded_group, group ) >= 0 )
-            {
-                path = gtk_tree_model_get_path( tree, iter );
-                gtk_tree_view_expand_row( remminamain->tree_files_list, path, FALSE );
-                gtk_tree_path_free( path );
-            }
-            if( gtk_tree_model_iter_children( tree, &child, iter ) )
-                remmina_main_expand_group_traverse( &child );
+            if( parts[i][0] )
+                parts[n++] = parts[i];
+            else
+                g_free( parts[i] );
         }
-        g_free( group );
-        g_free( filename );
+        parts[n] = NULL;
+        parent_group = g_strjoinv( "/", parts );
+        g_strfreev( parts );
+        iter = remmina_main_get_group_iter( store, parent_group );
+        g_free( parent_group );
+        return iter;
+    }
 
-        ret = gtk_tree_model_iter_next( tree, iter );
+    name = strrchr( group, '/' );
+    if( name )
+    {
+        parent_group = g_strndup( group, name - group );
+        parent = remmina_main_get_group_iter( store, parent_group );
+        g_free( parent_group );
+        name++;
+    }
+    else
+    {
+        parent = NULL;
+        name = group;
     }
-}
 
-static void remmina_main_expand_group()
-{
-    TRACE_CALL( __func__ );
-    GtkTreeIter iter;
+    iter = g_new0( GtkTreeIter, 1 );
+    gtk_tree_store_append( store, iter, parent );
+    gtk_tree_store_set( store,
+                        iter,
+                        PROTOCOL_COLUMN,
+                        "folder-symbolic",
+                        NAME_COLUMN,
+                        name,
+                        GROUP_COLUMN,
+                        group,
+                        FILENAME_COLUMN,
+                        NULL,
+                        LATENCY_COLUMN,
+                        REMMINA_MONITOR_LATENCY_UNKNOWN,
+                        -1 );
+    g_hash_table_insert( remminamain->priv->group_iters, g_strdup( group ), iter );
 
-    if( gtk_tree_model_get_iter_first( remminamain->priv->file_model_sort, &iter ) )
-        remmina_main_expand_group_traverse( &iter );
+    if( remminamain->priv->groups_to_expand && remmina_string_array_find( remminamain->priv->expanded_group, group ) >= 0 )
+        g_ptr_array_add( remminamain->priv->groups_to_expand, g_strdup( group ) );
+    return iter;
 }
 
-static int remmina_main_load_file_tree_find( GtkTreeModel *tree, GtkTreeIter *iter, const char *match_group )
+/* Expand the folders queued while the tree store was filled */
+static void remmina_main_expand_group()
 {
     TRACE_CALL( __func__ );
-    bool ret, match;
-    char *group, *filename;
-    GtkTreeIter child;
+    GtkTreeIter *iter;
+    GtkTreePath *path, *filter_path, *sort_path;
+    guint i;
 
-    match = FALSE;
-    ret = TRUE;
-    while( ret )
+    if( !remminamain->priv->groups_to_expand )
+        return;
+    for( i = 0; i < remminamain->priv->groups_to_expand->len; i++ )
     {
-        gtk_tree_model_get( tree, iter, GROUP_COLUMN, &group, FILENAME_COLUMN, &filename, -1 );
-        match = ( filename == NULL && g_strcmp0( group, match_group ) == 0 );
-        g_free( group );
-        g_free( filename );
-        if( match )
-            break;
-        if( gtk_tree_model_iter_children( tree, &child, iter ) )
-        {
-            match = remmina_main_load_file_tree_find( tree, &child, match_group );
-            if( match )
-            {
-                memcpy( iter, &child, sizeof( GtkTreeIter ) );
-                break;
-            }
-        }
-        ret = gtk_tree_model_iter_next( tree, iter );
+        iter = (GtkTreeIter *)g_hash_table_lookup( remminamain->priv->group_iters,
+                                                   g_ptr_array_index( remminamain->priv->groups_to_expand, i ) );
+        if( !iter )
+            continue;
+        path = gtk_tree_model_get_path( remminamain->priv->file_model, iter );
+        filter_path = gtk_tree_model_filter_convert_child_path_to_path(
+            GTK_TREE_MODEL_FILTER( remminamain->priv->file_model_filter ), path );
+        sort_path = filter_path ? gtk_tree_model_sort_convert_child_path_to_path(
+                                      GTK_TREE_MODEL_SORT( remminamain->priv->file_model_sort ), filter_path )
+                                : NULL;
+        if( sort_path )
+            gtk_tree_view_expand_row( remminamain->tree_files_list, sort_path, FALSE );
+        gtk_tree_path_free( path );
+        if( filter_path )
+            gtk_tree_path_free( filter_path );
+        if( sort_path )
+            gtk_tree_path_free( sort_path );
     }
-    return match;
+    g_ptr_array_free( remminamain->priv->groups_to_expand, TRUE );
+    remminamain->priv->groups_to_expand = NULL;
 }
 
 static void remmina_main_load_file_tree_callback( RemminaFile *remminafile, gpointer user_data )
 {
     TRACE_CALL( __func__ );
-    GtkTreeIter iter, child;
+    GtkTreeIter child;
     GtkTreeStore *store;
-    bool found;
-    char *datetime = NULL;
 
     store = GTK_TREE_STORE( user_data );
-
-    found = FALSE;
-    if( gtk_tree_model_get_iter_first( GTK_TREE_MODEL( store ), &iter ) )
-        found = remmina_main_load_file_tree_find(
-            GTK_TREE_MODEL( store ), &iter, remmina_file_get_string( remminafile, "group" ) );
-
-    datetime = remmina_file_get_datetime( remminafile );
-    //REMMINA_DEBUG("The date is %s", datetime);
-    gtk_tree_store_append( store, &child, ( found ? &iter : NULL ) );
-    gtk_tree_store_set( store,
-                        &child,
-                        PROTOCOL_COLUMN,
-                        remmina_file_get_icon_name( remminafile ),
-                        NAME_COLUMN,
-                        remmina_file_get_string( remminafile, "name" ),
-                        GROUP_COLUMN,
-                        remmina_file_get_string( remminafile, "group" ),
-                        SERVER_COLUMN,
-                        remmina_file_get_string( remminafile, "server" ),
-                        PLUGIN_COLUMN,
-                        remmina_file_get_string( remminafile, "protocol" ),
-                        DATE_COLUMN,
-                        datetime,
-                        FILENAME_COLUMN,
-                        remmina_file_get_filename( remminafile ),
-                        -1 );
-    g_free( datetime );
+    gtk_tree_store_append(
+        store, &child, remmina_main_get_group_iter( store, remmina_file_get_string( remminafile, "group" ) ) );
+    remmina_main_set_file_row( GTK_TREE_MODEL( store ), &child, remminafile );
 }
 
 static void remmina_main_file_model_on_sort( GtkTreeSortable *sortable, gpointer user_data )
@@ -563,65 +691,146 @@ static void remmina_main_file_model_on_sort( GtkTreeSortable *sortable, gpointer
     GtkSortType order;
 
     gtk_tree_sortable_get_sort_column_id( sortable, &columnid, &order );
+    /* Ranking search results is not a user choice */
+    if( columnid == SEARCH_SORT_COLUMN_ID )
+        return;
     remmina_pref.main_sort_column_id = columnid;
     remmina_pref.main_sort_order = order;
     remmina_pref_save();
 }
 
-static int remmina_main_filter_visible_func( GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data )
+/* Score of the quick search text against a row search key, 0 when it does not match.
+ * Substrings beat scattered characters, and earlier matches beat later ones.
+ * There is no trigram or prefix index: it could only rule out substring matches, every
+ * remaining row still needs the in-order fuzzy scan, and the keys are short and folded
+ * once, while rows rejected by a shorter text are not scanned again. */
+static gint remmina_main_search_score( const char *key, const char *text )
 {
     TRACE_CALL( __func__ );
-    char *text;
-    char *protocol, *name, *group, *server, *plugin, *date, *s;
-    bool result = TRUE;
+    const char *p, *found, *name_end, *field, *field_end, *t;
+    gint gaps, best = 0;
 
-    text = g_ascii_strdown( gtk_entry_get_text( remminamain->entry_quick_connect_server ), -1 );
-    if( text && text[0] )
+    found = strstr( key, text );
+    if( found )
     {
-        gtk_tree_model_get( model,
-                            iter,
-                            PROTOCOL_COLUMN,
-                            &protocol,
-                            NAME_COLUMN,
-                            &name,
-                            GROUP_COLUMN,
-                            &group,
-                            SERVER_COLUMN,
-                            &server,
-                            PLUGIN_COLUMN,
-                            &plugin,
-                            DATE_COLUMN,
-                            &date,
-                            -1 );
-        if( g_strcmp0( protocol, "folder-symbolic" ) != 0 )
+        name_end = strchr( key, '\n' );
+        if( found == key )
+            return 3000;
+        if( !name_end || found < name_end )
+            return 2000 - MIN( found - key, 999 );
+        return 1000 - MIN( found - key, 899 );
+    }
+
+    /* Fuzzy: all the characters in order within one field, the tightest field wins */
+    for( field = key; field; field = *field_end ? field_end + 1 : NULL )
+    {
+        field_end = strchr( field, '\n' );
+        if( !field_end )
+            field_end = field + strlen( field );
+        p = field;
+        gaps = 0;
+        for( t = text; *t; t++ )
         {
-            s = g_ascii_strdown( name ? name : "", -1 );
-            g_free( name );
-            name = s;
-            s = g_ascii_strdown( group ? group : "", -1 );
-            g_free( group );
-            group = s;
-            s = g_ascii_strdown( server ? server : "", -1 );
-            g_free( server );
-            server = s;
-            s = g_ascii_strdown( plugin ? plugin : "", -1 );
-            g_free( plugin );
-            plugin = s;
-            s = g_ascii_strdown( date ? date : "", -1 );
-            g_free( date );
-            date = s;
-            result = ( strstr( name, text ) || strstr( group, text ) || strstr( server, text ) || strstr( plugin, text )
-                       || strstr( date, text ) );
+            found = (const char *)memchr( p, *t, field_end - p );
+            if( !found )
+                break;
+            if( t != text )
+                gaps += found - p;
+            p = found + 1;
         }
-        g_free( protocol );
-        g_free( name );
-        g_free( group );
-        g_free( server );
-        g_free( plugin );
-        g_free( date );
+        if( !*t )
+            best = MAX( best, MAX( 1, 100 - gaps ) );
+    }
+    return best;
+}
+
+static int remmina_main_filter_visible_func( GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    const char *text = remminamain->priv->search_text;
+    char *filename, *key;
+    gint score;
+
+    if( !text || !text[0] )
+        return TRUE;
+
+    gtk_tree_model_get( model, iter, FILENAME_COLUMN, &filename, SEARCH_COLUMN, &key, -1 );
+    /* Group folders */
+    if( !filename )
+    {
+        g_free( key );
+        return TRUE;
+    }
+
+    /* Appending characters can only narrow the previous result */
+    if( g_hash_table_contains( remminamain->priv->search_rejected, filename ) )
+        score = 0;
+    else
+        score = remmina_main_search_score( key ? key : "", text );
+
+    if( score )
+        g_hash_table_replace( remminamain->priv->search_scores, filename, GINT_TO_POINTER( score ) );
+    else
+    {
+        g_hash_table_add( remminamain->priv->search_rejected, filename );
+        g_hash_table_remove( remminamain->priv->search_scores, filename );
+    }
+    g_free( key );
+    return score > 0;
+}
+
+/* While searching, best matches first then the most recently used */
+static int remmina_main_search_sort_func( GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b, gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    char *fa, *fb, *da, *db;
+    gint sa, sb, ret;
+
+    gtk_tree_model_get( model, a, FILENAME_COLUMN, &fa, DATE_COLUMN, &da, -1 );
+    gtk_tree_model_get( model, b, FILENAME_COLUMN, &fb, DATE_COLUMN, &db, -1 );
+    sa = fa ? GPOINTER_TO_INT( g_hash_table_lookup( remminamain->priv->search_scores, fa ) ) : 0;
+    sb = fb ? GPOINTER_TO_INT( g_hash_table_lookup( remminamain->priv->search_scores, fb ) ) : 0;
+    ret = sb - sa;
+    if( ret == 0 )
+        ret = -g_strcmp0( da, db );
+    g_free( fa );
+    g_free( fb );
+    g_free( da );
+    g_free( db );
+    return ret;
+}
+
+static void remmina_main_set_search_text( const char *text )
+{
+    TRACE_CALL( __func__ );
+    char *folded = g_utf8_casefold( text ? text : "", -1 );
+    const char *previous = remminamain->priv->search_text;
+
+    /* Rejected rows stay rejected only while the text grows */
+    if( !previous || !previous[0] || !g_str_has_prefix( folded, previous ) )
+        g_hash_table_remove_all( remminamain->priv->search_rejected );
+    g_hash_table_remove_all( remminamain->priv->search_scores );
+    g_free( remminamain->priv->search_text );
+    remminamain->priv->search_text = folded;
+}
+
+static void remmina_main_apply_sort()
+{
+    TRACE_CALL( __func__ );
+    GtkTreeSortable *sortable = GTK_TREE_SORTABLE( remminamain->priv->file_model_sort );
+
+    if( remminamain->priv->search_text && remminamain->priv->search_text[0] )
+    {
+        /* Setting the function again also resorts on the new scores */
+        gtk_tree_sortable_set_sort_func( sortable, SEARCH_SORT_COLUMN_ID, remmina_main_search_sort_func, NULL, NULL );
+        gtk_tree_sortable_set_sort_column_id( sortable, SEARCH_SORT_COLUMN_ID, GTK_SORT_ASCENDING );
+    }
+    else
+    {
+        gtk_tree_sortable_set_sort_column_id( sortable,
+                                              remmina_pref.main_sort_column_id,
+                                              static_cast<GtkSortType>( remmina_pref.main_sort_order ) );
     }
-    g_free( text );
-    return result;
 }
 
 static void remmina_main_select_file( const char *filename )
@@ -653,12 +862,65 @@ static void remmina_main_select_file( const char *filename )
     }
 }
 
-static void remmina_main_load_files()
+/* Show in the status bar the total number of connections found */
+static void remmina_main_show_items_count( gint items_count )
 {
     TRACE_CALL( __func__ );
-    gint items_count;
     char buf[200];
     guint context_id;
+
+    g_snprintf( buf, sizeof( buf ), ngettext( "Total %i item.", "Total %i items.", items_count ), items_count );
+    context_id = gtk_statusbar_get_context_id( remminamain->statusbar_main, "status" );
+    gtk_statusbar_pop( remminamain->statusbar_main, context_id );
+    gtk_statusbar_push( remminamain->statusbar_main, context_id, buf );
+}
+
+static void remmina_main_datadir_changed( GFileMonitor *monitor,
+                                          GFile *file,
+                                          GFile *other_file,
+                                          GFileMonitorEvent event_type,
+                                          gpointer user_data );
+
+static void remmina_main_monitor_datadir()
+{
+    TRACE_CALL( __func__ );
+    g_autoptr( GError ) error = NULL;
+    char *datadir;
+    GFile *dir;
+
+    datadir = remmina_file_get_datadir();
+    if( remminamain->priv->datadir_monitor && g_strcmp0( datadir, remminamain->priv->monitored_datadir ) == 0 )
+    {
+        g_free( datadir );
+        return;
+    }
+
+    if( remminamain->priv->datadir_monitor )
+    {
+        g_file_monitor_cancel( remminamain->priv->datadir_monitor );
+        g_object_unref( remminamain->priv->datadir_monitor );
+        remminamain->priv->datadir_monitor = NULL;
+    }
+    g_free( remminamain->priv->monitored_datadir );
+    remminamain->priv->monitored_datadir = datadir;
+
+    dir = g_file_new_for_path( datadir );
+    remminamain->priv->datadir_monitor = g_file_monitor_directory( dir, G_FILE_MONITOR_WATCH_MOVES, NULL, &error );
+    g_object_unref( dir );
+    if( !remminamain->priv->datadir_monitor )
+    {
+        /* Every change made from Remmina will reload the whole list instead */
+        REMMINA_WARNING( "Cannot monitor %s: %s", datadir, error->message );
+        return;
+    }
+    g_signal_connect(
+        remminamain->priv->datadir_monitor, "changed", G_CALLBACK( remmina_main_datadir_changed ), NULL );
+}
+
+static void remmina_main_load_files()
+{
+    TRACE_CALL( __func__ );
+    gint items_count;
     gint view_file_mode;
     char *save_selected_filename;
     GtkTreeModel *newmodel;
@@ -668,6 +930,15 @@ static void remmina_main_load_files()
     save_selected_filename = g_strdup( remminamain->priv->selected_filename );
     remmina_main_save_expanded_group();
 
+    gtk_tree_view_column_set_visible( remminamain->column_files_list_latency, remmina_pref.show_latency );
+
+    remmina_main_monitor_datadir();
+    /* A full reload supersedes the pending changes */
+    g_hash_table_remove_all( remminamain->priv->changed_files );
+    g_hash_table_remove_all( remminamain->priv->file_iters );
+    g_hash_table_remove_all( remminamain->priv->group_iters );
+    g_hash_table_remove_all( remminamain->priv->search_rejected );
+
     view_file_mode = remmina_pref.view_file_mode;
     if( remminamain->priv->override_view_file_mode_to_list )
         view_file_mode = REMMINA_VIEW_FILE_LIST;
@@ -687,19 +958,20 @@ static void remmina_main_load_files()
     {
         case REMMINA_VIEW_FILE_TREE:
             /* Create new GtkTreeStore model */
-            newmodel = GTK_TREE_MODEL( gtk_tree_store_new( 7,
+            newmodel = GTK_TREE_MODEL( gtk_tree_store_new( N_COLUMNS,
                                                            G_TYPE_STRING,
                                                            G_TYPE_STRING,
                                                            G_TYPE_STRING,
                                                            G_TYPE_STRING,
                                                            G_TYPE_STRING,
                                                            G_TYPE_STRING,
+                                                           G_TYPE_STRING,
+                                                           G_TYPE_INT,
                                                            G_TYPE_STRING ) );
             /* Hide the Group column in the tree view mode */
             gtk_tree_view_column_set_visible( remminamain->column_files_list_group, FALSE );
-            /* Load groups first */
-            remmina_main_load_file_tree_group( GTK_TREE_STORE( newmodel ) );
-            /* Load files list */
+            /* Load files list, group folders are created as they are met */
+            remminamain->priv->groups_to_expand = g_ptr_array_new_with_free_func( g_free );
             items_count =
                 remmina_file_manager_iterate( (GFunc)remmina_main_load_file_tree_callback, (gpointer)newmodel );
             break;
@@ -707,13 +979,15 @@ static void remmina_main_load_files()
         case REMMINA_VIEW_FILE_LIST:
         default:
             /* Create new GtkListStore model */
-            newmodel = GTK_TREE_MODEL( gtk_list_store_new( 7,
+            newmodel = GTK_TREE_MODEL( gtk_list_store_new( N_COLUMNS,
                                                            G_TYPE_STRING,
                                                            G_TYPE_STRING,
                                                            G_TYPE_STRING,
                                                            G_TYPE_STRING,
                                                            G_TYPE_STRING,
                                                            G_TYPE_STRING,
+                                                           G_TYPE_STRING,
+                                                           G_TYPE_INT,
                                                            G_TYPE_STRING ) );
             /* Show the Group column in the list view mode */
             gtk_tree_view_column_set_visible( remminamain->column_files_list_group, TRUE );
@@ -736,9 +1010,7 @@ static void remmina_main_load_files()
                                             NULL,
                                             NULL );
     remminamain->priv->file_model_sort = gtk_tree_model_sort_new_with_model( remminamain->priv->file_model_filter );
-    gtk_tree_sortable_set_sort_column_id( GTK_TREE_SORTABLE( remminamain->priv->file_model_sort ),
-                                          remmina_pref.main_sort_column_id,
-                                          static_cast<GtkSortType>( remmina_pref.main_sort_order ) );
+    remmina_main_apply_sort();
     gtk_tree_view_set_model( remminamain->tree_files_list, remminamain->priv->file_model_sort );
     g_signal_connect( G_OBJECT( remminamain->priv->file_model_sort ),
                       "sort-column-changed",
@@ -757,11 +1029,7 @@ static void remmina_main_load_files()
 
     gtk_widget_set_tooltip_text( GTK_WIDGET( label ),
                                  _( "The latest successful connection attempt, or a pre-computed date" ) );
-    /* Show in the status bar the total number of connections found */
-    g_snprintf( buf, sizeof( buf ), ngettext( "Total %i item.", "Total %i items.", items_count ), items_count );
-    context_id = gtk_statusbar_get_context_id( remminamain->statusbar_main, "status" );
-    gtk_statusbar_pop( remminamain->statusbar_main, context_id );
-    gtk_statusbar_push( remminamain->statusbar_main, context_id, buf );
+    remmina_main_show_items_count( items_count );
 
     remmina_network_monitor_status( remminamain->monitor );
     if( remminamain->monitor->connected )
@@ -796,6 +1064,154 @@ extern "C"
     }
 }
 
+/* Apply a single profile change to file_model. Returns FALSE when the
+ * change cannot be applied in place and the whole list must be reloaded. */
+static bool remmina_main_update_file( const char *filename )
+{
+    TRACE_CALL( __func__ );
+    GtkTreeModel *model = remminamain->priv->file_model;
+    GtkTreeIter *iter, parent;
+    RemminaFile *remminafile = NULL;
+    char *old_group;
+    bool ret = TRUE;
+
+    iter = (GtkTreeIter *)g_hash_table_lookup( remminamain->priv->file_iters, filename );
+    if( g_file_test( filename, G_FILE_TEST_EXISTS ) )
+    {
+        remminafile = remmina_file_load( filename );
+        /* Still being written, CHANGES_DONE_HINT will bring it back */
+        if( !remminafile )
+            return TRUE;
+    }
+
+    /* The new content has to be matched again against the quick search */
+    g_hash_table_remove( remminamain->priv->search_rejected, filename );
+
+    if( !remminafile )
+    {
+        if( !iter )
+            return TRUE;
+        if( GTK_IS_LIST_STORE( model ) )
+            gtk_list_store_remove( GTK_LIST_STORE( model ), iter );
+        else
+        {
+            /* An emptied group folder disappears only with a reload */
+            if( gtk_tree_model_iter_parent( model, &parent, iter ) && gtk_tree_model_iter_n_children( model, &parent ) == 1 )
+                ret = FALSE;
+            gtk_tree_store_remove( GTK_TREE_STORE( model ), iter );
+        }
+        g_hash_table_remove( remminamain->priv->file_iters, filename );
+        return ret;
+    }
+
+    if( GTK_IS_LIST_STORE( model ) )
+    {
+        if( iter )
+            remmina_main_set_file_row( model, iter, remminafile );
+        else
+            remmina_main_load_file_list_callback( remminafile, model );
+    }
+    else if( iter )
+    {
+        /* Moving a profile to another group can reshape the folders */
+        gtk_tree_model_get( model, iter, GROUP_COLUMN, &old_group, -1 );
+        if( g_strcmp0( old_group, remmina_file_get_string( remminafile, "group" ) ) == 0 )
+            remmina_main_set_file_row( model, iter, remminafile );
+        else
+            ret = FALSE;
+        g_free( old_group );
+    }
+    else
+        remmina_main_load_file_tree_callback( remminafile, model );
+
+    remmina_file_free( remminafile );
+    return ret;
+}
+
+static gboolean remmina_main_apply_file_changes( gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    GHashTableIter iter;
+    gpointer filename;
+    bool reload = FALSE;
+
+    remminamain->priv->changed_files_source = 0;
+
+    /* A git pull or a sync can touch many files, one reload is cheaper then */
+    if( !remminamain->priv->file_model || g_hash_table_size( remminamain->priv->changed_files ) > 64 )
+        reload = TRUE;
+
+    g_hash_table_iter_init( &iter, remminamain->priv->changed_files );
+    while( !reload && g_hash_table_iter_next( &iter, &filename, NULL ) )
+    {
+        REMMINA_DEBUG( "Updating %s in the main window", (const char *)filename );
+        if( !remmina_main_update_file( (const char *)filename ) )
+            reload = TRUE;
+    }
+    g_hash_table_remove_all( remminamain->priv->changed_files );
+
+    if( reload )
+        remmina_main_load_files();
+    else
+        remmina_main_show_items_count( g_hash_table_size( remminamain->priv->file_iters ) );
+    remmina_icon_populate_menu();
+    return G_SOURCE_REMOVE;
+}
+
+static void remmina_main_queue_file_change( const char *filename )
+{
+    TRACE_CALL( __func__ );
+
+    if( !filename || !g_str_has_suffix( filename, ".remmina" ) )
+        return;
+    g_hash_table_add( remminamain->priv->changed_files, g_strdup( filename ) );
+    /* Editors and sync tools emit bursts of events for a single save */
+    if( !remminamain->priv->changed_files_source )
+        remminamain->priv->changed_files_source = g_timeout_add( 200, remmina_main_apply_file_changes, NULL );
+}
+
+static void remmina_main_datadir_changed( GFileMonitor *monitor,
+                                          GFile *file,
+                                          GFile *other_file,
+                                          GFileMonitorEvent event_type,
+                                          gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    char *path;
+
+    if( !remminamain )
+        return;
+
+    switch( event_type )
+    {
+        case G_FILE_MONITOR_EVENT_RENAMED:
+            path = g_file_get_path( other_file );
+            remmina_main_queue_file_change( path );
+            g_free( path );
+            /* fall through, the old name is gone */
+        case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+        case G_FILE_MONITOR_EVENT_CREATED:
+        case G_FILE_MONITOR_EVENT_DELETED:
+        case G_FILE_MONITOR_EVENT_MOVED_IN:
+        case G_FILE_MONITOR_EVENT_MOVED_OUT:
+            path = g_file_get_path( file );
+            remmina_main_queue_file_change( path );
+            g_free( path );
+            break;
+        default:
+            break;
+    }
+}
+
+/* Called after Remmina itself changed a profile: when the data directory is
+ * monitored the change arrives from there, otherwise reload the list. */
+static void remmina_main_files_changed()
+{
+    TRACE_CALL( __func__ );
+    if( !remminamain->priv->datadir_monitor )
+        remmina_main_load_files();
+}
+
 void remmina_main_on_action_connection_connect( GSimpleAction *action, GVariant *param, gpointer data )
 {
     TRACE_CALL( __func__ );
@@ -834,7 +1250,7 @@ static void remmina_main_file_editor_destroy( GtkWidget *widget, gpointer user_d
 
     if( !remminamain )
         return;
-    remmina_main_load_files();
+    remmina_main_files_changed();
 }
 
 void remmina_main_on_action_application_mpchange( GSimpleAction *action, GVariant *param, gpointer data )
@@ -881,7 +1297,6 @@ void remmina_main_on_action_connection_new( GSimpleAction *action, GVariant *par
     g_signal_connect( G_OBJECT( widget ), "destroy", G_CALLBACK( remmina_main_file_editor_destroy ), remminamain );
     gtk_window_set_transient_for( GTK_WINDOW( widget ), remminamain->window );
     gtk_widget_show( widget );
-    remmina_main_load_files();
 }
 
 static int remmina_main_search_key_event( GtkWidget *search_entry, GdkEventKey *event, gpointer user_data )
@@ -1003,7 +1418,7 @@ void remmina_main_on_action_connection_delete( GSimpleAction *action, GVariant *
         remmina_file_delete( delfilename );
         g_free( delfilename );
         remmina_icon_populate_menu();
-        remmina_main_load_files();
+        remmina_main_files_changed();
     }
     gtk_widget_destroy( dialog );
     remmina_main_clear_selection_data();
@@ -1147,7 +1562,7 @@ static void remmina_main_import_file_list( GSList *files )
     }
     g_string_free( err, TRUE );
     if( imported )
-        remmina_main_load_files();
+        remmina_main_files_changed();
 }
 
 static void remmina_main_action_tools_import_on_response( GtkDialog *dialog, gint response_id, gpointer user_data )
@@ -1499,7 +1914,9 @@ extern "C"
                 remmina_main_load_files();
             }
         }
+        remmina_main_set_search_text( gtk_entry_get_text( remminamain->entry_quick_connect_server ) );
         gtk_tree_model_filter_refilter( GTK_TREE_MODEL_FILTER( remminamain->priv->file_model_filter ) );
+        remmina_main_apply_sort();
     }
 
     void remmina_main_on_drag_data_received( GtkWidget *widget,
@@ -1564,6 +1981,13 @@ static void remmina_main_init()
 
     REMMINA_DEBUG( "Initializing monitor" );
     remminamain->monitor = remmina_network_monitor_new();
+    remminamain->priv->latency_updates = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+    remminamain->priv->file_iters = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, g_free );
+    remminamain->priv->group_iters = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, g_free );
+    remminamain->priv->changed_files = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+    remminamain->priv->search_rejected = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+    remminamain->priv->search_scores = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+    remmina_monitor_set_probe_callback( remminamain->monitor, remmina_main_on_probe_result, NULL );
 
     remminamain->priv->expanded_group = remmina_string_array_new_from_string( remmina_pref.expanded_group );
     if( !kioskmode && kioskmode == FALSE )
@@ -1695,6 +2119,12 @@ GtkWidget *remmina_main_new()
     remminamain->column_files_list_server = GTK_TREE_VIEW_COLUMN( RM_GET_OBJECT( "column_files_list_server" ) );
     remminamain->column_files_list_plugin = GTK_TREE_VIEW_COLUMN( RM_GET_OBJECT( "column_files_list_plugin" ) );
     remminamain->column_files_list_date = GTK_TREE_VIEW_COLUMN( RM_GET_OBJECT( "column_files_list_date" ) );
+    remminamain->column_files_list_latency = GTK_TREE_VIEW_COLUMN( RM_GET_OBJECT( "column_files_list_latency" ) );
+    gtk_tree_view_column_set_cell_data_func( remminamain->column_files_list_latency,
+                                             GTK_CELL_RENDERER( RM_GET_OBJECT( "renderer_files_list_latency" ) ),
+                                             remmina_main_latency_cell_data_func,
+                                             NULL,
+                                             NULL );
     remminamain->statusbar_main = GTK_STATUSBAR( RM_GET_OBJECT( "statusbar_main" ) );
     /* signals */
     g_signal_connect( remminamain->entry_quick_connect_server,
@@ -1757,7 +2187,8 @@ void remmina_main_update_file_datetime( RemminaFile *file )
 {
     if( !remminamain )
         return;
-    remmina_main_load_files();
+    /* The date lives in the state file, outside of the monitored directory */
+    remmina_main_queue_file_change( remmina_file_get_filename( file ) );
 }
 
 void remmina_main_show_warning_dialog( const char *message )
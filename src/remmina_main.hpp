@@ -76,6 +76,7 @@ struct RemminaMain
     GtkTreeViewColumn *column_files_list_server;
     GtkTreeViewColumn *column_files_list_plugin;
     GtkTreeViewColumn *column_files_list_date;
+    GtkTreeViewColumn *column_files_list_latency;
     GtkStatusbar *statusbar_main;
     GtkWidget *network_icon;
     /* Non widget objects */
@@ -96,6 +97,27 @@ struct RemminaMainPriv
     char *selected_name;
     bool override_view_file_mode_to_list;
     RemminaStringArray *expanded_group;
+
+    /* filename -> latency, applied to the model in one pass */
+    GHashTable *latency_updates;
+    guint latency_update_source;
+
+    /* filename -> GtkTreeIter of file_model, both stores have persistent iters */
+    GHashTable *file_iters;
+    /* group path -> GtkTreeIter of the folder row in tree mode */
+    GHashTable *group_iters;
+    /* Folders to expand once the tree store is shown, NULL outside of a reload */
+    GPtrArray *groups_to_expand;
+    /* Profiles changed on disk, waiting to be applied to file_model */
+    char *monitored_datadir;
+    GFileMonitor *datadir_monitor;
+    GHashTable *changed_files;
+    guint changed_files_source;
+
+    /* Case folded quick search text, and per filename results of the current search */
+    char *search_text;
+    GHashTable *search_rejected;
+    GHashTable *search_scores;
 };
 
 /* Create the remminamain struct and the remmina main Remmina window */
@@ -43,85 +43,186 @@
 
 static pthread_t gMainThreadID;
 
-static int remmina_masterthread_exec_callback( RemminaMTExecData *d )
+/* Calls from all threads share one queue, drained by a single idle callback
+ * per main loop iteration however many calls were queued meanwhile,
+ * see remmina_masterthread_exec_drain() for nested main loops */
+static GMutex mt_queue_mutex;
+static GQueue mt_queue = G_QUEUE_INIT;
+static bool mt_drain_scheduled = FALSE;
+static RemminaMTExecStats mt_stats;
+
+static void remmina_masterthread_exec_lock()
 {
-    /* This function is called on main GTK Thread via gdk_threads_add_idlde()
-	 * from remmina_masterthread_exec_and_wait() */
+    if( !g_mutex_trylock( &mt_queue_mutex ) )
+    {
+        g_mutex_lock( &mt_queue_mutex );
+        mt_stats.lock_contended++;
+    }
+    mt_stats.lock_acquisitions++;
+}
 
-    if( !d->cancelled )
+static void remmina_masterthread_exec_run( RemminaMTExecData *d )
+{
+    switch( d->func )
     {
-        switch( d->func )
-        {
-            case RemminaMTExecData::FUNC_INIT_SAVE_CRED:
-                remmina_protocol_widget_save_cred( d->p.init_save_creds.gp );
-                break;
-            case RemminaMTExecData::FUNC_CHAT_RECEIVE:
-                remmina_protocol_widget_chat_receive( d->p.chat_receive.gp, d->p.chat_receive.text );
-                break;
-            case RemminaMTExecData::FUNC_FILE_GET_STRING:
-                d->p.file_get_string.retval =
-                    remmina_file_get_string( d->p.file_get_string.remminafile, d->p.file_get_string.setting );
-                break;
-            case RemminaMTExecData::FUNC_GTK_LABEL_SET_TEXT:
-                gtk_label_set_text( d->p.gtk_label_set_text.label, d->p.gtk_label_set_text.str );
-                break;
-            case RemminaMTExecData::FUNC_FTP_CLIENT_UPDATE_TASK:
-                remmina_ftp_client_update_task( d->p.ftp_client_update_task.client, d->p.ftp_client_update_task.task );
-                break;
-            case RemminaMTExecData::FUNC_FTP_CLIENT_GET_WAITING_TASK:
-                d->p.ftp_client_get_waiting_task.retval =
-                    remmina_ftp_client_get_waiting_task( d->p.ftp_client_get_waiting_task.client );
-                break;
-            case RemminaMTExecData::FUNC_PROTOCOLWIDGET_EMIT_SIGNAL:
-                remmina_protocol_widget_emit_signal( d->p.protocolwidget_emit_signal.gp,
-                                                     d->p.protocolwidget_emit_signal.signal_name );
-                break;
-            case RemminaMTExecData::FUNC_PROTOCOLWIDGET_MPPROGRESS:
-                d->p.protocolwidget_mpprogress.ret_mp =
-                    remmina_protocol_widget_mpprogress( d->p.protocolwidget_mpprogress.cnnobj,
-                                                        d->p.protocolwidget_mpprogress.message,
-                                                        d->p.protocolwidget_mpprogress.response_callback,
-                                                        d->p.protocolwidget_mpprogress.response_callback_data );
-                break;
-            case RemminaMTExecData::FUNC_PROTOCOLWIDGET_MPDESTROY:
-                remmina_protocol_widget_mpdestroy( d->p.protocolwidget_mpdestroy.cnnobj,
-                                                   d->p.protocolwidget_mpdestroy.mp );
-                break;
-            case RemminaMTExecData::FUNC_PROTOCOLWIDGET_MPSHOWRETRY:
-                remmina_protocol_widget_panel_show_retry( d->p.protocolwidget_mpshowretry.gp );
-                break;
-            case RemminaMTExecData::FUNC_PROTOCOLWIDGET_PANELSHOWLISTEN:
-                remmina_protocol_widget_panel_show_listen( d->p.protocolwidget_panelshowlisten.gp,
-                                                           d->p.protocolwidget_panelshowlisten.port );
-                break;
-            case RemminaMTExecData::FUNC_SFTP_CLIENT_CONFIRM_RESUME:
+        case RemminaMTExecData::FUNC_INIT_SAVE_CRED:
+            remmina_protocol_widget_save_cred( d->p.init_save_creds.gp );
+            break;
+        case RemminaMTExecData::FUNC_CHAT_RECEIVE:
+            remmina_protocol_widget_chat_receive( d->p.chat_receive.gp, d->p.chat_receive.text );
+            break;
+        case RemminaMTExecData::FUNC_FILE_GET_STRING:
+            d->p.file_get_string.retval =
+                remmina_file_get_string( d->p.file_get_string.remminafile, d->p.file_get_string.setting );
+            break;
+        case RemminaMTExecData::FUNC_GTK_LABEL_SET_TEXT:
+            gtk_label_set_text( d->p.gtk_label_set_text.label, d->p.gtk_label_set_text.str );
+            break;
+        case RemminaMTExecData::FUNC_FTP_CLIENT_UPDATE_TASK:
+            remmina_ftp_client_update_task( d->p.ftp_client_update_task.client, d->p.ftp_client_update_task.task );
+            break;
+        case RemminaMTExecData::FUNC_FTP_CLIENT_GET_WAITING_TASK:
+            d->p.ftp_client_get_waiting_task.retval =
+                remmina_ftp_client_get_waiting_task( d->p.ftp_client_get_waiting_task.client );
+            break;
+        case RemminaMTExecData::FUNC_PROTOCOLWIDGET_EMIT_SIGNAL:
+            remmina_protocol_widget_emit_signal( d->p.protocolwidget_emit_signal.gp,
+                                                 d->p.protocolwidget_emit_signal.signal_name );
+            break;
+        case RemminaMTExecData::FUNC_PROTOCOLWIDGET_MPPROGRESS:
+            d->p.protocolwidget_mpprogress.ret_mp =
+                remmina_protocol_widget_mpprogress( d->p.protocolwidget_mpprogress.cnnobj,
+                                                    d->p.protocolwidget_mpprogress.message,
+                                                    d->p.protocolwidget_mpprogress.response_callback,
+                                                    d->p.protocolwidget_mpprogress.response_callback_data );
+            break;
+        case RemminaMTExecData::FUNC_PROTOCOLWIDGET_MPDESTROY:
+            remmina_protocol_widget_mpdestroy( d->p.protocolwidget_mpdestroy.cnnobj,
+                                               d->p.protocolwidget_mpdestroy.mp );
+            break;
+        case RemminaMTExecData::FUNC_PROTOCOLWIDGET_MPSHOWRETRY:
+            remmina_protocol_widget_panel_show_retry( d->p.protocolwidget_mpshowretry.gp );
+            break;
+        case RemminaMTExecData::FUNC_PROTOCOLWIDGET_PANELSHOWLISTEN:
+            remmina_protocol_widget_panel_show_listen( d->p.protocolwidget_panelshowlisten.gp,
+                                                       d->p.protocolwidget_panelshowlisten.port );
+            break;
+        case RemminaMTExecData::FUNC_SFTP_CLIENT_CONFIRM_RESUME:
 #ifdef HAVE_LIBSSH
-                d->p.sftp_client_confirm_resume.retval = remmina_sftp_client_confirm_resume(
-                    d->p.sftp_client_confirm_resume.client, d->p.sftp_client_confirm_resume.path );
+            d->p.sftp_client_confirm_resume.retval = remmina_sftp_client_confirm_resume(
+                d->p.sftp_client_confirm_resume.client, d->p.sftp_client_confirm_resume.path );
 #endif
-                break;
-            case RemminaMTExecData::FUNC_VTE_TERMINAL_SET_ENCODING_AND_PTY:
+            break;
+        case RemminaMTExecData::FUNC_VTE_TERMINAL_SET_ENCODING_AND_PTY:
 #if defined( HAVE_LIBSSH ) && defined( HAVE_LIBVTE )
-                remmina_plugin_ssh_vte_terminal_set_encoding_and_pty( d->p.vte_terminal_set_encoding_and_pty.terminal,
-                                                                      d->p.vte_terminal_set_encoding_and_pty.codeset,
-                                                                      d->p.vte_terminal_set_encoding_and_pty.master,
-                                                                      d->p.vte_terminal_set_encoding_and_pty.slave );
+            remmina_plugin_ssh_vte_terminal_set_encoding_and_pty( d->p.vte_terminal_set_encoding_and_pty.terminal,
+                                                                  d->p.vte_terminal_set_encoding_and_pty.codeset,
+                                                                  d->p.vte_terminal_set_encoding_and_pty.master,
+                                                                  d->p.vte_terminal_set_encoding_and_pty.slave );
 #endif
-                break;
+            break;
+    }
+}
+
+/* Drop what a posted call owns */
+static void remmina_masterthread_exec_release( RemminaMTExecData *d )
+{
+    switch( d->func )
+    {
+        case RemminaMTExecData::FUNC_CHAT_RECEIVE:
+            g_free( (char *)d->p.chat_receive.text );
+            g_object_unref( d->p.chat_receive.gp );
+            break;
+        case RemminaMTExecData::FUNC_PROTOCOLWIDGET_MPSHOWRETRY:
+            g_object_unref( d->p.protocolwidget_mpshowretry.gp );
+            break;
+        case RemminaMTExecData::FUNC_PROTOCOLWIDGET_PANELSHOWLISTEN:
+            g_object_unref( d->p.protocolwidget_panelshowlisten.gp );
+            break;
+        default:
+            break;
+    }
+    g_free( d );
+}
+
+static int remmina_masterthread_exec_drain( gpointer data )
+{
+    /* Called on the main GTK thread via gdk_threads_add_idle()
+     * from remmina_masterthread_exec_enqueue().
+     * Runs the calls queued before this dispatch, one at a time. While more calls
+     * wait, the drain is scheduled again before each one runs, so that a call entering
+     * a nested main loop (gtk_dialog_run() and the like) does not hold back the calls
+     * of the other connections until it returns */
+    RemminaMTExecData *d;
+    guint count, bucket;
+    bool schedule;
+
+    remmina_masterthread_exec_lock();
+    mt_drain_scheduled = FALSE;
+    count = mt_queue.length;
+    mt_stats.batches++;
+    mt_stats.max_batch = MAX( mt_stats.max_batch, count );
+    g_mutex_unlock( &mt_queue_mutex );
+
+    while( count-- > 0 )
+    {
+        remmina_masterthread_exec_lock();
+        d = (RemminaMTExecData *)g_queue_pop_head( &mt_queue );
+        schedule = d && !g_queue_is_empty( &mt_queue ) && !mt_drain_scheduled;
+        if( schedule )
+            mt_drain_scheduled = TRUE;
+        if( d )
+        {
+            bucket = g_bit_storage( (gulong)MAX( 0, g_get_monotonic_time() - d->queued_at ) );
+            mt_stats.latency[MIN( bucket, REMMINA_MT_EXEC_LATENCY_BUCKETS - 1 )]++;
+        }
+        g_mutex_unlock( &mt_queue_mutex );
+
+        /* Already run by a nested dispatch */
+        if( !d )
+            break;
+        if( schedule )
+            gdk_threads_add_idle( remmina_masterthread_exec_drain, NULL );
+
+        if( d->cancelled )
+        {
+            /* thread has been cancelled, so we must free d memory here */
+            g_free( d );
+            continue;
+        }
+        remmina_masterthread_exec_run( d );
+        if( d->posted )
+        {
+            remmina_masterthread_exec_release( d );
+            continue;
         }
         pthread_mutex_lock( &d->pt_mutex );
         d->complete = TRUE;
         pthread_cond_signal( &d->pt_cond );
         pthread_mutex_unlock( &d->pt_mutex );
     }
-    else
-    {
-        /* thread has been cancelled, so we must free d memory here */
-        g_free( d );
-    }
     return G_SOURCE_REMOVE;
 }
 
+static void remmina_masterthread_exec_enqueue( RemminaMTExecData *d )
+{
+    bool schedule;
+
+    d->queued_at = g_get_monotonic_time();
+    remmina_masterthread_exec_lock();
+    g_queue_push_tail( &mt_queue, d );
+    if( d->posted )
+        mt_stats.posted++;
+    else
+        mt_stats.waited++;
+    schedule = !mt_drain_scheduled;
+    mt_drain_scheduled = TRUE;
+    g_mutex_unlock( &mt_queue_mutex );
+
+    if( schedule )
+        gdk_threads_add_idle( remmina_masterthread_exec_drain, NULL );
+}
+
 static void remmina_masterthread_exec_cleanup_handler( gpointer data )
 {
     RemminaMTExecData *d = static_cast<RemminaMTExecData*>(data);
@@ -129,22 +230,49 @@ static void remmina_masterthread_exec_cleanup_handler( gpointer data )
     d->cancelled = TRUE;
 }
 
-void remmina_masterthread_exec_and_wait( RemminaMTExecData *d )
+void remmina_masterthread_exec_async( RemminaMTExecData *d )
 {
     d->cancelled = FALSE;
     d->complete = FALSE;
-    pthread_cleanup_push( remmina_masterthread_exec_cleanup_handler, (void *)d );
+    d->posted = FALSE;
     pthread_mutex_init( &d->pt_mutex, NULL );
     pthread_cond_init( &d->pt_cond, NULL );
-    gdk_threads_add_idle( (GSourceFunc)remmina_masterthread_exec_callback, (gpointer)d );
+    remmina_masterthread_exec_enqueue( d );
+}
+
+void remmina_masterthread_exec_wait( RemminaMTExecData *d )
+{
+    pthread_cleanup_push( remmina_masterthread_exec_cleanup_handler, (void *)d );
     pthread_mutex_lock( &d->pt_mutex );
     while( !d->complete )
         pthread_cond_wait( &d->pt_cond, &d->pt_mutex );
+    pthread_mutex_unlock( &d->pt_mutex );
     pthread_cleanup_pop( 0 );
     pthread_mutex_destroy( &d->pt_mutex );
     pthread_cond_destroy( &d->pt_cond );
 }
 
+void remmina_masterthread_exec_and_wait( RemminaMTExecData *d )
+{
+    remmina_masterthread_exec_async( d );
+    remmina_masterthread_exec_wait( d );
+}
+
+void remmina_masterthread_exec_post( RemminaMTExecData *d )
+{
+    d->cancelled = FALSE;
+    d->complete = FALSE;
+    d->posted = TRUE;
+    remmina_masterthread_exec_enqueue( d );
+}
+
+void remmina_masterthread_exec_get_stats( RemminaMTExecStats *stats )
+{
+    g_mutex_lock( &mt_queue_mutex );
+    *stats = mt_stats;
+    g_mutex_unlock( &mt_queue_mutex );
+}
+
 void remmina_masterthread_exec_save_main_thread_id()
 {
     /* To be called from main thread at startup */
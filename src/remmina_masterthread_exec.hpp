@@ -143,9 +143,35 @@ struct RemminaMTExecData
     /* Flag to catch cancellations */
     bool cancelled;
     bool complete;
+    /* Nobody waits for it, freed with what it references once executed */
+    bool posted;
+    gint64 queued_at;
 };
 
+#define REMMINA_MT_EXEC_LATENCY_BUCKETS 21
+
+struct RemminaMTExecStats
+{
+    guint64 posted;
+    guint64 waited;
+    guint64 batches;
+    guint max_batch;
+    guint64 lock_acquisitions;
+    guint64 lock_contended;
+    /* Time spent in the queue: bucket i counts waits shorter than 2^i us, the last one all the longer waits */
+    guint64 latency[REMMINA_MT_EXEC_LATENCY_BUCKETS];
+};
+
+/* Run d on the main thread and wait for it */
 void remmina_masterthread_exec_and_wait( RemminaMTExecData *d );
+/* Same in two steps: queue d, do something else, then wait for the results in d */
+void remmina_masterthread_exec_async( RemminaMTExecData *d );
+void remmina_masterthread_exec_wait( RemminaMTExecData *d );
+/* Queue d and return at once. d must be allocated with g_malloc(), the main thread frees it,
+ * and drops the reference or the string it owns (see remmina_masterthread_exec_release()) */
+void remmina_masterthread_exec_post( RemminaMTExecData *d );
+
+void remmina_masterthread_exec_get_stats( RemminaMTExecStats *stats );
 
 void remmina_masterthread_exec_save_main_thread_id();
 int remmina_masterthread_exec_is_main_thread();
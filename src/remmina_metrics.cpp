@@ -0,0 +1,490 @@
+/*
+ * Remmina - The GTK+ Remote Desktop Client
+ * Copyright (C) 2016-2022 Antenore Gatta, Giovanni Panozzo
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ *
+ *  In addition, as a special exception, the copyright holders give
+ *  permission to link the code of portions of this program with the
+ *  OpenSSL library under certain conditions as described in each
+ *  individual source file, and distribute linked combinations
+ *  including the two.
+ *  You must obey the GNU General Public License in all respects
+ *  for all of the code used other than OpenSSL. *  If you modify
+ *  file(s) with this exception, you may extend this exception to your
+ *  version of the file(s), but you are not obligated to do so. *  If you
+ *  do not wish to do so, delete this exception statement from your
+ *  version. *  If you delete this exception statement from all source
+ *  files in the program, then also delete it here.
+ *
+ */
+
+
+/* The endpoint speaks just enough HTTP for curl --unix-socket and for
+ * scrapers behind a socket proxy: the first line of the request is read,
+ * "GET /metrics" gets the Prometheus text format and "GET /metrics.json"
+ * gets JSON. A bare "json" line, or no request at all, gets the raw body
+ * without HTTP headers, so socat works as well. The request is read with a
+ * single bounded read and a short timeout, a client cannot hold the main loop
+ * or grow a buffer by never finishing its line.
+ *
+ * Everything is sampled on the main thread at request time from counters the
+ * plugins already keep in their RemminaProtocolWidget, nothing is polled. */
+
+#include "config.h"
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "json-glib/json-glib.h"
+#include "remmina/remmina_trace_calls.hpp"
+#include "remmina_file.hpp"
+#include "remmina_log.hpp"
+#include "remmina_metrics.hpp"
+#include "remmina_pref.hpp"
+#include "remmina_protocol_widget.hpp"
+
+#define REMMINA_METRICS_SOCKET_NAME "metrics.sock"
+/* Longest request read from a client, the rest of the request is ignored */
+#define REMMINA_METRICS_REQUEST_MAX 1024
+/* A client that sends nothing within this time is served the raw body */
+#define REMMINA_METRICS_REQUEST_TIMEOUT 2
+
+enum
+{
+    REMMINA_METRICS_UP,
+    REMMINA_METRICS_UPTIME,
+    REMMINA_METRICS_RECONNECTS,
+    REMMINA_METRICS_BYTES_IN,
+    REMMINA_METRICS_BYTES_OUT,
+    REMMINA_METRICS_FRAMES_RECEIVED,
+    REMMINA_METRICS_FRAMES_PRESENTED,
+    REMMINA_METRICS_DAMAGE_PIXELS,
+    REMMINA_METRICS_SSH_CHANNELS,
+    REMMINA_METRICS_N
+};
+
+struct RemminaMetricsFamily
+{
+    const char *name;
+    const char *json_key;
+    const char *type;
+    const char *help;
+};
+
+static const RemminaMetricsFamily metrics_families[REMMINA_METRICS_N] = {
+    { "remmina_connection_up", "up", "gauge", "1 when the connection is established" },
+    { "remmina_connection_uptime_seconds", "uptime_seconds", "gauge", "Time since the connection was established" },
+    { "remmina_connection_reconnects_total", "reconnects", "counter", "Automatic reconnections" },
+    { "remmina_connection_received_bytes_total",
+      "received_bytes",
+      "counter",
+      "Bytes received, SFTP transfers included. Reported by RDP and SPICE, always 0 for VNC" },
+    { "remmina_connection_sent_bytes_total",
+      "sent_bytes",
+      "counter",
+      "Bytes sent, SFTP transfers included. Reported by RDP, always 0 for VNC and SPICE" },
+    { "remmina_connection_frames_received_total", "frames_received", "counter", "Screen updates received" },
+    { "remmina_connection_frames_presented_total", "frames_presented", "counter", "Screen updates drawn" },
+    { "remmina_connection_damage_pixels_total", "damage_pixels", "counter", "Pixels updated by the server" },
+    { "remmina_connection_ssh_tunnel_channels", "ssh_tunnel_channels", "gauge", "Open SSH tunnel channels" },
+};
+
+struct RemminaMetricsSample
+{
+    guint id;
+    const char *name;
+    const char *protocol;
+    const char *state;
+    gdouble values[REMMINA_METRICS_N];
+};
+
+struct RemminaMetricsClient
+{
+    GSocketConnection *connection;
+    GCancellable *cancellable;
+    guint timeout_source;
+    char request[REMMINA_METRICS_REQUEST_MAX];
+    char *response;
+};
+
+static GSocketService *metrics_service = NULL;
+static char *metrics_socket_path = NULL;
+
+static guint64 remmina_metrics_get_rss()
+{
+    TRACE_CALL( __func__ );
+    guint64 rss = 0;
+#ifdef __linux__
+    char *contents = NULL;
+    unsigned long size, resident;
+
+    if( g_file_get_contents( "/proc/self/statm", &contents, NULL, NULL )
+        && sscanf( contents, "%lu %lu", &size, &resident ) == 2 )
+        rss = (guint64)resident * sysconf( _SC_PAGESIZE );
+    g_free( contents );
+#endif
+    return rss;
+}
+
+static GArray *remmina_metrics_collect()
+{
+    TRACE_CALL( __func__ );
+    GArray *samples = g_array_new( FALSE, TRUE, sizeof( RemminaMetricsSample ) );
+    gint64 now = g_get_monotonic_time();
+    RemminaMetricsSample sample;
+    RemminaPerfTotals totals;
+    RemminaProtocolWidget *gp;
+    RemminaFile *remminafile;
+    gint64 connected_time;
+    GList *l;
+
+    for( l = remmina_protocol_widget_get_all(); l; l = l->next )
+    {
+        gp = REMMINA_PROTOCOL_WIDGET( l->data );
+        remminafile = remmina_protocol_widget_get_file( gp );
+        if( !remminafile )
+            continue;
+
+        memset( &sample, 0, sizeof( sample ) );
+        connected_time = remmina_protocol_widget_get_connected_time( gp );
+        sample.id = remmina_protocol_widget_get_id( gp );
+        sample.name = remmina_file_get_string( remminafile, "name" );
+        sample.protocol = remmina_file_get_string( remminafile, "protocol" );
+        if( remmina_protocol_widget_is_closed( gp ) )
+            sample.state = "closed";
+        else
+            sample.state = connected_time ? "connected" : "connecting";
+
+        remmina_protocol_widget_perf_get_totals( gp, &totals );
+        sample.values[REMMINA_METRICS_UP] = connected_time ? 1 : 0;
+        sample.values[REMMINA_METRICS_UPTIME] = connected_time ? ( now - connected_time ) / 1000000.0 : 0;
+        sample.values[REMMINA_METRICS_RECONNECTS] = totals.reconnects;
+        sample.values[REMMINA_METRICS_BYTES_IN] = totals.bytes_in;
+        sample.values[REMMINA_METRICS_BYTES_OUT] = totals.bytes_out;
+        sample.values[REMMINA_METRICS_FRAMES_RECEIVED] = totals.frames_received;
+        sample.values[REMMINA_METRICS_FRAMES_PRESENTED] = totals.frames_presented;
+        sample.values[REMMINA_METRICS_DAMAGE_PIXELS] = totals.damage_pixels;
+        sample.values[REMMINA_METRICS_SSH_CHANNELS] = remmina_protocol_widget_get_ssh_channels( gp );
+        g_array_append_val( samples, sample );
+    }
+    return samples;
+}
+
+static void remmina_metrics_append_label( GString *out, const char *name, const char *value, bool last )
+{
+    TRACE_CALL( __func__ );
+    const char *p;
+
+    g_string_append_printf( out, "%s=\"", name );
+    for( p = value ? value : ""; *p; p++ )
+    {
+        if( *p == '\\' || *p == '"' )
+            g_string_append_c( out, '\\' );
+        if( *p == '\n' )
+            g_string_append( out, "\\n" );
+        else
+            g_string_append_c( out, *p );
+    }
+    g_string_append( out, last ? "\"" : "\"," );
+}
+
+static char *remmina_metrics_prometheus( GArray *samples )
+{
+    TRACE_CALL( __func__ );
+    GString *out = g_string_new( NULL );
+    RemminaMetricsSample *sample;
+    char id[16];
+    guint i, j;
+
+    g_string_append( out, "# HELP remmina_process_resident_bytes Resident memory of the Remmina process\n" );
+    g_string_append( out, "# TYPE remmina_process_resident_bytes gauge\n" );
+    g_string_append_printf( out, "remmina_process_resident_bytes %" G_GUINT64_FORMAT "\n", remmina_metrics_get_rss() );
+    g_string_append( out, "# HELP remmina_connections Connection tabs open\n" );
+    g_string_append( out, "# TYPE remmina_connections gauge\n" );
+    g_string_append_printf( out, "remmina_connections %u\n", samples->len );
+
+    /* The exposition format wants the samples of a family next to each other */
+    for( j = 0; j < REMMINA_METRICS_N; j++ )
+    {
+        g_string_append_printf( out, "# HELP %s %s\n", metrics_families[j].name, metrics_families[j].help );
+        g_string_append_printf( out, "# TYPE %s %s\n", metrics_families[j].name, metrics_families[j].type );
+        for( i = 0; i < samples->len; i++ )
+        {
+            sample = &g_array_index( samples, RemminaMetricsSample, i );
+            g_snprintf( id, sizeof( id ), "%u", sample->id );
+            g_string_append_printf( out, "%s{", metrics_families[j].name );
+            remmina_metrics_append_label( out, "id", id, FALSE );
+            remmina_metrics_append_label( out, "name", sample->name, FALSE );
+            remmina_metrics_append_label( out, "protocol", sample->protocol, FALSE );
+            remmina_metrics_append_label( out, "state", sample->state, TRUE );
+            g_string_append_printf( out, "} %.17g\n", sample->values[j] );
+        }
+    }
+    return g_string_free( out, FALSE );
+}
+
+static char *remmina_metrics_json( GArray *samples )
+{
+    TRACE_CALL( __func__ );
+    JsonBuilder *b = json_builder_new();
+    JsonGenerator *g;
+    JsonNode *root;
+    RemminaMetricsSample *sample;
+    char *json;
+    guint i, j;
+
+    json_builder_begin_object( b );
+    json_builder_set_member_name( b, "process_resident_bytes" );
+    json_builder_add_int_value( b, remmina_metrics_get_rss() );
+    json_builder_set_member_name( b, "connections" );
+    json_builder_begin_array( b );
+    for( i = 0; i < samples->len; i++ )
+    {
+        sample = &g_array_index( samples, RemminaMetricsSample, i );
+        json_builder_begin_object( b );
+        json_builder_set_member_name( b, "id" );
+        json_builder_add_int_value( b, sample->id );
+        json_builder_set_member_name( b, "name" );
+        json_builder_add_string_value( b, sample->name ? sample->name : "" );
+        json_builder_set_member_name( b, "protocol" );
+        json_builder_add_string_value( b, sample->protocol ? sample->protocol : "" );
+        json_builder_set_member_name( b, "state" );
+        json_builder_add_string_value( b, sample->state );
+        for( j = 0; j < REMMINA_METRICS_N; j++ )
+        {
+            json_builder_set_member_name( b, metrics_families[j].json_key );
+            if( j == REMMINA_METRICS_UPTIME )
+                json_builder_add_double_value( b, sample->values[j] );
+            else
+                json_builder_add_int_value( b, (gint64)sample->values[j] );
+        }
+        json_builder_end_object( b );
+    }
+    json_builder_end_array( b );
+    json_builder_end_object( b );
+
+    root = json_builder_get_root( b );
+    g = json_generator_new();
+    json_generator_set_root( g, root );
+    json = json_generator_to_data( g, NULL );
+    g_object_unref( g );
+    json_node_unref( root );
+    g_object_unref( b );
+    return json;
+}
+
+static void remmina_metrics_client_free( RemminaMetricsClient *client )
+{
+    TRACE_CALL( __func__ );
+    if( client->timeout_source )
+        g_source_remove( client->timeout_source );
+    g_io_stream_close( G_IO_STREAM( client->connection ), NULL, NULL );
+    g_object_unref( client->cancellable );
+    g_object_unref( client->connection );
+    g_free( client->response );
+    g_free( client );
+}
+
+static void remmina_metrics_response_written( GObject *source, GAsyncResult *res, gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    RemminaMetricsClient *client = (RemminaMetricsClient *)user_data;
+    GError *err = NULL;
+
+    if( !g_output_stream_write_all_finish( G_OUTPUT_STREAM( source ), res, NULL, &err ) )
+    {
+        REMMINA_DEBUG( "Could not send metrics: %s", err->message );
+        g_error_free( err );
+    }
+    remmina_metrics_client_free( client );
+}
+
+static void remmina_metrics_request_read( GObject *source, GAsyncResult *res, gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    RemminaMetricsClient *client = (RemminaMetricsClient *)user_data;
+    GArray *samples;
+    gssize len;
+    char *body, *eol;
+    bool http, json;
+
+    if( client->timeout_source )
+    {
+        g_source_remove( client->timeout_source );
+        client->timeout_source = 0;
+    }
+
+    /* EOF, errors and timeouts on the request are served as a raw Prometheus body.
+     * Only the first line of what arrived counts, a longer one is cut at the read size. */
+    len = g_input_stream_read_finish( G_INPUT_STREAM( source ), res, NULL );
+    client->request[len > 0 ? len : 0] = '\0';
+    eol = strpbrk( client->request, "\r\n" );
+    if( eol )
+        *eol = '\0';
+    http = g_str_has_prefix( client->request, "GET " );
+    json = strstr( client->request, "json" ) != NULL;
+
+    samples = remmina_metrics_collect();
+    body = json ? remmina_metrics_json( samples ) : remmina_metrics_prometheus( samples );
+    g_array_free( samples, TRUE );
+
+    if( http )
+    {
+        client->response = g_strdup_printf( "HTTP/1.0 200 OK\r\n"
+                                            "Content-Type: %s\r\n"
+                                            "Content-Length: %zu\r\n"
+                                            "Connection: close\r\n\r\n%s",
+                                            json ? "application/json" : "text/plain; version=0.0.4",
+                                            strlen( body ),
+                                            body );
+        g_free( body );
+    }
+    else
+    {
+        client->response = body;
+    }
+
+    g_output_stream_write_all_async( g_io_stream_get_output_stream( G_IO_STREAM( client->connection ) ),
+                                     client->response,
+                                     strlen( client->response ),
+                                     G_PRIORITY_DEFAULT,
+                                     NULL,
+                                     remmina_metrics_response_written,
+                                     client );
+}
+
+static gboolean remmina_metrics_request_timeout( gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    RemminaMetricsClient *client = (RemminaMetricsClient *)user_data;
+
+    client->timeout_source = 0;
+    g_cancellable_cancel( client->cancellable );
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean remmina_metrics_incoming( GSocketService *service,
+                                          GSocketConnection *connection,
+                                          GObject *source_object,
+                                          gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    RemminaMetricsClient *client = g_new0( RemminaMetricsClient, 1 );
+
+    client->connection = G_SOCKET_CONNECTION( g_object_ref( connection ) );
+    client->cancellable = g_cancellable_new();
+    client->timeout_source =
+        g_timeout_add_seconds( REMMINA_METRICS_REQUEST_TIMEOUT, remmina_metrics_request_timeout, client );
+    g_input_stream_read_async( g_io_stream_get_input_stream( G_IO_STREAM( connection ) ),
+                               client->request,
+                               sizeof( client->request ) - 1,
+                               G_PRIORITY_DEFAULT,
+                               client->cancellable,
+                               remmina_metrics_request_read,
+                               client );
+    return TRUE;
+}
+
+static GSocket *remmina_metrics_listen( const char *path, GError **error )
+{
+    TRACE_CALL( __func__ );
+    struct sockaddr_un addr;
+    GSocketAddress *address;
+    GSocket *socket;
+    bool ok;
+
+    if( strlen( path ) >= sizeof( addr.sun_path ) )
+    {
+        g_set_error( error, G_IO_ERROR, G_IO_ERROR_FILENAME_TOO_LONG, "Socket path %s is too long", path );
+        return NULL;
+    }
+
+    socket = g_socket_new( G_SOCKET_FAMILY_UNIX, G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT, error );
+    if( !socket )
+        return NULL;
+
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    g_strlcpy( addr.sun_path, path, sizeof( addr.sun_path ) );
+    address = g_socket_address_new_from_native( &addr, sizeof( addr ) );
+
+    /* A previous instance that crashed leaves its socket behind */
+    g_unlink( path );
+    ok = g_socket_bind( socket, address, FALSE, error ) && g_socket_listen( socket, error );
+    g_object_unref( address );
+    if( !ok )
+    {
+        g_object_unref( socket );
+        return NULL;
+    }
+    return socket;
+}
+
+void remmina_metrics_init()
+{
+    TRACE_CALL( __func__ );
+    GError *err = NULL;
+    GSocket *socket;
+    char *dir;
+
+    if( !remmina_pref.metrics_endpoint || metrics_service )
+        return;
+
+    /* The runtime directory is private to the user, so is the socket */
+    dir = g_build_filename( g_get_user_runtime_dir(), "remmina", NULL );
+    g_mkdir_with_parents( dir, 0700 );
+    metrics_socket_path = g_build_filename( dir, REMMINA_METRICS_SOCKET_NAME, NULL );
+    g_free( dir );
+
+    socket = remmina_metrics_listen( metrics_socket_path, &err );
+    if( socket )
+    {
+        metrics_service = g_socket_service_new();
+        if( !g_socket_listener_add_socket( G_SOCKET_LISTENER( metrics_service ), socket, NULL, &err ) )
+            g_clear_object( &metrics_service );
+        g_object_unref( socket );
+    }
+    if( !metrics_service )
+    {
+        REMMINA_WARNING( "Could not start the metrics endpoint on %s: %s", metrics_socket_path, err->message );
+        g_error_free( err );
+        g_clear_pointer( &metrics_socket_path, g_free );
+        return;
+    }
+
+    g_signal_connect( metrics_service, "incoming", G_CALLBACK( remmina_metrics_incoming ), NULL );
+    g_socket_service_start( metrics_service );
+    remmina_protocol_widget_perf_enable_totals( TRUE );
+    REMMINA_INFO( "Metrics endpoint listening on %s", metrics_socket_path );
+}
+
+void remmina_metrics_shutdown()
+{
+    TRACE_CALL( __func__ );
+
+    if( !metrics_service )
+        return;
+
+    g_socket_service_stop( metrics_service );
+    g_socket_listener_close( G_SOCKET_LISTENER( metrics_service ) );
+    g_clear_object( &metrics_service );
+    g_unlink( metrics_socket_path );
+    g_clear_pointer( &metrics_socket_path, g_free );
+}
@@ -40,148 +40,261 @@
 
 RemminaMonitor *rm_monitor;
 
-static void remmina_monitor_can_reach_cb( GNetworkMonitor *netmonitor, GAsyncResult *result, RemminaMonitor *monitor )
+/* Profiles sharing a server are probed once, with at most
+ * REMMINA_MONITOR_MAX_PROBES TCP connects in flight. Results are kept for
+ * REMMINA_MONITOR_PROBE_TTL seconds so that reloading the list does not hit
+ * the resolver and the servers again. Profiles asked for while offline are
+ * queued and probed once connectivity is back, expired results are probed
+ * again whenever the network changes. */
+#define REMMINA_MONITOR_MAX_PROBES 8
+#define REMMINA_MONITOR_PROBE_TTL 60
+#define REMMINA_MONITOR_PROBE_TIMEOUT 3
+
+struct RemminaMonitorResult
 {
-    g_autoptr( GError ) error = NULL;
+    gint latency;
+    gint64 expires;
+    /* What the result was measured for, to probe it again */
+    char *host;
+    gint port;
+    GSList *filenames;
+    GSList *statefiles;
+};
+
+struct RemminaMonitorProbe
+{
+    RemminaMonitor *monitor;
+    char *key;
+    char *host;
+    gint port;
+    GSList *filenames;
+    GSList *statefiles;
+    gint64 start;
+};
+
+static void remmina_monitor_probe_next( RemminaMonitor *monitor );
+
+static void remmina_monitor_result_free( RemminaMonitorResult *result )
+{
+    TRACE_CALL( __func__ );
+    g_free( result->host );
+    g_slist_free_full( result->filenames, g_free );
+    g_slist_free_full( result->statefiles, g_free );
+    g_free( result );
+}
 
-    char *status = NULL;
+static void remmina_monitor_probe_free( RemminaMonitorProbe *probe )
+{
+    TRACE_CALL( __func__ );
+    g_free( probe->key );
+    g_free( probe->host );
+    g_slist_free_full( probe->filenames, g_free );
+    g_slist_free_full( probe->statefiles, g_free );
+    g_free( probe );
+}
 
-    bool is_reachable = g_network_monitor_can_reach_finish( netmonitor, result, &error );
+static void remmina_monitor_probe_done( RemminaMonitorProbe *probe, gint latency )
+{
+    TRACE_CALL( __func__ );
+    RemminaMonitor *monitor = probe->monitor;
+    RemminaMonitorResult *result;
+    GSList *l;
+
+    for( l = probe->statefiles; l; l = l->next )
+        remmina_file_state_save_int( (const char *)l->data, "latency", latency );
+
+    if( monitor->probe_cb )
+        monitor->probe_cb( probe->filenames, latency, monitor->probe_cb_data );
+
+    result = g_new0( RemminaMonitorResult, 1 );
+    result->latency = latency;
+    result->expires = g_get_monotonic_time() + REMMINA_MONITOR_PROBE_TTL * G_USEC_PER_SEC;
+    result->host = probe->host;
+    result->port = probe->port;
+    result->filenames = probe->filenames;
+    result->statefiles = probe->statefiles;
+    probe->host = NULL;
+    probe->filenames = probe->statefiles = NULL;
+    g_hash_table_replace( monitor->probe_cache, g_strdup( probe->key ), result );
+
+    g_hash_table_remove( monitor->probe_pending, probe->key );
+    remmina_monitor_probe_free( probe );
+
+    monitor->probe_running--;
+    remmina_monitor_probe_next( monitor );
+}
 
-    const char *addr_tostr = g_strdup( g_socket_connectable_to_string( monitor->addr ) );
-    //char *value = (char *)g_hash_table_lookup (monitor->server_status, addr_tostr);
+static void remmina_monitor_probe_cb( GObject *source, GAsyncResult *res, gpointer data )
+{
+    TRACE_CALL( __func__ );
+    RemminaMonitorProbe *probe = (RemminaMonitorProbe *)data;
+    g_autoptr( GError ) error = NULL;
+    GSocketConnection *connection;
+    gint latency;
 
-    if( is_reachable )
+    connection = g_socket_client_connect_to_host_finish( G_SOCKET_CLIENT( source ), res, &error );
+    if( connection )
     {
-        REMMINA_DEBUG( "Network object %s is reachable", g_socket_connectable_to_string( monitor->addr ) );
-        status = g_strdup( "online" );
+        /* Includes the name lookup, as the user will experience it */
+        latency = ( g_get_monotonic_time() - probe->start ) / 1000;
+        REMMINA_DEBUG( "Network object %s is reachable in %d ms", probe->key, latency );
+        g_object_unref( connection );
     }
     else
     {
-        REMMINA_DEBUG( "Network object %s is not reachable", g_socket_connectable_to_string( monitor->addr ) );
-        status = g_strdup( "offline" );
+        REMMINA_DEBUG( "Network object %s is not reachable: %s", probe->key, error->message );
+        latency = REMMINA_MONITOR_LATENCY_UNREACHABLE;
     }
 
-    if( g_hash_table_replace( monitor->server_status, g_strdup( addr_tostr ), g_strdup( status ) ) )
+    remmina_monitor_probe_done( probe, latency );
+}
+
+static void remmina_monitor_probe_next( RemminaMonitor *monitor )
+{
+    TRACE_CALL( __func__ );
+    RemminaMonitorProbe *probe;
+    GSocketClient *client;
+
+    while( monitor->connected && monitor->probe_running < REMMINA_MONITOR_MAX_PROBES
+           && !g_queue_is_empty( monitor->probe_queue ) )
     {
-        REMMINA_DEBUG( "Inserting %s -> %s", addr_tostr, status );
+        probe = (RemminaMonitorProbe *)g_queue_pop_head( monitor->probe_queue );
+        monitor->probe_running++;
+        probe->start = g_get_monotonic_time();
+
+        client = g_socket_client_new();
+        g_socket_client_set_timeout( client, REMMINA_MONITOR_PROBE_TIMEOUT );
+        g_socket_client_connect_to_host_async( client, probe->host, probe->port, NULL, remmina_monitor_probe_cb, probe );
+        g_object_unref( client );
     }
-    else
+}
+
+/* The queued or running probe of key, a new queued one when there is none */
+static RemminaMonitorProbe *
+remmina_monitor_probe_get( RemminaMonitor *monitor, const char *key, const char *host, gint port )
+{
+    TRACE_CALL( __func__ );
+    RemminaMonitorProbe *probe;
+
+    probe = (RemminaMonitorProbe *)g_hash_table_lookup( monitor->probe_pending, key );
+    if( !probe )
     {
-        REMMINA_DEBUG( "Replacing %s -> %s", addr_tostr, status );
+        probe = g_new0( RemminaMonitorProbe, 1 );
+        probe->monitor = monitor;
+        probe->key = g_strdup( key );
+        probe->host = g_strdup( host );
+        probe->port = port;
+        g_hash_table_insert( monitor->probe_pending, probe->key, probe );
+        g_queue_push_tail( monitor->probe_queue, probe );
     }
-
-    /* Cannot use remminafile here because is freed by remmina_file_manager_iterate */
-    //if (remminafile)
-    //remmina_file_set_state_int (remminafile, "reachable", reachable);
-    g_free( status );
+    return probe;
 }
 
-char *remmina_monitor_can_reach( RemminaFile *remminafile, RemminaMonitor *monitor )
+static void remmina_monitor_probe_add_file( RemminaMonitorProbe *probe, const char *filename, const char *statefile )
 {
     TRACE_CALL( __func__ );
 
+    /* The list is refreshed while a probe is still running, do not add the profile twice */
+    if( g_slist_find_custom( probe->filenames, filename, (GCompareFunc)g_strcmp0 ) )
+        return;
+    probe->filenames = g_slist_prepend( probe->filenames, g_strdup( filename ) );
+    probe->statefiles = g_slist_prepend( probe->statefiles, g_strdup( statefile ) );
+}
+
+/* Host and port that will be dialed first when opening the profile */
+static bool remmina_monitor_get_address( RemminaFile *remminafile, char **host, gint *port )
+{
+    TRACE_CALL( __func__ );
     const char *server;
     const char *ssh_tunnel_server;
-    const char *addr_tostr;
-    char *status = NULL;
-    char *ssh_tunnel_host, *srv_host;
-    gint netmonit, srv_port, ssh_tunnel_port;
     const char *protocol;
     gint default_port = 0;
 
-    if( !remminafile )
-    {
-        status = g_strdup( "I/O Error" );
-        REMMINA_DEBUG( status );
-        return NULL;
-    }
-
-    netmonit = remmina_file_get_int( remminafile, "enable-netmonit", FALSE );
-
-    if( !netmonit )
-    {
-        status = g_strdup( "Monitoring disabled" );
-        REMMINA_DEBUG( status );
-        return NULL;
-    }
-
+    *host = NULL;
     protocol = remmina_file_get_string( remminafile, "protocol" );
-
-    if( protocol && protocol[0] != '\0' )
+    if( !protocol || protocol[0] == '\0' )
+        return FALSE;
+
+    if( g_strcmp0( "RDP", protocol ) == 0 )
+        default_port = 3389;
+    if( g_strcmp0( "VNC", protocol ) == 0 )
+        default_port = 5900;
+    if( g_strcmp0( "GVNC", protocol ) == 0 )
+        default_port = 5900;
+    if( g_strcmp0( "SPICE", protocol ) == 0 )
+        default_port = 5900;
+    if( g_strcmp0( "WWW", protocol ) == 0 )
+        default_port = 443;
+    if( g_strcmp0( "X2GO", protocol ) == 0 )
+        default_port = 22;
+    if( g_strcmp0( "SSH", protocol ) == 0 )
+        default_port = 22;
+    if( g_strcmp0( "SFTP", protocol ) == 0 )
+        default_port = 22;
+
+    /* Unknown protocols, and EXEC, cannot be monitored */
+    if( default_port == 0 )
+        return FALSE;
+
+    server = remmina_file_get_string( remminafile, "server" );
+    if( remmina_file_get_int( remminafile, "ssh_tunnel_enabled", FALSE ) )
     {
-        REMMINA_DEBUG( "Evaluating protocol %s for monitoring", protocol );
-        if( g_strcmp0( "RDP", protocol ) == 0 )
-            default_port = 3389;
-        if( g_strcmp0( "VNC", protocol ) == 0 )
-            default_port = 5900;
-        if( g_strcmp0( "GVNC", protocol ) == 0 )
-            default_port = 5900;
-        if( g_strcmp0( "SPICE", protocol ) == 0 )
-            default_port = 5900;
-        if( g_strcmp0( "WWW", protocol ) == 0 )
-            default_port = 443;
-        if( g_strcmp0( "X2GO", protocol ) == 0 )
-            default_port = 22;
-        if( g_strcmp0( "SSH", protocol ) == 0 )
-            default_port = 22;
-        if( g_strcmp0( "SFTP", protocol ) == 0 )
-            default_port = 22;
-        if( g_strcmp0( "EXEC", protocol ) == 0 )
-            default_port = -1;
-
-        if( default_port == 0 )
-        {
-            status = g_strdup( "Unknown protocol" );
-            REMMINA_DEBUG( status );
-            return NULL;
-        }
-        if( default_port < 0 )
-        {
-            status = g_strdup( "Cannot monitor" );
-            REMMINA_DEBUG( status );
-            return NULL;
-        }
-
         ssh_tunnel_server = remmina_file_get_string( remminafile, "ssh_tunnel_server" );
-        if( remmina_file_get_int( remminafile, "ssh_tunnel_enabled", FALSE ) )
-        {
-            remmina_public_get_server_port( ssh_tunnel_server, 22, &ssh_tunnel_host, &ssh_tunnel_port );
-            monitor->addr = g_network_address_new( ssh_tunnel_host, ssh_tunnel_port );
-            g_free( ssh_tunnel_host ), ssh_tunnel_host = NULL;
-        }
-        else
+        if( ssh_tunnel_server && ssh_tunnel_server[0] )
+            remmina_public_get_server_port( ssh_tunnel_server, 22, host, port );
+        else if( server && server[0] )
         {
-            server = remmina_file_get_string( remminafile, "server" );
-            remmina_public_get_server_port( server, default_port, &srv_host, &srv_port );
-            monitor->addr = g_network_address_new( srv_host, srv_port );
-            g_free( srv_host ), srv_host = NULL;
+            remmina_public_get_server_port( server, 22, host, port );
+            *port = 22;
         }
-        addr_tostr = g_strdup( g_socket_connectable_to_string( monitor->addr ) );
+    }
+    else if( server && server[0] && server[0] != '/' && !g_str_has_prefix( server, "unix:" ) )
+        remmina_public_get_server_port( server, default_port, host, port );
+
+    if( *host && ( *host )[0] )
+        return TRUE;
+    g_free( *host );
+    *host = NULL;
+    return FALSE;
+}
 
-        REMMINA_DEBUG( "addr is %s", addr_tostr );
-        if( monitor->connected && netmonit )
-        {
-            REMMINA_DEBUG( "Testing for %s", addr_tostr );
-            g_network_monitor_can_reach_async(
-                monitor->netmonitor, monitor->addr, NULL, (GAsyncReadyCallback)remmina_monitor_can_reach_cb, monitor );
-        }
+void remmina_monitor_set_probe_callback( RemminaMonitor *monitor, RemminaMonitorProbeFunc cb, gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    monitor->probe_cb = cb;
+    monitor->probe_cb_data = user_data;
+}
 
-        status = (char *)g_hash_table_lookup( monitor->server_status, addr_tostr );
-        //if (!status)
-        //g_hash_table_insert (monitor->server_status, g_strdup(addr_tostr), "offline");
-    }
+gint remmina_monitor_probe( RemminaMonitor *monitor, RemminaFile *remminafile )
+{
+    TRACE_CALL( __func__ );
+    RemminaMonitorResult *result;
+    RemminaMonitorProbe *probe;
+    char *host, *key;
+    gint port = 0;
+    gint latency = REMMINA_MONITOR_LATENCY_UNKNOWN;
+
+    if( !remminafile || !remmina_monitor_get_address( remminafile, &host, &port ) )
+        return REMMINA_MONITOR_LATENCY_UNKNOWN;
+
+    key = g_strdup_printf( "%s:%d", host, port );
+
+    result = (RemminaMonitorResult *)g_hash_table_lookup( monitor->probe_cache, key );
+    if( result )
+        latency = result->latency;
 
-    if( !status )
+    /* Queued even when offline, remmina_monitor_network_changed() starts it */
+    if( !result || result->expires <= g_get_monotonic_time() )
     {
-        return g_strdup( addr_tostr );
+        probe = remmina_monitor_probe_get( monitor, key, host, port );
+        remmina_monitor_probe_add_file(
+            probe, remmina_file_get_filename( remminafile ), remmina_file_get_statefile( remminafile ) );
+        remmina_monitor_probe_next( monitor );
     }
-    else
-        return status;
 
-    //g_free(ssh_tunnel_host), ssh_tunnel_host = NULL;
-    //g_free(srv_host), srv_host = NULL;
-    //g_free(dest), dest = NULL;
+    g_free( key );
+    g_free( host );
+    return latency;
 }
 
 GNetworkConnectivity remmina_network_monitor_status( RemminaMonitor *rm_monitor )
@@ -190,9 +303,6 @@ GNetworkConnectivity remmina_network_monitor_status( RemminaMonitor *rm_monitor
 
     GNetworkConnectivity status = g_network_monitor_get_connectivity( rm_monitor->netmonitor );
 
-    rm_monitor->server_status =
-        g_hash_table_new_full( g_str_hash, g_str_equal, (GDestroyNotify)g_free, (GDestroyNotify)g_free );
-
     switch( status )
     {
         case G_NETWORK_CONNECTIVITY_LOCAL:
@@ -219,6 +329,35 @@ GNetworkConnectivity remmina_network_monitor_status( RemminaMonitor *rm_monitor
     return status;
 }
 
+static void remmina_monitor_network_changed( GNetworkMonitor *netmonitor, gboolean network_available, gpointer data )
+{
+    TRACE_CALL( __func__ );
+    RemminaMonitor *monitor = (RemminaMonitor *)data;
+    RemminaMonitorResult *result;
+    RemminaMonitorProbe *probe;
+    GHashTableIter iter;
+    gpointer key, value;
+    gint64 now;
+    GSList *f, *s;
+
+    remmina_network_monitor_status( monitor );
+    if( !monitor->connected )
+        return;
+
+    now = g_get_monotonic_time();
+    g_hash_table_iter_init( &iter, monitor->probe_cache );
+    while( g_hash_table_iter_next( &iter, &key, &value ) )
+    {
+        result = (RemminaMonitorResult *)value;
+        if( result->expires > now )
+            continue;
+        probe = remmina_monitor_probe_get( monitor, (const char *)key, result->host, result->port );
+        for( f = result->filenames, s = result->statefiles; f && s; f = f->next, s = s->next )
+            remmina_monitor_probe_add_file( probe, (const char *)f->data, (const char *)s->data );
+    }
+    remmina_monitor_probe_next( monitor );
+}
+
 RemminaMonitor *remmina_network_monitor_new()
 {
     TRACE_CALL( __func__ );
@@ -226,6 +365,18 @@ RemminaMonitor *remmina_network_monitor_new()
     rm_monitor = g_new0( RemminaMonitor, 1 );
 
     rm_monitor->netmonitor = g_network_monitor_get_default();
+    rm_monitor->probe_cache =
+        g_hash_table_new_full( g_str_hash, g_str_equal, g_free, (GDestroyNotify)remmina_monitor_result_free );
+    /* Keys are owned by the probes */
+    rm_monitor->probe_pending = g_hash_table_new( g_str_hash, g_str_equal );
+    rm_monitor->probe_queue = g_queue_new();
+
+    /* The first list load probes right away, it happens before anything else asks for the status */
+    remmina_network_monitor_status( rm_monitor );
+    g_signal_connect( rm_monitor->netmonitor,
+                      "network-changed",
+                      G_CALLBACK( remmina_monitor_network_changed ),
+                      rm_monitor );
 
     return rm_monitor;
 }
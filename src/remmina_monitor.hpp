@@ -40,15 +40,31 @@
 
 #include "remmina_file.hpp"
 
+#define REMMINA_MONITOR_LATENCY_UNKNOWN -1
+#define REMMINA_MONITOR_LATENCY_UNREACHABLE -2
+
+/* Called on the main thread when a probe completes, filenames are the profiles
+ * sharing the probed address */
+typedef void ( *RemminaMonitorProbeFunc )( GSList *filenames, gint latency, gpointer user_data );
+
 struct RemminaMonitor
 {
     GNetworkMonitor *netmonitor;
     bool connected;
-    GSocketConnectable *addr;
-    bool reachable;
-    GHashTable *server_status;
+    /* host:port -> RemminaMonitorResult */
+    GHashTable *probe_cache;
+    /* host:port -> RemminaMonitorProbe, queued or in flight */
+    GHashTable *probe_pending;
+    GQueue *probe_queue;
+    gint probe_running;
+    RemminaMonitorProbeFunc probe_cb;
+    gpointer probe_cb_data;
 };
 
 GNetworkConnectivity remmina_network_monitor_status( RemminaMonitor *rm_monitor );
 RemminaMonitor *remmina_network_monitor_new();
-char *remmina_monitor_can_reach( RemminaFile *remminafile, RemminaMonitor *monitor );
+void remmina_monitor_set_probe_callback( RemminaMonitor *monitor, RemminaMonitorProbeFunc cb, gpointer user_data );
+/* Returns the cached latency in ms of the first host of the profile, or one of
+ * the REMMINA_MONITOR_LATENCY_* values, and schedules a new probe when the
+ * cached value is missing or expired */
+gint remmina_monitor_probe( RemminaMonitor *monitor, RemminaFile *remminafile );
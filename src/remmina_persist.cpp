@@ -0,0 +1,275 @@
+/*
+ * Remmina - The GTK+ Remote Desktop Client
+ * Copyright (C) 2016-2022 Antenore Gatta, Giovanni Panozzo
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ *
+ *  In addition, as a special exception, the copyright holders give
+ *  permission to link the code of portions of this program with the
+ *  OpenSSL library under certain conditions as described in each
+ *  individual source file, and distribute linked combinations
+ *  including the two.
+ *  You must obey the GNU General Public License in all respects
+ *  for all of the code used other than OpenSSL. *  If you modify
+ *  file(s) with this exception, you may extend this exception to your
+ *  version of the file(s), but you are not obligated to do so. *  If you
+ *  do not wish to do so, delete this exception statement from your
+ *  version. *  If you delete this exception statement from all source
+ *  files in the program, then also delete it here.
+ *
+ */
+
+
+/* Write-behind persistence of small keyfiles, remmina.pref and the profile
+ * state files. Changes are kept in memory per file, so that many saves in a
+ * row (sorting the list, resizing the window, connecting) turn into a single
+ * write. Writes happen on one worker thread, which keeps them ordered and
+ * keeps slow home directories (NFS and the like) from stalling the UI. */
+
+#include "config.h"
+#include <glib.h>
+#include "remmina/remmina_trace_calls.hpp"
+#include "remmina_log.hpp"
+#include "remmina_persist.hpp"
+
+/* Coalescing window, in ms */
+#define REMMINA_PERSIST_DELAY 500
+
+static GMutex persist_mutex;
+/* path -> GKeyFile of the changes waiting for the next write */
+static GHashTable *persist_pending = NULL;
+/* Same, for the changes the worker is currently writing */
+static GHashTable *persist_writing = NULL;
+static GThreadPool *persist_pool = NULL;
+static guint persist_source = 0;
+
+static gboolean remmina_persist_dispatch( gpointer data );
+
+static void remmina_persist_copy_keys( GKeyFile *dest, GKeyFile *src )
+{
+    TRACE_CALL( __func__ );
+    char **groups, **keys, *value;
+    gsize i, j;
+
+    groups = g_key_file_get_groups( src, NULL );
+    for( i = 0; groups[i]; i++ )
+    {
+        keys = g_key_file_get_keys( src, groups[i], NULL, NULL );
+        if( !keys )
+            continue;
+        for( j = 0; keys[j]; j++ )
+        {
+            value = g_key_file_get_value( src, groups[i], keys[j], NULL );
+            if( value )
+                g_key_file_set_value( dest, groups[i], keys[j], value );
+            g_free( value );
+        }
+        g_strfreev( keys );
+    }
+    g_strfreev( groups );
+}
+
+static void remmina_persist_write( const char *path, GKeyFile *changes )
+{
+    TRACE_CALL( __func__ );
+    GKeyFile *keyfile;
+    GError *error = NULL;
+    char *content;
+    gsize length;
+
+    /* Read again, keys not changed here may have been written by someone else */
+    keyfile = g_key_file_new();
+    g_key_file_load_from_file( keyfile, path, G_KEY_FILE_NONE, NULL );
+    remmina_persist_copy_keys( keyfile, changes );
+    content = g_key_file_to_data( keyfile, &length, NULL );
+    /* Written to a temporary file and renamed over path */
+    if( !g_file_set_contents( path, content, length, &error ) )
+    {
+        REMMINA_WARNING( "Unable to save %s: %s", path, error->message );
+        g_error_free( error );
+    }
+    g_free( content );
+    g_key_file_free( keyfile );
+}
+
+static void remmina_persist_write_all( GHashTable *files )
+{
+    TRACE_CALL( __func__ );
+    GHashTableIter iter;
+    gpointer path, changes;
+    gint64 start = g_get_monotonic_time();
+
+    g_hash_table_iter_init( &iter, files );
+    while( g_hash_table_iter_next( &iter, &path, &changes ) )
+        remmina_persist_write( (const char *)path, (GKeyFile *)changes );
+    REMMINA_DEBUG( "Saved %u files in %" G_GINT64_FORMAT " ms",
+                   g_hash_table_size( files ),
+                   ( g_get_monotonic_time() - start ) / 1000 );
+}
+
+static void remmina_persist_worker( gpointer data, gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    GHashTable *files = (GHashTable *)data;
+
+    remmina_persist_write_all( files );
+
+    g_mutex_lock( &persist_mutex );
+    persist_writing = NULL;
+    /* Changes queued meanwhile waited for this batch */
+    if( persist_pending && g_hash_table_size( persist_pending ) > 0 && !persist_source )
+        persist_source = g_timeout_add( REMMINA_PERSIST_DELAY, remmina_persist_dispatch, NULL );
+    g_mutex_unlock( &persist_mutex );
+    g_hash_table_destroy( files );
+}
+
+static GHashTable *remmina_persist_files_new()
+{
+    return g_hash_table_new_full( g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_key_file_free );
+}
+
+static gboolean remmina_persist_dispatch( gpointer data )
+{
+    TRACE_CALL( __func__ );
+    GHashTable *files;
+    GError *error = NULL;
+
+    g_mutex_lock( &persist_mutex );
+    persist_source = 0;
+    /* Only one batch at a time, the worker schedules the next one */
+    if( persist_writing || !persist_pending || g_hash_table_size( persist_pending ) == 0 )
+    {
+        g_mutex_unlock( &persist_mutex );
+        return G_SOURCE_REMOVE;
+    }
+    files = persist_pending;
+    persist_pending = remmina_persist_files_new();
+    persist_writing = files;
+    g_mutex_unlock( &persist_mutex );
+
+    if( !persist_pool )
+        persist_pool = g_thread_pool_new( remmina_persist_worker, NULL, 1, FALSE, NULL );
+    if( !g_thread_pool_push( persist_pool, files, &error ) )
+    {
+        REMMINA_WARNING( "Unable to start the save worker: %s", error ? error->message : "" );
+        g_clear_error( &error );
+        remmina_persist_worker( files, NULL );
+    }
+    return G_SOURCE_REMOVE;
+}
+
+void remmina_persist_merge( const char *path, GKeyFile *changes )
+{
+    TRACE_CALL( __func__ );
+    GKeyFile *pending;
+
+    if( !path )
+        return;
+
+    g_mutex_lock( &persist_mutex );
+    if( !persist_pending )
+        persist_pending = remmina_persist_files_new();
+    pending = (GKeyFile *)g_hash_table_lookup( persist_pending, path );
+    if( !pending )
+    {
+        pending = g_key_file_new();
+        g_hash_table_insert( persist_pending, g_strdup( path ), pending );
+    }
+    remmina_persist_copy_keys( pending, changes );
+    if( !persist_source && !persist_writing )
+        persist_source = g_timeout_add( REMMINA_PERSIST_DELAY, remmina_persist_dispatch, NULL );
+    g_mutex_unlock( &persist_mutex );
+}
+
+void remmina_persist_set_string( const char *path, const char *group, const char *key, const char *value )
+{
+    TRACE_CALL( __func__ );
+    GKeyFile *changes = g_key_file_new();
+
+    g_key_file_set_string( changes, group, key, value ? value : "" );
+    remmina_persist_merge( path, changes );
+    g_key_file_free( changes );
+}
+
+void remmina_persist_set_integer( const char *path, const char *group, const char *key, gint value )
+{
+    TRACE_CALL( __func__ );
+    GKeyFile *changes = g_key_file_new();
+
+    g_key_file_set_integer( changes, group, key, value );
+    remmina_persist_merge( path, changes );
+    g_key_file_free( changes );
+}
+
+gboolean remmina_persist_load( GKeyFile *keyfile, const char *path, GError **error )
+{
+    TRACE_CALL( __func__ );
+    GKeyFile *changes;
+    gboolean ret, merged = FALSE;
+
+    ret = g_key_file_load_from_file( keyfile, path, G_KEY_FILE_NONE, error );
+
+    g_mutex_lock( &persist_mutex );
+    /* Older changes first */
+    if( persist_writing && ( changes = (GKeyFile *)g_hash_table_lookup( persist_writing, path ) ) )
+    {
+        remmina_persist_copy_keys( keyfile, changes );
+        merged = TRUE;
+    }
+    if( persist_pending && ( changes = (GKeyFile *)g_hash_table_lookup( persist_pending, path ) ) )
+    {
+        remmina_persist_copy_keys( keyfile, changes );
+        merged = TRUE;
+    }
+    g_mutex_unlock( &persist_mutex );
+
+    /* A file not created yet exists as far as the caller is concerned */
+    if( merged && !ret )
+    {
+        if( error )
+            g_clear_error( error );
+        ret = TRUE;
+    }
+    return ret;
+}
+
+void remmina_persist_flush()
+{
+    TRACE_CALL( __func__ );
+    GHashTable *files;
+
+    /* Wait for the batch being written */
+    if( persist_pool )
+    {
+        g_thread_pool_free( persist_pool, FALSE, TRUE );
+        persist_pool = NULL;
+    }
+
+    g_mutex_lock( &persist_mutex );
+    if( persist_source )
+    {
+        g_source_remove( persist_source );
+        persist_source = 0;
+    }
+    files = persist_pending;
+    persist_pending = NULL;
+    g_mutex_unlock( &persist_mutex );
+
+    if( files && g_hash_table_size( files ) > 0 )
+        remmina_persist_write_all( files );
+    if( files )
+        g_hash_table_destroy( files );
+}
@@ -0,0 +1,51 @@
+/*
+ * Remmina - The GTK+ Remote Desktop Client
+ * Copyright (C) 2016-2022 Antenore Gatta, Giovanni Panozzo
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ *
+ *  In addition, as a special exception, the copyright holders give
+ *  permission to link the code of portions of this program with the
+ *  OpenSSL library under certain conditions as described in each
+ *  individual source file, and distribute linked combinations
+ *  including the two.
+ *  You must obey the GNU General Public License in all respects
+ *  for all of the code used other than OpenSSL. *  If you modify
+ *  file(s) with this exception, you may extend this exception to your
+ *  version of the file(s), but you are not obligated to do so. *  If you
+ *  do not wish to do so, delete this exception statement from your
+ *  version. *  If you delete this exception statement from all source
+ *  files in the program, then also delete it here.
+ *
+ */
+
+
+#pragma once
+
+#include <glib.h>
+
+/* Queue the keys of changes to be written to the keyfile at path. Changes to the
+ * same file are coalesced for a short while, then a worker thread merges them into
+ * the file on disk and replaces it atomically. changes is not modified. */
+void remmina_persist_merge( const char *path, GKeyFile *changes );
+void remmina_persist_set_string( const char *path, const char *group, const char *key, const char *value );
+void remmina_persist_set_integer( const char *path, const char *group, const char *key, gint value );
+
+/* g_key_file_load_from_file() that also sees the changes not yet written */
+gboolean remmina_persist_load( GKeyFile *keyfile, const char *path, GError **error );
+
+/* Write everything still pending and wait for it, to be called before exiting */
+void remmina_persist_flush();
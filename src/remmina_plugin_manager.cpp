@@ -53,6 +53,7 @@
 #include "rcw.hpp"
 #include "remmina_plugin_manager.hpp"
 #include "remmina_plugin_native.hpp"
+#include "remmina_screenshot.hpp"
 #ifdef WITH_PYTHONLIBS
 #    include "remmina_plugin_python.hpp"
 #endif
@@ -265,7 +266,11 @@ RemminaPluginService remmina_plugin_manager_service = { remmina_plugin_manager_r
                                                         remmina_masterthread_exec_is_main_thread,
                                                         remmina_gtksocket_available,
                                                         remmina_protocol_widget_get_profile_remote_width,
-                                                        remmina_protocol_widget_get_profile_remote_height };
+                                                        remmina_protocol_widget_get_profile_remote_height,
+                                                        remmina_screenshot_save_async,
+                                                        remmina_protocol_widget_perf_add,
+                                                        remmina_protocol_widget_start_direct_tunnel_socket,
+                                                        remmina_protocol_widget_perf_enabled };
 
 const char *get_filename_ext( const char *filename )
 {
@@ -48,9 +48,11 @@
 
 #include "remmina_sodium.hpp"
 
+#include "remmina_persist.hpp"
 #include "remmina_public.hpp"
 #include "remmina_string_array.hpp"
 #include "remmina_pref.hpp"
+#include "remmina_screenshot.hpp"
 #include "remmina/remmina_trace_calls.hpp"
 
 const char *default_resolutions = "640x480,800x600,1024x768,1152x864,1280x960,1400x1050";
@@ -74,21 +76,12 @@ static void remmina_pref_gen_secret()
     TRACE_CALL( __func__ );
     guchar s[32];
     gint i;
-    GKeyFile *gkeyfile;
-    g_autofree char *content = NULL;
-    gsize length;
 
     for( i = 0; i < 32; i++ )
         s[i] = (guchar)( randombytes_uniform( 257 ) );
     remmina_pref.secret = g_base64_encode( s, 32 );
 
-    gkeyfile = g_key_file_new();
-    g_key_file_load_from_file( gkeyfile, remmina_pref_file, G_KEY_FILE_NONE, NULL );
-    g_key_file_set_string( gkeyfile, "remmina_pref", "secret", remmina_pref.secret );
-    content = g_key_file_to_data( gkeyfile, &length, NULL );
-    g_file_set_contents( remmina_pref_file, content, length, NULL );
-
-    g_key_file_free( gkeyfile );
+    remmina_persist_set_string( remmina_pref_file, "remmina_pref", "secret", remmina_pref.secret );
 }
 
 static guint remmina_pref_get_keyval_from_str( const char *str )
@@ -281,13 +274,19 @@ void remmina_pref_init()
 
     gkeyfile = g_key_file_new();
 
-    g_key_file_load_from_file( gkeyfile, remmina_pref_file, G_KEY_FILE_NONE, NULL );
+    remmina_persist_load( gkeyfile, remmina_pref_file, NULL );
 
     if( g_key_file_has_key( gkeyfile, "remmina_pref", "save_view_mode", NULL ) )
         remmina_pref.save_view_mode = g_key_file_get_boolean( gkeyfile, "remmina_pref", "save_view_mode", NULL );
     else
         remmina_pref.save_view_mode = TRUE;
 
+    if( g_key_file_has_key( gkeyfile, "remmina_pref", "prewarm_connections", NULL ) )
+        remmina_pref.prewarm_connections =
+            g_key_file_get_boolean( gkeyfile, "remmina_pref", "prewarm_connections", NULL );
+    else
+        remmina_pref.prewarm_connections = FALSE;
+
     if( g_key_file_has_key( gkeyfile, "remmina_pref", "use_master_password", NULL ) )
         remmina_pref.use_master_password =
             g_key_file_get_boolean( gkeyfile, "remmina_pref", "use_master_password", NULL );
@@ -354,6 +353,11 @@ void remmina_pref_init()
     else
         remmina_pref.hide_searchbar = FALSE;
 
+    if( g_key_file_has_key( gkeyfile, "remmina_pref", "show_latency", NULL ) )
+        remmina_pref.show_latency = g_key_file_get_boolean( gkeyfile, "remmina_pref", "show_latency", NULL );
+    else
+        remmina_pref.show_latency = FALSE;
+
     if( g_key_file_has_key( gkeyfile, "remmina_pref", "default_action", NULL ) )
         remmina_pref.default_action = g_key_file_get_integer( gkeyfile, "remmina_pref", "default_action", NULL );
     else
@@ -462,6 +466,11 @@ void remmina_pref_init()
     else
         remmina_pref.screenshot_name = g_strdup( "remmina_%p_%h_%Y%m%d-%H%M%S" );
 
+    if( g_key_file_has_key( gkeyfile, "remmina_pref", "screenshot_format", NULL ) )
+        remmina_pref.screenshot_format = g_key_file_get_integer( gkeyfile, "remmina_pref", "screenshot_format", NULL );
+    else
+        remmina_pref.screenshot_format = REMMINA_SCREENSHOT_FORMAT_PNG;
+
     if( g_key_file_has_key( gkeyfile, "remmina_pref", "ssh_parseconfig", NULL ) )
         remmina_pref.ssh_parseconfig = g_key_file_get_boolean( gkeyfile, "remmina_pref", "ssh_parseconfig", NULL );
     else
@@ -493,6 +502,18 @@ void remmina_pref_init()
     else
         remmina_pref.ssh_tcp_usrtimeout = SSH_SOCKET_TCP_USER_TIMEOUT;
 
+    if( g_key_file_has_key( gkeyfile, "remmina_pref", "ssh_pool_idle_timeout", NULL ) )
+        remmina_pref.ssh_pool_idle_timeout =
+            g_key_file_get_integer( gkeyfile, "remmina_pref", "ssh_pool_idle_timeout", NULL );
+    else
+        remmina_pref.ssh_pool_idle_timeout = SSH_POOL_IDLE_TIMEOUT;
+
+    if( g_key_file_has_key( gkeyfile, "remmina_pref", "ssh_tunnel_socketpair", NULL ) )
+        remmina_pref.ssh_tunnel_socketpair =
+            g_key_file_get_boolean( gkeyfile, "remmina_pref", "ssh_tunnel_socketpair", NULL );
+    else
+        remmina_pref.ssh_tunnel_socketpair = FALSE;
+
     if( g_key_file_has_key( gkeyfile, "remmina_pref", "applet_new_ontop", NULL ) )
         remmina_pref.applet_new_ontop = g_key_file_get_boolean( gkeyfile, "remmina_pref", "applet_new_ontop", NULL );
     else
@@ -540,6 +561,23 @@ void remmina_pref_init()
     else
         remmina_pref.recent_maximum = 10;
 
+    if( g_key_file_has_key( gkeyfile, "remmina_pref", "launcher_max_parallel", NULL ) )
+        remmina_pref.launcher_max_parallel =
+            MAX( 0, g_key_file_get_integer( gkeyfile, "remmina_pref", "launcher_max_parallel", NULL ) );
+    else
+        remmina_pref.launcher_max_parallel = 0;
+
+    if( g_key_file_has_key( gkeyfile, "remmina_pref", "log_max_lines", NULL ) )
+        remmina_pref.log_max_lines =
+            MAX( 100, g_key_file_get_integer( gkeyfile, "remmina_pref", "log_max_lines", NULL ) );
+    else
+        remmina_pref.log_max_lines = 10000;
+
+    if( g_key_file_has_key( gkeyfile, "remmina_pref", "metrics_endpoint", NULL ) )
+        remmina_pref.metrics_endpoint = g_key_file_get_boolean( gkeyfile, "remmina_pref", "metrics_endpoint", NULL );
+    else
+        remmina_pref.metrics_endpoint = FALSE;
+
     if( g_key_file_has_key( gkeyfile, "remmina_pref", "default_mode", NULL ) )
         remmina_pref.default_mode = g_key_file_get_integer( gkeyfile, "remmina_pref", "default_mode", NULL );
     else
@@ -636,6 +674,12 @@ void remmina_pref_init()
     else
         remmina_pref.shortcutkey_toolbar = GDK_KEY_t;
 
+    if( g_key_file_has_key( gkeyfile, "remmina_pref", "shortcutkey_perf_hud", NULL ) )
+        remmina_pref.shortcutkey_perf_hud =
+            g_key_file_get_integer( gkeyfile, "remmina_pref", "shortcutkey_perf_hud", NULL );
+    else
+        remmina_pref.shortcutkey_perf_hud = GDK_KEY_p;
+
     if( g_key_file_has_key( gkeyfile, "remmina_pref", "secret", NULL ) )
         remmina_pref.secret = g_key_file_get_string( gkeyfile, "remmina_pref", "secret", NULL );
     else
@@ -780,21 +824,19 @@ int remmina_pref_save()
         return FALSE;
     }
     GKeyFile *gkeyfile;
-    GError *error = NULL;
-    g_autofree char *content = NULL;
-    gsize length;
 
+    /* Only the keys set here, the rest of the file is kept when it is written */
     gkeyfile = g_key_file_new();
 
-    g_key_file_load_from_file( gkeyfile, remmina_pref_file, G_KEY_FILE_NONE, NULL );
-
     g_key_file_set_string( gkeyfile, "remmina_pref", "datadir_path", remmina_pref.datadir_path );
     g_key_file_set_string( gkeyfile, "remmina_pref", "remmina_file_name", remmina_pref.remmina_file_name );
     g_key_file_set_string( gkeyfile, "remmina_pref", "screenshot_path", remmina_pref.screenshot_path );
     g_key_file_set_string( gkeyfile, "remmina_pref", "screenshot_name", remmina_pref.screenshot_name );
+    g_key_file_set_integer( gkeyfile, "remmina_pref", "screenshot_format", remmina_pref.screenshot_format );
     g_key_file_set_boolean(
         gkeyfile, "remmina_pref", "deny_screenshot_clipboard", remmina_pref.deny_screenshot_clipboard );
     g_key_file_set_boolean( gkeyfile, "remmina_pref", "save_view_mode", remmina_pref.save_view_mode );
+    g_key_file_set_boolean( gkeyfile, "remmina_pref", "prewarm_connections", remmina_pref.prewarm_connections );
 #if SODIUM_VERSION_INT >= 90200
     g_key_file_set_boolean( gkeyfile, "remmina_pref", "use_master_password", remmina_pref.use_master_password );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "unlock_timeout", remmina_pref.unlock_timeout );
@@ -816,6 +858,7 @@ int remmina_pref_save()
     g_key_file_set_boolean( gkeyfile, "remmina_pref", "always_show_tab", remmina_pref.always_show_tab );
     g_key_file_set_boolean( gkeyfile, "remmina_pref", "hide_connection_toolbar", remmina_pref.hide_connection_toolbar );
     g_key_file_set_boolean( gkeyfile, "remmina_pref", "hide_searchbar", remmina_pref.hide_searchbar );
+    g_key_file_set_boolean( gkeyfile, "remmina_pref", "show_latency", remmina_pref.show_latency );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "default_action", remmina_pref.default_action );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "scale_quality", remmina_pref.scale_quality );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "ssh_loglevel", remmina_pref.ssh_loglevel );
@@ -837,12 +880,17 @@ int remmina_pref_save()
     g_key_file_set_integer( gkeyfile, "remmina_pref", "ssh_tcp_keepintvl", remmina_pref.ssh_tcp_keepintvl );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "ssh_tcp_keepcnt", remmina_pref.ssh_tcp_keepcnt );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "ssh_tcp_usrtimeout", remmina_pref.ssh_tcp_usrtimeout );
+    g_key_file_set_integer( gkeyfile, "remmina_pref", "ssh_pool_idle_timeout", remmina_pref.ssh_pool_idle_timeout );
+    g_key_file_set_boolean( gkeyfile, "remmina_pref", "ssh_tunnel_socketpair", remmina_pref.ssh_tunnel_socketpair );
     g_key_file_set_boolean( gkeyfile, "remmina_pref", "applet_new_ontop", remmina_pref.applet_new_ontop );
     g_key_file_set_boolean( gkeyfile, "remmina_pref", "applet_hide_count", remmina_pref.applet_hide_count );
     g_key_file_set_boolean( gkeyfile, "remmina_pref", "applet_enable_avahi", remmina_pref.applet_enable_avahi );
     g_key_file_set_boolean( gkeyfile, "remmina_pref", "disable_tray_icon", remmina_pref.disable_tray_icon );
     g_key_file_set_boolean( gkeyfile, "remmina_pref", "dark_theme", remmina_pref.dark_theme );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "recent_maximum", remmina_pref.recent_maximum );
+    g_key_file_set_integer( gkeyfile, "remmina_pref", "launcher_max_parallel", remmina_pref.launcher_max_parallel );
+    g_key_file_set_integer( gkeyfile, "remmina_pref", "log_max_lines", remmina_pref.log_max_lines );
+    g_key_file_set_boolean( gkeyfile, "remmina_pref", "metrics_endpoint", remmina_pref.metrics_endpoint );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "default_mode", remmina_pref.default_mode );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "tab_mode", remmina_pref.tab_mode );
     g_key_file_set_integer(
@@ -861,6 +909,7 @@ int remmina_pref_save()
     g_key_file_set_integer( gkeyfile, "remmina_pref", "shortcutkey_minimize", remmina_pref.shortcutkey_minimize );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "shortcutkey_disconnect", remmina_pref.shortcutkey_disconnect );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "shortcutkey_toolbar", remmina_pref.shortcutkey_toolbar );
+    g_key_file_set_integer( gkeyfile, "remmina_pref", "shortcutkey_perf_hud", remmina_pref.shortcutkey_perf_hud );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "vte_shortcutkey_copy", remmina_pref.vte_shortcutkey_copy );
     g_key_file_set_integer( gkeyfile, "remmina_pref", "vte_shortcutkey_paste", remmina_pref.vte_shortcutkey_paste );
     g_key_file_set_integer(
@@ -949,16 +998,7 @@ int remmina_pref_save()
     g_key_file_set_string( gkeyfile, "remmina", "name", "" );
     g_key_file_set_integer( gkeyfile, "remmina", "ignore-tls-errors", 1 );
 
-    content = g_key_file_to_data( gkeyfile, &length, NULL );
-    g_file_set_contents( remmina_pref_file, content, length, &error );
-
-    if( error != NULL )
-    {
-        g_warning( "remmina_pref_save error: %s", error->message );
-        g_clear_error( &error );
-        g_key_file_free( gkeyfile );
-        return FALSE;
-    }
+    remmina_persist_merge( remmina_pref_file, gkeyfile );
     g_key_file_free( gkeyfile );
     return TRUE;
 }
@@ -970,8 +1010,6 @@ void remmina_pref_add_recent( const char *protocol, const char *server )
     GKeyFile *gkeyfile;
     char key[20];
     g_autofree char *val = NULL;
-    g_autofree char *content = NULL;
-    gsize length;
 
     if( remmina_pref.recent_maximum <= 0 || server == NULL || server[0] == 0 )
         return;
@@ -979,7 +1017,7 @@ void remmina_pref_add_recent( const char *protocol, const char *server )
     /* Load original value into memory */
     gkeyfile = g_key_file_new();
 
-    g_key_file_load_from_file( gkeyfile, remmina_pref_file, G_KEY_FILE_NONE, NULL );
+    remmina_persist_load( gkeyfile, remmina_pref_file, NULL );
 
     g_snprintf( key, sizeof( key ), "recent_%s", protocol );
     array =
@@ -993,11 +1031,9 @@ void remmina_pref_add_recent( const char *protocol, const char *server )
 
     /* Save */
     val = remmina_string_array_to_string( array );
-    g_key_file_set_string( gkeyfile, "remmina_pref", key, val );
-
-    content = g_key_file_to_data( gkeyfile, &length, NULL );
-    g_file_set_contents( remmina_pref_file, content, length, NULL );
+    remmina_persist_set_string( remmina_pref_file, "remmina_pref", key, val );
 
+    remmina_string_array_free( array );
     g_key_file_free( gkeyfile );
 }
 
@@ -1010,7 +1046,7 @@ char *remmina_pref_get_recent( const char *protocol )
 
     gkeyfile = g_key_file_new();
 
-    g_key_file_load_from_file( gkeyfile, remmina_pref_file, G_KEY_FILE_NONE, NULL );
+    remmina_persist_load( gkeyfile, remmina_pref_file, NULL );
 
     g_snprintf( key, sizeof( key ), "recent_%s", protocol );
     val = g_key_file_get_string( gkeyfile, "remmina_pref", key, NULL );
@@ -1023,27 +1059,26 @@ char *remmina_pref_get_recent( const char *protocol )
 void remmina_pref_clear_recent()
 {
     TRACE_CALL( __func__ );
-    GKeyFile *gkeyfile;
+    GKeyFile *gkeyfile, *changes;
     char **keys;
     gint i;
-    g_autofree char *content = NULL;
-    gsize length;
 
     gkeyfile = g_key_file_new();
+    changes = g_key_file_new();
 
-    g_key_file_load_from_file( gkeyfile, remmina_pref_file, G_KEY_FILE_NONE, NULL );
+    remmina_persist_load( gkeyfile, remmina_pref_file, NULL );
     keys = g_key_file_get_keys( gkeyfile, "remmina_pref", NULL, NULL );
     if( keys )
     {
         for( i = 0; keys[i]; i++ )
             if( strncmp( keys[i], "recent_", 7 ) == 0 )
-                g_key_file_set_string( gkeyfile, "remmina_pref", keys[i], "" );
+                g_key_file_set_string( changes, "remmina_pref", keys[i], "" );
         g_strfreev( keys );
     }
 
-    content = g_key_file_to_data( gkeyfile, &length, NULL );
-    g_file_set_contents( remmina_pref_file, content, length, NULL );
+    remmina_persist_merge( remmina_pref_file, changes );
 
+    g_key_file_free( changes );
     g_key_file_free( gkeyfile );
 }
 
@@ -1153,18 +1188,8 @@ gint remmina_pref_get_ssh_tcp_usrtimeout()
 void remmina_pref_set_value( const char *key, const char *value )
 {
     TRACE_CALL( __func__ );
-    GKeyFile *gkeyfile;
-    char *content;
-    gsize length;
-
-    gkeyfile = g_key_file_new();
-    g_key_file_load_from_file( gkeyfile, remmina_pref_file, G_KEY_FILE_NONE, NULL );
-    g_key_file_set_string( gkeyfile, "remmina_pref", key, value );
-    content = g_key_file_to_data( gkeyfile, &length, NULL );
-    g_file_set_contents( remmina_pref_file, content, length, NULL );
 
-    g_key_file_free( gkeyfile );
-    g_free( content );
+    remmina_persist_set_string( remmina_pref_file, "remmina_pref", key, value );
 }
 
 char *remmina_pref_get_value( const char *key )
@@ -1174,7 +1199,7 @@ char *remmina_pref_get_value( const char *key )
     char *value = NULL;
 
     gkeyfile = g_key_file_new();
-    g_key_file_load_from_file( gkeyfile, remmina_pref_file, G_KEY_FILE_NONE, NULL );
+    remmina_persist_load( gkeyfile, remmina_pref_file, NULL );
     value = g_key_file_get_string( gkeyfile, "remmina_pref", key, NULL );
     g_key_file_free( gkeyfile );
 
@@ -1188,7 +1213,7 @@ int remmina_pref_get_boolean( const char *key )
     bool value;
 
     gkeyfile = g_key_file_new();
-    g_key_file_load_from_file( gkeyfile, remmina_pref_file, G_KEY_FILE_NONE, NULL );
+    remmina_persist_load( gkeyfile, remmina_pref_file, NULL );
     value = g_key_file_get_boolean( gkeyfile, "remmina_pref", key, NULL );
     g_key_file_free( gkeyfile );
 
@@ -127,11 +127,19 @@ struct RemminaPref
     const char *screenshot_path;
     bool deny_screenshot_clipboard;
     const char *screenshot_name;
+    gint screenshot_format;
     bool save_view_mode;
+    bool prewarm_connections;
     gint default_action;
     gint scale_quality;
     gint auto_scroll_step;
     gint recent_maximum;
+    /* Only settable in remmina.pref, 0 opens every queued profile at once */
+    gint launcher_max_parallel;
+    /* Only settable in remmina.pref */
+    gint log_max_lines;
+    /* Only settable in remmina.pref */
+    bool metrics_endpoint;
     char *resolutions;
     char *keystrokes;
     /* In RemminaPrefDialog appearance tab */
@@ -141,6 +149,7 @@ struct RemminaPref
     bool always_show_tab;
     bool hide_connection_toolbar;
     bool hide_searchbar;
+    bool show_latency;
     gint default_mode;
     gint tab_mode;
     gint fullscreen_toolbar_visibility;
@@ -158,6 +167,10 @@ struct RemminaPref
     gint ssh_tcp_keepintvl;
     gint ssh_tcp_keepcnt;
     gint ssh_tcp_usrtimeout;
+    /* Only settable in remmina.pref */
+    gint ssh_pool_idle_timeout;
+    /* Only settable in remmina.pref */
+    bool ssh_tunnel_socketpair;
     /* In RemminaPrefDialog keyboard tab */
     guint hostkey;
     guint shortcutkey_fullscreen;
@@ -173,6 +186,7 @@ struct RemminaPref
     guint shortcutkey_minimize;
     guint shortcutkey_disconnect;
     guint shortcutkey_toolbar;
+    guint shortcutkey_perf_hud;
     /* In RemminaPrefDialog security tab */
     bool use_master_password;
     const char *unlock_password;
@@ -235,6 +249,7 @@ struct RemminaPref
 #define SSH_SOCKET_TCP_KEEPINTVL 10
 #define SSH_SOCKET_TCP_KEEPCNT 3
 #define SSH_SOCKET_TCP_USER_TIMEOUT 60000 // 60 seconds
+#define SSH_POOL_IDLE_TIMEOUT 60 // seconds, 0 disables the SSH session pool
 
 extern const char *default_resolutions;
 extern char *remmina_pref_file;
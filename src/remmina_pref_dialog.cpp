@@ -232,6 +232,8 @@ void remmina_pref_on_dialog_destroy( GtkWidget *widget, gpointer user_data )
         gtk_switch_get_active( GTK_SWITCH( remmina_pref_dialog->switch_options_deny_screenshot_clipboard ) );
     remmina_pref.save_view_mode =
         gtk_switch_get_active( GTK_SWITCH( remmina_pref_dialog->switch_options_remember_last_view_mode ) );
+    remmina_pref.prewarm_connections =
+        gtk_switch_get_active( GTK_SWITCH( remmina_pref_dialog->switch_options_prewarm_connections ) );
     remmina_pref.use_master_password =
         gtk_switch_get_active( GTK_SWITCH( remmina_pref_dialog->switch_security_use_master_password ) );
 #if SODIUM_VERSION_INT >= 90200
@@ -251,6 +253,8 @@ void remmina_pref_on_dialog_destroy( GtkWidget *widget, gpointer user_data )
         gtk_toggle_button_get_active( GTK_TOGGLE_BUTTON( remmina_pref_dialog->checkbutton_appearance_hide_toolbar ) );
     remmina_pref.hide_searchbar =
         gtk_toggle_button_get_active( GTK_TOGGLE_BUTTON( remmina_pref_dialog->checkbutton_appearance_hide_searchbar ) );
+    remmina_pref.show_latency =
+        gtk_toggle_button_get_active( GTK_TOGGLE_BUTTON( remmina_pref_dialog->checkbutton_appearance_show_latency ) );
 
     b = gtk_switch_get_active( GTK_SWITCH( remmina_pref_dialog->switch_permit_news ) );
     remmina_pref.periodic_news_permitted = b;
@@ -261,6 +265,8 @@ void remmina_pref_on_dialog_destroy( GtkWidget *widget, gpointer user_data )
     remmina_pref.fullscreen_toolbar_visibility =
         gtk_combo_box_get_active( remmina_pref_dialog->comboboxtext_appearance_fullscreen_toolbar_visibility );
     remmina_pref.scale_quality = gtk_combo_box_get_active( remmina_pref_dialog->comboboxtext_options_scale_quality );
+    remmina_pref.screenshot_format =
+        gtk_combo_box_get_active( remmina_pref_dialog->comboboxtext_options_screenshot_format );
     remmina_pref.ssh_loglevel = gtk_combo_box_get_active( remmina_pref_dialog->comboboxtext_options_ssh_loglevel );
     remmina_pref.sshtunnel_port = atoi( gtk_entry_get_text( remmina_pref_dialog->entry_options_ssh_port ) );
     if( remmina_pref.sshtunnel_port <= 0 )
@@ -354,6 +360,8 @@ void remmina_pref_on_dialog_destroy( GtkWidget *widget, gpointer user_data )
         remmina_key_chooser_get_keyval( gtk_button_get_label( remmina_pref_dialog->button_keyboard_disconnect ) );
     remmina_pref.shortcutkey_toolbar =
         remmina_key_chooser_get_keyval( gtk_button_get_label( remmina_pref_dialog->button_keyboard_toolbar ) );
+    remmina_pref.shortcutkey_perf_hud =
+        remmina_key_chooser_get_keyval( gtk_button_get_label( remmina_pref_dialog->button_keyboard_perf_hud ) );
 
     g_free( remmina_pref.vte_font );
     if( gtk_switch_get_active( GTK_SWITCH( remmina_pref_dialog->switch_terminal_font_system ) ) )
@@ -501,6 +509,8 @@ static void remmina_pref_dialog_init()
 
     gtk_switch_set_active( GTK_SWITCH( remmina_pref_dialog->switch_options_remember_last_view_mode ),
                            remmina_pref.save_view_mode );
+    gtk_switch_set_active( GTK_SWITCH( remmina_pref_dialog->switch_options_prewarm_connections ),
+                           remmina_pref.prewarm_connections );
 #if SODIUM_VERSION_INT >= 90200
     gtk_switch_set_active( GTK_SWITCH( remmina_pref_dialog->switch_security_use_master_password ),
                            remmina_pref.use_master_password );
@@ -534,6 +544,8 @@ static void remmina_pref_dialog_init()
                                   remmina_pref.hide_connection_toolbar );
     gtk_toggle_button_set_active( GTK_TOGGLE_BUTTON( remmina_pref_dialog->checkbutton_appearance_hide_searchbar ),
                                   remmina_pref.hide_searchbar );
+    gtk_toggle_button_set_active( GTK_TOGGLE_BUTTON( remmina_pref_dialog->checkbutton_appearance_show_latency ),
+                                  remmina_pref.show_latency );
 
     gtk_switch_set_active( GTK_SWITCH( remmina_pref_dialog->switch_permit_news ),
                            remmina_pref.periodic_news_permitted );
@@ -600,6 +612,8 @@ static void remmina_pref_dialog_init()
                                           remmina_pref.shortcutkey_disconnect );
     remmina_pref_dialog_set_button_label( remmina_pref_dialog->button_keyboard_toolbar,
                                           remmina_pref.shortcutkey_toolbar );
+    remmina_pref_dialog_set_button_label( remmina_pref_dialog->button_keyboard_perf_hud,
+                                          remmina_pref.shortcutkey_perf_hud );
 
     if( !( remmina_pref.vte_font && remmina_pref.vte_font[0] ) )
         gtk_switch_set_active( GTK_SWITCH( remmina_pref_dialog->switch_terminal_font_system ), TRUE );
@@ -708,6 +722,8 @@ static void remmina_pref_dialog_init()
     gtk_combo_box_set_active( remmina_pref_dialog->comboboxtext_appearance_fullscreen_toolbar_visibility,
                               remmina_pref.fullscreen_toolbar_visibility );
     gtk_combo_box_set_active( remmina_pref_dialog->comboboxtext_options_scale_quality, remmina_pref.scale_quality );
+    gtk_combo_box_set_active( remmina_pref_dialog->comboboxtext_options_screenshot_format,
+                              remmina_pref.screenshot_format );
     gtk_combo_box_set_active( remmina_pref_dialog->comboboxtext_options_ssh_loglevel, remmina_pref.ssh_loglevel );
     if( remmina_pref.datadir_path != NULL && strlen( remmina_pref.datadir_path ) > 0 )
         gtk_file_chooser_set_filename( remmina_pref_dialog->filechooserbutton_options_datadir_path,
@@ -794,6 +810,8 @@ GtkWidget *remmina_pref_dialog_new( gint default_tab, GtkWindow *parent )
         GTK_SWITCH( GET_OBJECT( "switch_options_deny_screenshot_clipboard" ) );
     remmina_pref_dialog->switch_options_remember_last_view_mode =
         GTK_SWITCH( GET_OBJECT( "switch_options_remember_last_view_mode" ) );
+    remmina_pref_dialog->switch_options_prewarm_connections =
+        GTK_SWITCH( GET_OBJECT( "switch_options_prewarm_connections" ) );
     remmina_pref_dialog->switch_security_use_master_password =
         GTK_SWITCH( GET_OBJECT( "switch_security_use_master_password" ) );
     remmina_pref_dialog->unlock_password = GTK_ENTRY( GET_OBJECT( "unlock_password" ) );
@@ -809,6 +827,8 @@ GtkWidget *remmina_pref_dialog_new( gint default_tab, GtkWindow *parent )
         GTK_CHECK_BUTTON( GET_OBJECT( "checkbutton_appearance_hide_toolbar" ) );
     remmina_pref_dialog->checkbutton_appearance_hide_searchbar =
         GTK_CHECK_BUTTON( GET_OBJECT( "checkbutton_appearance_hide_searchbar" ) );
+    remmina_pref_dialog->checkbutton_appearance_show_latency =
+        GTK_CHECK_BUTTON( GET_OBJECT( "checkbutton_appearance_show_latency" ) );
     remmina_pref_dialog->switch_permit_news = GTK_SWITCH( GET_OBJECT( "switch_permit_news" ) );
     gtk_widget_set_sensitive( GTK_WIDGET( remmina_pref_dialog->switch_permit_news ), RMNEWS_ENABLE_NEWS );
     remmina_pref_dialog->comboboxtext_options_double_click =
@@ -821,6 +841,8 @@ GtkWidget *remmina_pref_dialog_new( gint default_tab, GtkWindow *parent )
         GTK_COMBO_BOX( GET_OBJECT( "comboboxtext_appearance_fullscreen_toolbar_visibility" ) );
     remmina_pref_dialog->comboboxtext_options_scale_quality =
         GTK_COMBO_BOX( GET_OBJECT( "comboboxtext_options_scale_quality" ) );
+    remmina_pref_dialog->comboboxtext_options_screenshot_format =
+        GTK_COMBO_BOX( GET_OBJECT( "comboboxtext_options_screenshot_format" ) );
     remmina_pref_dialog->checkbutton_options_ssh_parseconfig =
         GTK_CHECK_BUTTON( GET_OBJECT( "checkbutton_options_ssh_parseconfig" ) );
     remmina_pref_dialog->comboboxtext_options_ssh_loglevel =
@@ -864,6 +886,7 @@ GtkWidget *remmina_pref_dialog_new( gint default_tab, GtkWindow *parent )
     remmina_pref_dialog->button_keyboard_minimize = GTK_BUTTON( GET_OBJECT( "button_keyboard_minimize" ) );
     remmina_pref_dialog->button_keyboard_disconnect = GTK_BUTTON( GET_OBJECT( "button_keyboard_disconnect" ) );
     remmina_pref_dialog->button_keyboard_toolbar = GTK_BUTTON( GET_OBJECT( "button_keyboard_toolbar" ) );
+    remmina_pref_dialog->button_keyboard_perf_hud = GTK_BUTTON( GET_OBJECT( "button_keyboard_perf_hud" ) );
 
     remmina_pref_dialog->switch_terminal_font_system = GTK_SWITCH( GET_OBJECT( "switch_terminal_font_system" ) );
     remmina_pref_dialog->fontbutton_terminal_font = GTK_FONT_BUTTON( GET_OBJECT( "fontbutton_terminal_font" ) );
@@ -58,6 +58,7 @@ struct RemminaPrefDialog
     GtkSwitch *switch_appearance_grab_color;
     GtkSwitch *switch_options_deny_screenshot_clipboard;
     GtkSwitch *switch_options_remember_last_view_mode;
+    GtkSwitch *switch_options_prewarm_connections;
     GtkSwitch *switch_security_use_master_password;
     GtkEntry *unlock_timeout;
     GtkEntry *unlock_password;
@@ -68,11 +69,13 @@ struct RemminaPrefDialog
     GtkCheckButton *checkbutton_appearance_show_tabs;
     GtkCheckButton *checkbutton_appearance_hide_toolbar;
     GtkCheckButton *checkbutton_appearance_hide_searchbar;
+    GtkCheckButton *checkbutton_appearance_show_latency;
     GtkSwitch *switch_permit_news;
     GtkComboBox *comboboxtext_options_double_click;
     GtkComboBox *comboboxtext_appearance_view_mode;
     GtkComboBox *comboboxtext_appearance_tab_interface;
     GtkComboBox *comboboxtext_options_scale_quality;
+    GtkComboBox *comboboxtext_options_screenshot_format;
     GtkComboBox *comboboxtext_options_ssh_loglevel;
     GtkComboBox *comboboxtext_appearance_fullscreen_toolbar_visibility;
     GtkCheckButton *checkbutton_options_ssh_parseconfig;
@@ -106,6 +109,7 @@ struct RemminaPrefDialog
     GtkButton *button_keyboard_minimize;
     GtkButton *button_keyboard_disconnect;
     GtkButton *button_keyboard_toolbar;
+    GtkButton *button_keyboard_perf_hud;
 
     GtkSwitch *switch_terminal_font_system;
     GtkFontButton *fontbutton_terminal_font;
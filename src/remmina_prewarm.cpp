@@ -0,0 +1,358 @@
+/*
+ * Remmina - The GTK+ Remote Desktop Client
+ * Copyright (C) 2016-2022 Antenore Gatta, Giovanni Panozzo
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ *
+ *  In addition, as a special exception, the copyright holders give
+ *  permission to link the code of portions of this program with the
+ *  OpenSSL library under certain conditions as described in each
+ *  individual source file, and distribute linked combinations
+ *  including the two.
+ *  You must obey the GNU General Public License in all respects
+ *  for all of the code used other than OpenSSL. *  If you modify
+ *  file(s) with this exception, you may extend this exception to your
+ *  version of the file(s), but you are not obligated to do so. *  If you
+ *  do not wish to do so, delete this exception statement from your
+ *  version. *  If you delete this exception statement from all source
+ *  files in the program, then also delete it here.
+ *
+ */
+
+
+/* Speculative pre-warming of the profile selected in the main window.
+ *
+ * Selecting a profile starts, after a short debounce, a name lookup of the
+ * first host Remmina will dial. FreeRDP, libvncclient and the other protocol
+ * libraries open their own sockets, so for them only the resolver cache gets
+ * warmed. When the first hop is SSH (SSH and SFTP profiles, or any profile with
+ * an SSH tunnel) we also open the TCP connection, and remmina_ssh hands it to
+ * libssh with SSH_OPTIONS_FD instead of dialing again. Unused connections are
+ * closed after REMMINA_PREWARM_SOCKET_TTL seconds. */
+
+#include "config.h"
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "remmina/remmina_trace_calls.hpp"
+#include "remmina_file.hpp"
+#include "remmina_file_manager.hpp"
+#include "remmina_log.hpp"
+#include "remmina_plugin_manager.hpp"
+#include "remmina_pref.hpp"
+#include "remmina_prewarm.hpp"
+#include "remmina_public.hpp"
+
+#define REMMINA_PREWARM_DELAY 300
+#define REMMINA_PREWARM_CONNECT_TIMEOUT 5
+#define REMMINA_PREWARM_SOCKET_TTL 20
+#define REMMINA_PREWARM_MAX_SOCKETS 4
+
+struct RemminaPrewarmSocket
+{
+    char *host;
+    gint port;
+    GSocketConnection *connection;
+    gint64 expires;
+};
+
+struct RemminaPrewarmRequest
+{
+    char *host;
+    gint port;
+    gint64 start;
+};
+
+static char *prewarm_filename = NULL;
+static guint prewarm_timeout_source = 0;
+static GCancellable *prewarm_cancellable = NULL;
+
+/* Warm sockets are stolen from the plugin threads */
+static GMutex prewarm_sockets_mutex;
+static GList *prewarm_sockets = NULL;
+static guint prewarm_sweep_source = 0;
+
+static void remmina_prewarm_request_free( RemminaPrewarmRequest *req )
+{
+    TRACE_CALL( __func__ );
+    g_free( req->host );
+    g_free( req );
+}
+
+static void remmina_prewarm_socket_free( RemminaPrewarmSocket *ps )
+{
+    TRACE_CALL( __func__ );
+    g_free( ps->host );
+    if( ps->connection )
+        g_object_unref( ps->connection );
+    g_free( ps );
+}
+
+static gboolean remmina_prewarm_sweep( gpointer data )
+{
+    TRACE_CALL( __func__ );
+    gint64 now = g_get_monotonic_time();
+    GList *l, *next;
+    gboolean keep;
+
+    g_mutex_lock( &prewarm_sockets_mutex );
+    for( l = prewarm_sockets; l; l = next )
+    {
+        RemminaPrewarmSocket *ps = (RemminaPrewarmSocket *)l->data;
+        next = l->next;
+        if( ps->expires <= now )
+        {
+            REMMINA_DEBUG( "Closing unused pre-warmed connection to %s:%d", ps->host, ps->port );
+            remmina_prewarm_socket_free( ps );
+            prewarm_sockets = g_list_delete_link( prewarm_sockets, l );
+        }
+    }
+    keep = prewarm_sockets != NULL;
+    if( !keep )
+        prewarm_sweep_source = 0;
+    g_mutex_unlock( &prewarm_sockets_mutex );
+
+    return keep ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+static void remmina_prewarm_store_socket( const char *host, gint port, GSocketConnection *connection )
+{
+    TRACE_CALL( __func__ );
+    RemminaPrewarmSocket *ps;
+    GList *l;
+
+    g_mutex_lock( &prewarm_sockets_mutex );
+
+    /* One warm socket per destination is enough, refresh the existing one */
+    for( l = prewarm_sockets; l; l = l->next )
+    {
+        ps = (RemminaPrewarmSocket *)l->data;
+        if( ps->port == port && g_strcmp0( ps->host, host ) == 0 )
+        {
+            remmina_prewarm_socket_free( ps );
+            prewarm_sockets = g_list_delete_link( prewarm_sockets, l );
+            break;
+        }
+    }
+    if( g_list_length( prewarm_sockets ) >= REMMINA_PREWARM_MAX_SOCKETS )
+    {
+        l = g_list_last( prewarm_sockets );
+        remmina_prewarm_socket_free( (RemminaPrewarmSocket *)l->data );
+        prewarm_sockets = g_list_delete_link( prewarm_sockets, l );
+    }
+
+    ps = g_new0( RemminaPrewarmSocket, 1 );
+    ps->host = g_strdup( host );
+    ps->port = port;
+    ps->connection = (GSocketConnection *)g_object_ref( connection );
+    ps->expires = g_get_monotonic_time() + REMMINA_PREWARM_SOCKET_TTL * G_USEC_PER_SEC;
+    prewarm_sockets = g_list_prepend( prewarm_sockets, ps );
+
+    if( !prewarm_sweep_source )
+        prewarm_sweep_source = g_timeout_add_seconds( REMMINA_PREWARM_SOCKET_TTL, remmina_prewarm_sweep, NULL );
+
+    g_mutex_unlock( &prewarm_sockets_mutex );
+}
+
+int remmina_prewarm_take_socket( const char *host, gint port )
+{
+    TRACE_CALL( __func__ );
+    RemminaPrewarmSocket *ps = NULL;
+    gint64 now = g_get_monotonic_time();
+    GList *l;
+    int fd = -1;
+
+    if( !host )
+        return -1;
+
+    g_mutex_lock( &prewarm_sockets_mutex );
+    for( l = prewarm_sockets; l; l = l->next )
+    {
+        ps = (RemminaPrewarmSocket *)l->data;
+        if( ps->port == port && g_strcmp0( ps->host, host ) == 0 )
+        {
+            prewarm_sockets = g_list_delete_link( prewarm_sockets, l );
+            break;
+        }
+        ps = NULL;
+    }
+    g_mutex_unlock( &prewarm_sockets_mutex );
+
+    if( !ps )
+        return -1;
+
+    /* A socket the peer already closed is worse than a fresh connect */
+    if( ps->expires > now && g_socket_is_connected( g_socket_connection_get_socket( ps->connection ) )
+        && !( g_socket_condition_check( g_socket_connection_get_socket( ps->connection ), G_IO_HUP | G_IO_ERR ) ) )
+    {
+        fd = dup( g_socket_get_fd( g_socket_connection_get_socket( ps->connection ) ) );
+        if( fd >= 0 )
+        {
+            /* GSocket made it non blocking, give it back as a plain socket */
+            fcntl( fd, F_SETFL, fcntl( fd, F_GETFL ) & ~O_NONBLOCK );
+            REMMINA_DEBUG( "Reusing pre-warmed connection to %s:%d", host, port );
+        }
+    }
+    remmina_prewarm_socket_free( ps );
+    return fd;
+}
+
+static void remmina_prewarm_connect_cb( GObject *source, GAsyncResult *res, gpointer data )
+{
+    TRACE_CALL( __func__ );
+    RemminaPrewarmRequest *req = (RemminaPrewarmRequest *)data;
+    GSocketConnection *connection;
+    GError *err = NULL;
+
+    connection = g_socket_client_connect_to_host_finish( G_SOCKET_CLIENT( source ), res, &err );
+    if( connection )
+    {
+        REMMINA_DEBUG( "Pre-warmed connection to %s:%d in %" G_GINT64_FORMAT " ms",
+                       req->host,
+                       req->port,
+                       ( g_get_monotonic_time() - req->start ) / 1000 );
+        remmina_prewarm_store_socket( req->host, req->port, connection );
+        g_object_unref( connection );
+    }
+    else
+    {
+        if( !g_error_matches( err, G_IO_ERROR, G_IO_ERROR_CANCELLED ) )
+            REMMINA_DEBUG( "Pre-warm of %s:%d failed: %s", req->host, req->port, err->message );
+        g_error_free( err );
+    }
+    remmina_prewarm_request_free( req );
+}
+
+static void remmina_prewarm_lookup_cb( GObject *source, GAsyncResult *res, gpointer data )
+{
+    TRACE_CALL( __func__ );
+    RemminaPrewarmRequest *req = (RemminaPrewarmRequest *)data;
+    GList *addresses;
+    GError *err = NULL;
+
+    addresses = g_resolver_lookup_by_name_finish( G_RESOLVER( source ), res, &err );
+    if( addresses )
+    {
+        REMMINA_DEBUG( "Pre-warmed name lookup of %s in %" G_GINT64_FORMAT " ms",
+                       req->host,
+                       ( g_get_monotonic_time() - req->start ) / 1000 );
+        g_resolver_free_addresses( addresses );
+    }
+    else
+        g_error_free( err );
+    remmina_prewarm_request_free( req );
+}
+
+static gboolean remmina_prewarm_start( gpointer data )
+{
+    TRACE_CALL( __func__ );
+    RemminaFile *remminafile;
+    RemminaPrewarmRequest *req;
+    const char *protocol;
+    const char *server;
+    const char *tunnel_server;
+    char *host = NULL;
+    gint port = 0;
+    bool ssh_hop;
+
+    prewarm_timeout_source = 0;
+    remminafile = remmina_file_manager_load_file( prewarm_filename );
+    if( !remminafile )
+        return G_SOURCE_REMOVE;
+
+    protocol = remmina_file_get_string( remminafile, "protocol" );
+    if( !protocol || !remmina_plugin_manager_get_plugin( REMMINA_PLUGIN_TYPE_PROTOCOL, protocol ) )
+    {
+        remmina_file_free( remminafile );
+        return G_SOURCE_REMOVE;
+    }
+
+    /* Same host selection as remmina_ssh_init_from_file() */
+    server = remmina_file_get_string( remminafile, "server" );
+    if( remmina_file_get_int( remminafile, "ssh_tunnel_enabled", FALSE ) )
+    {
+        ssh_hop = TRUE;
+        tunnel_server = remmina_file_get_string( remminafile, "ssh_tunnel_server" );
+        if( tunnel_server && tunnel_server[0] )
+            remmina_public_get_server_port( tunnel_server, 22, &host, &port );
+        else if( server && server[0] )
+        {
+            remmina_public_get_server_port( server, 22, &host, &port );
+            port = 22;
+        }
+    }
+    else
+    {
+        ssh_hop = g_strcmp0( protocol, "SSH" ) == 0 || g_strcmp0( protocol, "SFTP" ) == 0;
+        if( server && server[0] && server[0] != '/' && !g_str_has_prefix( server, "unix:" ) )
+            remmina_public_get_server_port( server, ssh_hop ? 22 : 0, &host, &port );
+    }
+    remmina_file_free( remminafile );
+
+    if( !host || host[0] == 0 )
+    {
+        g_free( host );
+        return G_SOURCE_REMOVE;
+    }
+
+    req = g_new0( RemminaPrewarmRequest, 1 );
+    req->host = host;
+    req->port = port;
+    req->start = g_get_monotonic_time();
+
+    if( ssh_hop )
+    {
+        GSocketClient *client = g_socket_client_new();
+        g_socket_client_set_timeout( client, REMMINA_PREWARM_CONNECT_TIMEOUT );
+        g_socket_client_connect_to_host_async(
+            client, req->host, req->port, prewarm_cancellable, remmina_prewarm_connect_cb, req );
+        g_object_unref( client );
+    }
+    else
+    {
+        GResolver *resolver = g_resolver_get_default();
+        g_resolver_lookup_by_name_async(
+            resolver, req->host, prewarm_cancellable, remmina_prewarm_lookup_cb, req );
+        g_object_unref( resolver );
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+void remmina_prewarm_profile( const char *filename )
+{
+    TRACE_CALL( __func__ );
+
+    if( !remmina_pref.prewarm_connections || !filename )
+        return;
+    if( g_strcmp0( filename, prewarm_filename ) == 0 && prewarm_timeout_source )
+        return;
+
+    /* Only the last selection is worth warming up */
+    if( prewarm_timeout_source )
+        g_source_remove( prewarm_timeout_source );
+    if( prewarm_cancellable )
+    {
+        g_cancellable_cancel( prewarm_cancellable );
+        g_object_unref( prewarm_cancellable );
+    }
+    prewarm_cancellable = g_cancellable_new();
+
+    g_free( prewarm_filename );
+    prewarm_filename = g_strdup( filename );
+    prewarm_timeout_source = g_timeout_add( REMMINA_PREWARM_DELAY, remmina_prewarm_start, NULL );
+}
@@ -41,6 +41,7 @@
 #include <glib/gi18n.h>
 #include <gmodule.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "remmina_chat_window.hpp"
 #include "remmina_masterthread_exec.hpp"
@@ -78,6 +79,8 @@ struct RemminaProtocolWidgetPriv
     GtkWidget *chat_window;
 
     bool closed;
+    /* The widget is not shown to the user (background tab or minimized window) */
+    bool hidden;
 
     RemminaHostkeyFunc hostkey_func;
 
@@ -99,6 +102,18 @@ struct RemminaProtocolWidgetPriv
     char *cacrl;
     char *clientcert;
     char *clientkey;
+
+    /* Performance overlay counters, written by plugin threads */
+    GMutex perf_mutex;
+    gint perf_enabled;
+    gint64 perf_period_start;
+    gint64 perf_input_pending;
+    RemminaPerfStats perf;
+    RemminaPerfTotals perf_totals;
+
+    gint64 connected_time;
+    /* Stable identifier for the metrics endpoint */
+    guint id;
 };
 
 enum panel_type
@@ -129,6 +144,11 @@ struct RemminaProtocolWidgetSignalData
 
 static guint remmina_protocol_widget_signals[LAST_SIGNAL] = { 0 };
 
+static GList *protocol_widgets = NULL;
+static guint protocol_widgets_last_id = 0;
+/* Set by the metrics endpoint, totals cost a mutex per counter update */
+static gint perf_totals_enabled = 0;
+
 static void remmina_protocol_widget_class_init( RemminaProtocolWidgetClass *klass )
 {
     TRACE_CALL( __func__ );
@@ -217,6 +237,8 @@ static void remmina_protocol_widget_destroy( RemminaProtocolWidget *gp, gpointer
 {
     TRACE_CALL( __func__ );
 
+    protocol_widgets = g_list_remove( protocol_widgets, gp );
+
     g_free( gp->priv->username );
     gp->priv->username = NULL;
 
@@ -247,6 +269,8 @@ static void remmina_protocol_widget_destroy( RemminaProtocolWidget *gp, gpointer
     g_free( gp->priv->remmina_file );
     gp->priv->remmina_file = NULL;
 
+    g_mutex_clear( &gp->priv->perf_mutex );
+
     g_free( gp->priv );
     gp->priv = NULL;
 
@@ -282,6 +306,9 @@ static void remmina_protocol_widget_init( RemminaProtocolWidget *gp )
     gp->priv = priv;
     gp->priv->closed = TRUE;
     gp->priv->ssh_tunnels = g_ptr_array_new();
+    g_mutex_init( &gp->priv->perf_mutex );
+    gp->priv->id = ++protocol_widgets_last_id;
+    protocol_widgets = g_list_prepend( protocol_widgets, gp );
 
     g_signal_connect( G_OBJECT( gp ), "destroy", G_CALLBACK( remmina_protocol_widget_destroy ), NULL );
 }
@@ -425,6 +452,7 @@ static int conn_opened( gpointer data )
             remmina_ssh_tunnel_cancel_accept( (RemminaSSHTunnel *)gp->priv->ssh_tunnels->pdata[i] );
     }
 #endif
+    gp->priv->connected_time = g_get_monotonic_time();
     if( gp->priv->listen_message_panel )
     {
         rco_destroy_message_panel( gp->cnnobj, gp->priv->listen_message_panel );
@@ -436,6 +464,14 @@ static int conn_opened( gpointer data )
         gp->priv->connect_message_panel = NULL;
     }
     g_signal_emit_by_name( G_OBJECT( gp ), "connect" );
+
+    /* Plugins ignore visibility changes until the connection is up,
+     * so a tab hidden while connecting is paused only now */
+    if( gp->priv->hidden && gp->priv->plugin && !gp->priv->closed )
+    {
+        REMMINA_DEBUG( "Protocol widget %p connected while hidden", gp );
+        remmina_protocol_widget_unmap_event( gp );
+    }
     return G_SOURCE_REMOVE;
 }
 
@@ -789,7 +825,7 @@ int remmina_protocol_widget_map_event( RemminaProtocolWidget *gp )
 int remmina_protocol_widget_unmap_event( RemminaProtocolWidget *gp )
 {
     TRACE_CALL( __func__ );
-    if( !gp->priv->plugin->get_plugin_screenshot )
+    if( !gp->priv->plugin->unmap_event )
     {
         REMMINA_DEBUG( "Unmap plugin function not implemented" );
         return FALSE;
@@ -799,6 +835,185 @@ int remmina_protocol_widget_unmap_event( RemminaProtocolWidget *gp )
     return gp->priv->plugin->unmap_event( gp );
 }
 
+void remmina_protocol_widget_set_visible( RemminaProtocolWidget *gp, bool visible )
+{
+    TRACE_CALL( __func__ );
+    /* Plugins are notified only on actual changes, so they can throttle
+     * background connections and catch up with a single full refresh */
+    if( gp->priv->hidden == !visible )
+        return;
+    gp->priv->hidden = !visible;
+
+    if( !gp->priv->plugin || gp->priv->closed )
+        return;
+
+    REMMINA_DEBUG( "Protocol widget %p is now %s", gp, visible ? "visible" : "hidden" );
+    if( visible )
+        remmina_protocol_widget_map_event( gp );
+    else
+        remmina_protocol_widget_unmap_event( gp );
+}
+
+int remmina_protocol_widget_is_visible( RemminaProtocolWidget *gp )
+{
+    TRACE_CALL( __func__ );
+    return !gp->priv->hidden;
+}
+
+void remmina_protocol_widget_perf_add( RemminaProtocolWidget *gp, RemminaPerfCounter counter, gint64 value )
+{
+    TRACE_CALL( __func__ );
+    RemminaProtocolWidgetPriv *priv = gp->priv;
+    RemminaPerfStats *perf = &priv->perf;
+    RemminaPerfTotals *totals = &priv->perf_totals;
+    gint64 now;
+
+    /* Called for every frame and input event, keep it cheap when nobody is looking */
+    if( !g_atomic_int_get( &perf_totals_enabled ) && !g_atomic_int_get( &priv->perf_enabled ) )
+        return;
+
+    g_mutex_lock( &priv->perf_mutex );
+    switch( counter )
+    {
+        case REMMINA_PERF_FRAME_RECEIVED:
+            perf->frames_received++;
+            totals->frames_received++;
+            /* The first update after an input event closes the latency sample */
+            if( priv->perf_input_pending )
+            {
+                now = g_get_monotonic_time() - priv->perf_input_pending;
+                perf->latency_us += now;
+                perf->latency_max_us = MAX( perf->latency_max_us, now );
+                perf->latency_samples++;
+                priv->perf_input_pending = 0;
+            }
+            break;
+        case REMMINA_PERF_FRAME_PRESENTED:
+            perf->frames_presented++;
+            totals->frames_presented++;
+            break;
+        case REMMINA_PERF_DECODE_US:
+            perf->decode_us += value;
+            perf->decode_samples++;
+            break;
+        case REMMINA_PERF_CONVERT_US:
+            perf->convert_us += value;
+            perf->convert_samples++;
+            break;
+        case REMMINA_PERF_DAMAGE_PIXELS:
+            perf->damage_pixels += value;
+            totals->damage_pixels += value;
+            break;
+        case REMMINA_PERF_INPUT_SENT:
+            perf->input_sent += MAX( value, 1 );
+            if( !priv->perf_input_pending )
+                priv->perf_input_pending = g_get_monotonic_time();
+            break;
+        case REMMINA_PERF_BYTES_IN:
+            perf->bytes_in += value;
+            totals->bytes_in += value;
+            break;
+        case REMMINA_PERF_BYTES_OUT:
+            perf->bytes_out += value;
+            totals->bytes_out += value;
+            break;
+        case REMMINA_PERF_QUEUE_DEPTH:
+            perf->queue_depth = value;
+            perf->queue_depth_max = MAX( perf->queue_depth_max, value );
+            break;
+        case REMMINA_PERF_RECONNECT:
+            totals->reconnects++;
+            break;
+        case REMMINA_PERF_INPUT_COALESCED:
+            perf->input_coalesced += value;
+            break;
+    }
+    g_mutex_unlock( &priv->perf_mutex );
+}
+
+void remmina_protocol_widget_perf_enable( RemminaProtocolWidget *gp, bool enable )
+{
+    TRACE_CALL( __func__ );
+    RemminaProtocolWidgetPriv *priv = gp->priv;
+
+    g_mutex_lock( &priv->perf_mutex );
+    memset( &priv->perf, 0, sizeof( priv->perf ) );
+    priv->perf_period_start = g_get_monotonic_time();
+    priv->perf_input_pending = 0;
+    g_mutex_unlock( &priv->perf_mutex );
+    g_atomic_int_set( &priv->perf_enabled, enable ? 1 : 0 );
+}
+
+bool remmina_protocol_widget_perf_enabled( RemminaProtocolWidget *gp )
+{
+    TRACE_CALL( __func__ );
+    return g_atomic_int_get( &perf_totals_enabled ) || g_atomic_int_get( &gp->priv->perf_enabled );
+}
+
+void remmina_protocol_widget_perf_take( RemminaProtocolWidget *gp, RemminaPerfStats *stats )
+{
+    TRACE_CALL( __func__ );
+    RemminaProtocolWidgetPriv *priv = gp->priv;
+    gint64 now = g_get_monotonic_time();
+    gint64 queue_depth;
+
+    g_mutex_lock( &priv->perf_mutex );
+    *stats = priv->perf;
+    stats->period_us = now - priv->perf_period_start;
+    /* The queue depth is a level, not a rate: carry it over to the next period */
+    queue_depth = priv->perf.queue_depth;
+    memset( &priv->perf, 0, sizeof( priv->perf ) );
+    priv->perf.queue_depth = queue_depth;
+    priv->perf.queue_depth_max = queue_depth;
+    priv->perf_period_start = now;
+    g_mutex_unlock( &priv->perf_mutex );
+}
+
+void remmina_protocol_widget_perf_enable_totals( bool enable )
+{
+    TRACE_CALL( __func__ );
+    g_atomic_int_set( &perf_totals_enabled, enable ? 1 : 0 );
+}
+
+void remmina_protocol_widget_perf_get_totals( RemminaProtocolWidget *gp, RemminaPerfTotals *totals )
+{
+    TRACE_CALL( __func__ );
+    g_mutex_lock( &gp->priv->perf_mutex );
+    *totals = gp->priv->perf_totals;
+    g_mutex_unlock( &gp->priv->perf_mutex );
+}
+
+GList *remmina_protocol_widget_get_all()
+{
+    TRACE_CALL( __func__ );
+    return protocol_widgets;
+}
+
+guint remmina_protocol_widget_get_id( RemminaProtocolWidget *gp )
+{
+    TRACE_CALL( __func__ );
+    return gp->priv->id;
+}
+
+gint64 remmina_protocol_widget_get_connected_time( RemminaProtocolWidget *gp )
+{
+    TRACE_CALL( __func__ );
+    return gp->priv->closed ? 0 : gp->priv->connected_time;
+}
+
+gint remmina_protocol_widget_get_ssh_channels( RemminaProtocolWidget *gp )
+{
+    TRACE_CALL( __func__ );
+    gint n = 0;
+
+#ifdef HAVE_LIBSSH
+    /* Read without locking the tunnel threads, a stale value is fine for monitoring */
+    for( guint i = 0; gp->priv->ssh_tunnels && i < gp->priv->ssh_tunnels->len; i++ )
+        n += ( (RemminaSSHTunnel *)gp->priv->ssh_tunnels->pdata[i] )->num_channels;
+#endif
+    return n;
+}
+
 void remmina_protocol_widget_emit_signal( RemminaProtocolWidget *gp, const char *signal_name )
 {
     TRACE_CALL( __func__ );
@@ -982,18 +1197,28 @@ static void cancel_init_tunnel_cb( void *cbdata, int btn )
     printf( "Remmina: Cancelling an opening tunnel is not implemented\n" );
 }
 
-static RemminaSSHTunnel *remmina_protocol_widget_init_tunnel( RemminaProtocolWidget *gp )
+/* When shared is set, the tunnel may borrow an already authenticated session to the same SSH server */
+static RemminaSSHTunnel *remmina_protocol_widget_init_tunnel( RemminaProtocolWidget *gp, bool shared )
 {
     TRACE_CALL( __func__ );
     RemminaSSHTunnel *tunnel;
     gint ret;
     char *msg;
+    char *key = NULL;
     RemminaMessagePanel *mp;
     bool partial = FALSE;
     bool cont = FALSE;
 
     tunnel = remmina_ssh_tunnel_new_from_file( gp->priv->remmina_file );
 
+    if( shared )
+        key = remmina_ssh_pool_key( REMMINA_SSH( tunnel ) );
+    if( remmina_ssh_pool_attach( tunnel, key ) )
+    {
+        g_free( key );
+        return tunnel;
+    }
+
     REMMINA_DEBUG( "Creating SSH tunnel to “%s” via SSH…", REMMINA_SSH( tunnel )->server );
     // TRANSLATORS: “%s” is a placeholder for an hostname or an IP address.
     msg = g_strdup_printf( _( "Connecting to “%s” via SSH…" ), REMMINA_SSH( tunnel )->server );
@@ -1078,9 +1303,12 @@ static RemminaSSHTunnel *remmina_protocol_widget_init_tunnel( RemminaProtocolWid
 BREAK:
     if( !cont )
     {
+        g_free( key );
         remmina_ssh_tunnel_free( tunnel );
         return NULL;
     }
+    remmina_ssh_pool_add( tunnel, key );
+    g_free( key );
     remmina_protocol_widget_mpdestroy( gp->cnnobj, mp );
 
     return tunnel;
@@ -1133,7 +1361,10 @@ static int remmina_protocol_widget_tunnel_destroy( RemminaSSHTunnel *tunnel, gpo
  * Start an SSH tunnel if possible and return the host:port string.
  *
  */
-char *remmina_protocol_widget_start_direct_tunnel( RemminaProtocolWidget *gp, gint default_port, bool port_plus )
+/* When sock is not NULL, the tunnel hands one end of a socket pair over in *sock instead of
+ * listening on remmina_pref.sshtunnel_port, and "|<fd>" is returned */
+static char *
+remmina_protocol_widget_open_direct_tunnel( RemminaProtocolWidget *gp, gint default_port, bool port_plus, gint *sock )
 {
     TRACE_CALL( __func__ );
     const char *server;
@@ -1178,7 +1409,7 @@ char *remmina_protocol_widget_start_direct_tunnel( RemminaProtocolWidget *gp, gi
         return dest;
     }
 
-    tunnel = remmina_protocol_widget_init_tunnel( gp );
+    tunnel = remmina_protocol_widget_init_tunnel( gp, TRUE );
     if( !tunnel )
     {
         g_free( srv_host );
@@ -1202,7 +1433,8 @@ char *remmina_protocol_widget_start_direct_tunnel( RemminaProtocolWidget *gp, gi
     }
 
     REMMINA_DEBUG( "Starting tunnel to: %s, port: %d", ssh_tunnel_host, ssh_tunnel_port );
-    if( !remmina_ssh_tunnel_open( tunnel, srv_host, srv_port, remmina_pref.sshtunnel_port ) )
+    if( sock ? !remmina_ssh_tunnel_open_socket( tunnel, srv_host, srv_port, sock )
+             : !remmina_ssh_tunnel_open( tunnel, srv_host, srv_port, remmina_pref.sshtunnel_port ) )
     {
         g_free( srv_host );
         g_free( ssh_tunnel_host );
@@ -1220,6 +1452,8 @@ char *remmina_protocol_widget_start_direct_tunnel( RemminaProtocolWidget *gp, gi
 
     g_ptr_array_add( gp->priv->ssh_tunnels, tunnel );
 
+    if( sock )
+        return g_strdup_printf( "|%d", *sock );
     return g_strdup_printf( "127.0.0.1:%i", remmina_pref.sshtunnel_port );
 
 #else
@@ -1232,6 +1466,40 @@ char *remmina_protocol_widget_start_direct_tunnel( RemminaProtocolWidget *gp, gi
 #endif
 }
 
+char *remmina_protocol_widget_start_direct_tunnel( RemminaProtocolWidget *gp, gint default_port, bool port_plus )
+{
+    TRACE_CALL( __func__ );
+    return remmina_protocol_widget_open_direct_tunnel( gp, default_port, port_plus, NULL );
+}
+
+bool remmina_protocol_widget_start_direct_tunnel_socket( RemminaProtocolWidget *gp,
+                                                         gint default_port,
+                                                         bool port_plus,
+                                                         gint *sock )
+{
+    TRACE_CALL( __func__ );
+#ifdef HAVE_LIBSSH
+    const char *server;
+    char *dest;
+
+    *sock = -1;
+    server = remmina_file_get_string( gp->priv->remmina_file, "server" );
+    if( !remmina_pref.ssh_tunnel_socketpair || !server || strstr( server, "unix:///" ) != NULL
+        || !remmina_file_get_int( gp->priv->remmina_file, "ssh_tunnel_enabled", FALSE ) )
+        return TRUE;
+
+    dest = remmina_protocol_widget_open_direct_tunnel( gp, default_port, port_plus, sock );
+    if( !dest )
+        return FALSE;
+    REMMINA_DEBUG( "SSH tunnel handed over socket %s", dest );
+    g_free( dest );
+    return TRUE;
+#else
+    *sock = -1;
+    return TRUE;
+#endif
+}
+
 #ifdef HAVE_LIBSSH
 static void cancel_start_reverse_tunnel_cb( void *cbdata, int btn )
 {
@@ -1250,7 +1518,7 @@ int remmina_protocol_widget_start_reverse_tunnel( RemminaProtocolWidget *gp, gin
     if( !remmina_file_get_int( gp->priv->remmina_file, "ssh_tunnel_enabled", FALSE ) )
         return TRUE;
 
-    if( !( tunnel = remmina_protocol_widget_init_tunnel( gp ) ) )
+    if( !( tunnel = remmina_protocol_widget_init_tunnel( gp, FALSE ) ) )
         return FALSE;
 
     // TRANSLATORS: “%i” is a placeholder for a TCP port number.
@@ -1282,6 +1550,7 @@ int remmina_protocol_widget_ssh_exec( RemminaProtocolWidget *gp, bool wait, cons
     gint status;
     bool ret = FALSE;
     char *cmd, *ptr;
+    char discard[1024];
     va_list args;
 
     if( gp->priv->ssh_tunnels->len < 1 )
@@ -1289,8 +1558,12 @@ int remmina_protocol_widget_ssh_exec( RemminaProtocolWidget *gp, bool wait, cons
 
     tunnel = (RemminaSSHTunnel *)gp->priv->ssh_tunnels->pdata[0];
 
+    remmina_ssh_tunnel_lock( tunnel );
     if( ( channel = ssh_channel_new( REMMINA_SSH( tunnel )->session ) ) == NULL )
+    {
+        remmina_ssh_tunnel_unlock( tunnel );
         return FALSE;
+    }
 
     va_start( args, fmt );
     cmd = g_strdup_vprintf( fmt, args );
@@ -1301,6 +1574,17 @@ int remmina_protocol_widget_ssh_exec( RemminaProtocolWidget *gp, bool wait, cons
         if( wait )
         {
             ssh_channel_send_eof( channel );
+            /* The tunnel threads share the session, so it is only held while polling.
+             * The exit status arrives before the server closes the channel. */
+            while( !ssh_channel_is_closed( channel ) && ssh_is_connected( REMMINA_SSH( tunnel )->session ) )
+            {
+                while( ssh_channel_read_nonblocking( channel, discard, sizeof( discard ), 0 ) > 0 ||
+                       ssh_channel_read_nonblocking( channel, discard, sizeof( discard ), 1 ) > 0 )
+                    ;
+                remmina_ssh_tunnel_unlock( tunnel );
+                g_usleep( 20000 );
+                remmina_ssh_tunnel_lock( tunnel );
+            }
             status = ssh_channel_get_exit_status( channel );
             ptr = strchr( cmd, ' ' );
             if( ptr )
@@ -1339,6 +1623,7 @@ int remmina_protocol_widget_ssh_exec( RemminaProtocolWidget *gp, bool wait, cons
     if( wait )
         ssh_channel_close( channel );
     ssh_channel_free( channel );
+    remmina_ssh_tunnel_unlock( tunnel );
     return ret;
 
 #else
@@ -1400,7 +1685,7 @@ int remmina_protocol_widget_start_xport_tunnel( RemminaProtocolWidget *gp, Remmi
     RemminaMessagePanel *mp;
     RemminaSSHTunnel *tunnel;
 
-    if( !( tunnel = remmina_protocol_widget_init_tunnel( gp ) ) )
+    if( !( tunnel = remmina_protocol_widget_init_tunnel( gp, FALSE ) ) )
         return FALSE;
 
     // TRANSLATORS: “%s” is a placeholder for a hostname or IP address.
@@ -2121,10 +2406,10 @@ void remmina_protocol_widget_panel_show_listen( RemminaProtocolWidget *gp, gint
         RemminaMTExecData *d;
         d = (RemminaMTExecData *)g_malloc( sizeof( RemminaMTExecData ) );
         d->func = RemminaMTExecData::FUNC_PROTOCOLWIDGET_PANELSHOWLISTEN;
-        d->p.protocolwidget_panelshowlisten.gp = gp;
+        d->p.protocolwidget_panelshowlisten.gp = (RemminaProtocolWidget *)g_object_ref( gp );
         d->p.protocolwidget_panelshowlisten.port = port;
-        remmina_masterthread_exec_and_wait( d );
-        g_free( d );
+        /* Nothing to return, the plugin thread can go on listening */
+        remmina_masterthread_exec_post( d );
         return;
     }
 
@@ -2151,9 +2436,8 @@ void remmina_protocol_widget_panel_show_retry( RemminaProtocolWidget *gp )
         RemminaMTExecData *d;
         d = (RemminaMTExecData *)g_malloc( sizeof( RemminaMTExecData ) );
         d->func = RemminaMTExecData::FUNC_PROTOCOLWIDGET_MPSHOWRETRY;
-        d->p.protocolwidget_mpshowretry.gp = gp;
-        remmina_masterthread_exec_and_wait( d );
-        g_free( d );
+        d->p.protocolwidget_mpshowretry.gp = (RemminaProtocolWidget *)g_object_ref( gp );
+        remmina_masterthread_exec_post( d );
         return;
     }
 
@@ -2224,10 +2508,9 @@ void remmina_protocol_widget_chat_receive( RemminaProtocolWidget *gp, const char
             RemminaMTExecData *d;
             d = (RemminaMTExecData *)g_malloc( sizeof( RemminaMTExecData ) );
             d->func = RemminaMTExecData::FUNC_CHAT_RECEIVE;
-            d->p.chat_receive.gp = gp;
-            d->p.chat_receive.text = text;
-            remmina_masterthread_exec_and_wait( d );
-            g_free( d );
+            d->p.chat_receive.gp = (RemminaProtocolWidget *)g_object_ref( gp );
+            d->p.chat_receive.text = g_strdup( text );
+            remmina_masterthread_exec_post( d );
             return;
         }
         remmina_chat_window_receive( REMMINA_CHAT_WINDOW( gp->priv->chat_window ), _( "Server" ), text );
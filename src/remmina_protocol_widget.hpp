@@ -138,6 +138,16 @@ int remmina_protocol_widget_ssh_exec( RemminaProtocolWidget *gp, bool wait, cons
  */
 char *remmina_protocol_widget_start_direct_tunnel( RemminaProtocolWidget *gp, gint default_port, bool port_plus );
 
+/* When the ssh_tunnel_socketpair preference is set and the SSH tunnel is enabled, start it and
+ * return the local end of a connected socket pair in *sock, owned by the caller.
+ * Otherwise *sock is -1 and remmina_protocol_widget_start_direct_tunnel() must be used.
+ * Returns FALSE when the tunnel could not be started.
+ */
+bool remmina_protocol_widget_start_direct_tunnel_socket( RemminaProtocolWidget *gp,
+                                                         gint default_port,
+                                                         bool port_plus,
+                                                         gint *sock );
+
 int remmina_protocol_widget_start_reverse_tunnel( RemminaProtocolWidget *gp, gint local_port );
 int remmina_protocol_widget_start_xport_tunnel( RemminaProtocolWidget *gp, RemminaXPortTunnelInitFunc init_func );
 void remmina_protocol_widget_set_display( RemminaProtocolWidget *gp, gint display );
@@ -205,6 +215,61 @@ int remmina_protocol_widget_plugin_screenshot( RemminaProtocolWidget *gp, Remmin
 /* Deal with the remimna connection window map/unmap events */
 int remmina_protocol_widget_map_event( RemminaProtocolWidget *gp );
 int remmina_protocol_widget_unmap_event( RemminaProtocolWidget *gp );
+void remmina_protocol_widget_set_visible( RemminaProtocolWidget *gp, bool visible );
+int remmina_protocol_widget_is_visible( RemminaProtocolWidget *gp );
+
+/* Performance counters for the connection window overlay. Plugins may feed them from
+ * any thread, they are only accumulated while the overlay is enabled */
+struct RemminaPerfStats
+{
+    gint64 period_us;
+    guint frames_received;
+    guint frames_presented;
+    gint64 decode_us;
+    guint decode_samples;
+    gint64 convert_us;
+    guint convert_samples;
+    gint64 damage_pixels;
+    gint64 latency_us;
+    gint64 latency_max_us;
+    guint latency_samples;
+    gint64 bytes_in;
+    gint64 bytes_out;
+    gint64 queue_depth;
+    gint64 queue_depth_max;
+    guint input_sent;
+    guint input_coalesced;
+};
+
+/* Running totals since the widget was created, kept for every widget
+ * once remmina_protocol_widget_perf_enable_totals() has been called */
+struct RemminaPerfTotals
+{
+    guint64 frames_received;
+    guint64 frames_presented;
+    guint64 damage_pixels;
+    guint64 bytes_in;
+    guint64 bytes_out;
+    guint reconnects;
+};
+
+void remmina_protocol_widget_perf_add( RemminaProtocolWidget *gp, RemminaPerfCounter counter, gint64 value );
+void remmina_protocol_widget_perf_enable( RemminaProtocolWidget *gp, bool enable );
+/* Whether counters are being collected, by the overlay or by the metrics exporter.
+ * Plugins check it before reading counters that are costly or reset on read */
+bool remmina_protocol_widget_perf_enabled( RemminaProtocolWidget *gp );
+/* Copy the counters accumulated since the previous call and start a new period */
+void remmina_protocol_widget_perf_take( RemminaProtocolWidget *gp, RemminaPerfStats *stats );
+void remmina_protocol_widget_perf_enable_totals( bool enable );
+void remmina_protocol_widget_perf_get_totals( RemminaProtocolWidget *gp, RemminaPerfTotals *totals );
+
+/* All the protocol widgets alive, owned by the protocol widget module. Main thread only */
+GList *remmina_protocol_widget_get_all();
+/* Number that identifies the widget during this run, never reused */
+guint remmina_protocol_widget_get_id( RemminaProtocolWidget *gp );
+/* Monotonic time the plugin signalled the connection as open, 0 while connecting */
+gint64 remmina_protocol_widget_get_connected_time( RemminaProtocolWidget *gp );
+gint remmina_protocol_widget_get_ssh_channels( RemminaProtocolWidget *gp );
 
 void remmina_protocol_widget_update_remote_resolution( RemminaProtocolWidget *gp );
 
@@ -0,0 +1,333 @@
+/*
+ * Remmina - The GTK+ Remote Desktop Client
+ * Copyright (C) 2016-2022 Antenore Gatta, Giovanni Panozzo
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ *
+ *  In addition, as a special exception, the copyright holders give
+ *  permission to link the code of portions of this program with the
+ *  OpenSSL library under certain conditions as described in each
+ *  individual source file, and distribute linked combinations
+ *  including the two.
+ *  You must obey the GNU General Public License in all respects
+ *  for all of the code used other than OpenSSL. *  If you modify
+ *  file(s) with this exception, you may extend this exception to your
+ *  version of the file(s), but you are not obligated to do so. *  If you
+ *  do not wish to do so, delete this exception statement from your
+ *  version. *  If you delete this exception statement from all source
+ *  files in the program, then also delete it here.
+ *
+ */
+
+/* Screenshot encoding is done on a small thread pool, so that writing
+ * a full frame of a large remote desktop does not block the GTK thread.
+ * Besides PNG, two fast lossless formats are available for bulk captures:
+ * binary PPM (no compression at all) and QOI (https://qoiformat.org). */
+
+#include "config.h"
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "remmina/remmina_trace_calls.hpp"
+#include "remmina_log.hpp"
+#include "remmina_screenshot.hpp"
+
+#define REMMINA_SCREENSHOT_MAX_THREADS 2
+
+struct RemminaScreenshotJob
+{
+    cairo_surface_t *surface;
+    char *filename;
+    gint format;
+    bool success;
+    RemminaScreenshotDoneFunc done_cb;
+    gpointer user_data;
+};
+
+static GThreadPool *screenshot_pool = NULL;
+static const cairo_user_data_key_t screenshot_buffer_key = { 0 };
+
+const char *remmina_screenshot_format_get_extension( gint format )
+{
+    TRACE_CALL( __func__ );
+    switch( format )
+    {
+        case REMMINA_SCREENSHOT_FORMAT_PPM:
+            return "ppm";
+        case REMMINA_SCREENSHOT_FORMAT_QOI:
+            return "qoi";
+        default:
+            return "png";
+    }
+}
+
+/* Read one pixel of an image surface as opaque 8 bit RGB */
+static inline void remmina_screenshot_get_rgb( const unsigned char *row,
+                                               int x,
+                                               cairo_format_t format,
+                                               unsigned char *rgb )
+{
+    if( format == CAIRO_FORMAT_RGB16_565 )
+    {
+        guint16 p = ( (const guint16 *)row )[x];
+        rgb[0] = ( ( p >> 11 ) & 0x1f ) << 3;
+        rgb[1] = ( ( p >> 5 ) & 0x3f ) << 2;
+        rgb[2] = ( p & 0x1f ) << 3;
+    }
+    else
+    {
+        guint32 p = ( (const guint32 *)row )[x];
+        rgb[0] = ( p >> 16 ) & 0xff;
+        rgb[1] = ( p >> 8 ) & 0xff;
+        rgb[2] = p & 0xff;
+    }
+}
+
+static bool remmina_screenshot_write_ppm( cairo_surface_t *surface, FILE *fp )
+{
+    TRACE_CALL( __func__ );
+    int width = cairo_image_surface_get_width( surface );
+    int height = cairo_image_surface_get_height( surface );
+    int stride = cairo_image_surface_get_stride( surface );
+    cairo_format_t format = cairo_image_surface_get_format( surface );
+    const unsigned char *data = cairo_image_surface_get_data( surface );
+    unsigned char *line;
+    int x, y;
+
+    fprintf( fp, "P6\n%d %d\n255\n", width, height );
+    line = (unsigned char *)g_malloc( width * 3 );
+    for( y = 0; y < height; y++ )
+    {
+        for( x = 0; x < width; x++ )
+            remmina_screenshot_get_rgb( data + y * stride, x, format, line + x * 3 );
+        if( fwrite( line, 3, width, fp ) != (size_t)width )
+        {
+            g_free( line );
+            return FALSE;
+        }
+    }
+    g_free( line );
+    return TRUE;
+}
+
+static inline void remmina_screenshot_put_be32( FILE *fp, guint32 v )
+{
+    putc( ( v >> 24 ) & 0xff, fp );
+    putc( ( v >> 16 ) & 0xff, fp );
+    putc( ( v >> 8 ) & 0xff, fp );
+    putc( v & 0xff, fp );
+}
+
+static bool remmina_screenshot_write_qoi( cairo_surface_t *surface, FILE *fp )
+{
+    TRACE_CALL( __func__ );
+    int width = cairo_image_surface_get_width( surface );
+    int height = cairo_image_surface_get_height( surface );
+    int stride = cairo_image_surface_get_stride( surface );
+    cairo_format_t format = cairo_image_surface_get_format( surface );
+    const unsigned char *data = cairo_image_surface_get_data( surface );
+    unsigned char index[64][3] = { { 0 } };
+    /* The decoder's index starts with transparent black, which never matches an opaque pixel */
+    bool index_used[64] = { false };
+    unsigned char prev[3] = { 0, 0, 0 };
+    unsigned char px[3];
+    int run = 0;
+    int x, y, idx;
+
+    /* Header: magic, width, height, 3 channels, sRGB with linear alpha */
+    fwrite( "qoif", 1, 4, fp );
+    remmina_screenshot_put_be32( fp, width );
+    remmina_screenshot_put_be32( fp, height );
+    putc( 3, fp );
+    putc( 0, fp );
+
+    for( y = 0; y < height; y++ )
+    {
+        for( x = 0; x < width; x++ )
+        {
+            remmina_screenshot_get_rgb( data + y * stride, x, format, px );
+
+            if( px[0] == prev[0] && px[1] == prev[1] && px[2] == prev[2] )
+            {
+                run++;
+                if( run == 62 )
+                {
+                    putc( 0xc0 | ( run - 1 ), fp );
+                    run = 0;
+                }
+                continue;
+            }
+
+            if( run > 0 )
+            {
+                putc( 0xc0 | ( run - 1 ), fp );
+                run = 0;
+            }
+
+            /* Alpha is always 255, so its hash contribution is a constant */
+            idx = ( px[0] * 3 + px[1] * 5 + px[2] * 7 + 255 * 11 ) % 64;
+            if( index_used[idx] && index[idx][0] == px[0] && index[idx][1] == px[1] && index[idx][2] == px[2] )
+            {
+                putc( idx, fp );
+            }
+            else
+            {
+                signed char vr = px[0] - prev[0];
+                signed char vg = px[1] - prev[1];
+                signed char vb = px[2] - prev[2];
+                signed char vg_r = vr - vg;
+                signed char vg_b = vb - vg;
+
+                memcpy( index[idx], px, 3 );
+                index_used[idx] = TRUE;
+                if( vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2 )
+                {
+                    putc( 0x40 | ( vr + 2 ) << 4 | ( vg + 2 ) << 2 | ( vb + 2 ), fp );
+                }
+                else if( vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8 )
+                {
+                    putc( 0x80 | ( vg + 32 ), fp );
+                    putc( ( vg_r + 8 ) << 4 | ( vg_b + 8 ), fp );
+                }
+                else
+                {
+                    putc( 0xfe, fp );
+                    fwrite( px, 1, 3, fp );
+                }
+            }
+            memcpy( prev, px, 3 );
+        }
+    }
+    if( run > 0 )
+        putc( 0xc0 | ( run - 1 ), fp );
+
+    /* End marker */
+    fwrite( "\0\0\0\0\0\0\0\1", 1, 8, fp );
+    return !ferror( fp );
+}
+
+static bool remmina_screenshot_write_raw( cairo_surface_t *surface, const char *filename, gint format )
+{
+    TRACE_CALL( __func__ );
+    FILE *fp;
+    bool ret;
+
+    fp = g_fopen( filename, "wb" );
+    if( !fp )
+        return FALSE;
+
+    if( format == REMMINA_SCREENSHOT_FORMAT_QOI )
+        ret = remmina_screenshot_write_qoi( surface, fp );
+    else
+        ret = remmina_screenshot_write_ppm( surface, fp );
+
+    if( fclose( fp ) != 0 )
+        ret = FALSE;
+    return ret;
+}
+
+static gboolean remmina_screenshot_done_idle( gpointer data )
+{
+    TRACE_CALL( __func__ );
+    RemminaScreenshotJob *job = (RemminaScreenshotJob *)data;
+
+    if( job->done_cb )
+        job->done_cb( job->filename, job->success, job->user_data );
+    g_free( job->filename );
+    g_free( job );
+    return G_SOURCE_REMOVE;
+}
+
+static void remmina_screenshot_worker( gpointer data, gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    RemminaScreenshotJob *job = (RemminaScreenshotJob *)data;
+    gint64 start = g_get_monotonic_time();
+
+    cairo_surface_flush( job->surface );
+    if( job->format == REMMINA_SCREENSHOT_FORMAT_PNG )
+        job->success = cairo_surface_write_to_png( job->surface, job->filename ) == CAIRO_STATUS_SUCCESS;
+    else
+        job->success = remmina_screenshot_write_raw( job->surface, job->filename, job->format );
+    cairo_surface_destroy( job->surface );
+    job->surface = NULL;
+
+    REMMINA_DEBUG( "Screenshot %s encoded in %" G_GINT64_FORMAT " ms",
+                   job->filename,
+                   ( g_get_monotonic_time() - start ) / 1000 );
+
+    gdk_threads_add_idle( remmina_screenshot_done_idle, job );
+}
+
+void remmina_screenshot_save_async( cairo_surface_t *surface,
+                                    const char *basename,
+                                    gint format,
+                                    RemminaScreenshotDoneFunc done_cb,
+                                    gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    RemminaScreenshotJob *job;
+    GError *err = NULL;
+
+    if( screenshot_pool == NULL )
+        screenshot_pool =
+            g_thread_pool_new( remmina_screenshot_worker, NULL, REMMINA_SCREENSHOT_MAX_THREADS, FALSE, NULL );
+
+    job = g_new0( RemminaScreenshotJob, 1 );
+    job->surface = surface;
+    job->format = format;
+    job->filename = g_strdup_printf( "%s.%s", basename, remmina_screenshot_format_get_extension( format ) );
+    job->done_cb = done_cb;
+    job->user_data = user_data;
+
+    if( !g_thread_pool_push( screenshot_pool, job, &err ) )
+    {
+        /* Could not spawn a worker, encode synchronously */
+        REMMINA_WARNING( "Unable to start screenshot worker: %s", err ? err->message : "" );
+        g_clear_error( &err );
+        remmina_screenshot_worker( job, NULL );
+    }
+}
+
+void remmina_screenshot_save_buffer_async( unsigned char *buffer,
+                                           int width,
+                                           int height,
+                                           int bitsPerPixel,
+                                           const char *basename,
+                                           gint format,
+                                           RemminaScreenshotDoneFunc done_cb,
+                                           gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    cairo_format_t cairo_format;
+    cairo_surface_t *surface;
+
+    /* 32 bpp framebuffers carry an undefined X byte, reading them as RGB24
+     * avoids repainting into an opaque surface before encoding */
+    if( bitsPerPixel == 32 || bitsPerPixel == 24 )
+        cairo_format = CAIRO_FORMAT_RGB24;
+    else
+        cairo_format = CAIRO_FORMAT_RGB16_565;
+
+    surface = cairo_image_surface_create_for_data(
+        buffer, cairo_format, width, height, cairo_format_stride_for_width( cairo_format, width ) );
+    /* The surface now owns the buffer */
+    cairo_surface_set_user_data( surface, &screenshot_buffer_key, buffer, free );
+
+    remmina_screenshot_save_async( surface, basename, format, done_cb, user_data );
+}
@@ -0,0 +1,59 @@
+/*
+ * Remmina - The GTK+ Remote Desktop Client
+ * Copyright (C) 2016-2022 Antenore Gatta, Giovanni Panozzo
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ *
+ *  In addition, as a special exception, the copyright holders give
+ *  permission to link the code of portions of this program with the
+ *  OpenSSL library under certain conditions as described in each
+ *  individual source file, and distribute linked combinations
+ *  including the two.
+ *  You must obey the GNU General Public License in all respects
+ *  for all of the code used other than OpenSSL. *  If you modify
+ *  file(s) with this exception, you may extend this exception to your
+ *  version of the file(s), but you are not obligated to do so. *  If you
+ *  do not wish to do so, delete this exception statement from your
+ *  version. *  If you delete this exception statement from all source
+ *  files in the program, then also delete it here.
+ *
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include "remmina/types.hpp"
+
+const char *remmina_screenshot_format_get_extension( gint format );
+
+/* Encode surface on the screenshot worker pool and write it to basename + extension.
+ * Ownership of surface is transferred to the worker, the caller must not use it anymore. */
+void remmina_screenshot_save_async( cairo_surface_t *surface,
+                                    const char *basename,
+                                    gint format,
+                                    RemminaScreenshotDoneFunc done_cb,
+                                    gpointer user_data );
+
+/* Same as above, but the worker takes ownership of a malloc()ed raw framebuffer,
+ * as returned by RemminaProtocolPlugin::get_plugin_screenshot */
+void remmina_screenshot_save_buffer_async( unsigned char *buffer,
+                                           int width,
+                                           int height,
+                                           int bitsPerPixel,
+                                           const char *basename,
+                                           gint format,
+                                           RemminaScreenshotDoneFunc done_cb,
+                                           gpointer user_data );
@@ -49,10 +49,12 @@
 #    endif
 #    include "remmina_public.hpp"
 #    include "remmina_pref.hpp"
+#    include "remmina_protocol_widget.hpp"
 #    include "remmina_ssh.hpp"
 #    include "remmina_sftp_client.hpp"
 #    include "remmina_sftp_plugin.hpp"
 #    include "remmina_masterthread_exec.hpp"
+#    include "remmina_log.hpp"
 #    include "remmina/remmina_trace_calls.hpp"
 
 G_DEFINE_TYPE( RemminaSFTPClient, remmina_sftp_client, REMMINA_TYPE_FTP_CLIENT )
@@ -82,6 +84,7 @@ static void remmina_sftp_client_class_init( RemminaSFTPClientClass *klass )
 /* ------------------------ The Task Thread routines ----------------------------- */
 
 static int remmina_sftp_client_refresh( RemminaSFTPClient *client );
+static int remmina_sftp_client_list_invalidate( RemminaSFTPClient *client );
 
 #    define THREAD_CHECK_EXIT ( !client->taskid || client->thread_abort )
 
@@ -266,6 +269,8 @@ static int remmina_sftp_client_thread_download_file( RemminaSFTPClient *client,
             return FALSE;
         }
 
+        if( client->gp )
+            remmina_protocol_widget_perf_add( client->gp, REMMINA_PERF_BYTES_IN, len );
         *donesize += (guint64)len;
         task->donesize = (gfloat)( *donesize );
 
@@ -565,6 +570,8 @@ static int remmina_sftp_client_thread_upload_file( RemminaSFTPClient *client,
             return FALSE;
         }
 
+        if( client->gp )
+            remmina_protocol_widget_perf_add( client->gp, REMMINA_PERF_BYTES_OUT, len );
         *donesize += (guint64)len;
         task->donesize = (gfloat)( *donesize );
 
@@ -769,6 +776,8 @@ static gpointer remmina_sftp_client_thread_main( gpointer data )
         tmp = remmina_ftp_client_get_dir( REMMINA_FTP_CLIENT( client ) );
         if( g_strcmp0( tmp, refreshdir ) == 0 )
             IDLE_ADD( (GSourceFunc)remmina_sftp_client_refresh, client );
+        else
+            IDLE_ADD( (GSourceFunc)remmina_sftp_client_list_invalidate, client );
         g_free( tmp );
     }
     g_free( refreshdir );
@@ -782,6 +791,19 @@ static gpointer remmina_sftp_client_thread_main( gpointer data )
 static void remmina_sftp_client_destroy( RemminaSFTPClient *client, gpointer data )
 {
     TRACE_CALL( __func__ );
+    /* The listing worker uses client->sftp, make sure it is gone before freeing it.
+     * Queued jobs are stale after the cancel, running them only drops their reference. */
+    remmina_sftp_client_list_cancel( client );
+    if( client->list_pool )
+    {
+        g_thread_pool_free( client->list_pool, FALSE, TRUE );
+        client->list_pool = NULL;
+    }
+    if( client->list_cache )
+    {
+        g_hash_table_destroy( client->list_cache );
+        client->list_cache = NULL;
+    }
     if( client->sftp )
     {
         remmina_sftp_free( client->sftp );
@@ -797,64 +819,386 @@ static void remmina_sftp_client_destroy( RemminaSFTPClient *client, gpointer dat
     }
 }
 
-static sftp_dir remmina_sftp_client_sftp_session_opendir( RemminaSFTPClient *client, const char *dir )
+/* ------------------------ The Folder Listing routines ----------------------------- */
+
+/* Listing a folder is done on a worker, which appends entries to a RemminaSFTPListJob.
+ * A timer on the main loop moves them into the file list a slice at a time, so
+ * large folders and slow links do not freeze the GUI. Complete listings are kept
+ * for a short while, so going back to a recently visited folder does not hit the server. */
+
+#    define REMMINA_SFTP_LIST_CACHE_TTL 30
+#    define REMMINA_SFTP_LIST_FEED_INTERVAL 20
+#    define REMMINA_SFTP_LIST_FEED_SLICE 8000
+#    define REMMINA_SFTP_LIST_WORKER_BATCH 256
+
+struct RemminaSFTPListEntry
+{
+    gint type;
+    char *name;
+    gfloat size;
+    char *owner;
+    char *group;
+    guint32 permissions;
+};
+
+struct RemminaSFTPListJob
+{
+    gint refcount;
+    gint generation;
+    char *dir;
+    bool from_cache;
+    bool started;
+    /* The following are written by the worker and protected by lock */
+    GMutex lock;
+    char *path;
+    GPtrArray *entries;
+    guint shown;
+    bool done;
+    char *error;
+};
+
+struct RemminaSFTPListCache
+{
+    gint64 timestamp;
+    GPtrArray *entries;
+};
+
+static void remmina_sftp_client_list_entry_free( gpointer data )
+{
+    RemminaSFTPListEntry *entry = (RemminaSFTPListEntry *)data;
+
+    g_free( entry->name );
+    g_free( entry->owner );
+    g_free( entry->group );
+    g_free( entry );
+}
+
+static void remmina_sftp_client_list_cache_free( gpointer data )
+{
+    RemminaSFTPListCache *cache = (RemminaSFTPListCache *)data;
+
+    g_ptr_array_unref( cache->entries );
+    g_free( cache );
+}
+
+static RemminaSFTPListJob *remmina_sftp_client_list_job_new( RemminaSFTPClient *client, const char *dir )
 {
     TRACE_CALL( __func__ );
+    RemminaSFTPListJob *job = g_new0( RemminaSFTPListJob, 1 );
+
+    job->refcount = 1;
+    job->generation = g_atomic_int_get( &client->list_generation );
+    job->dir = g_strdup( dir );
+    g_mutex_init( &job->lock );
+    return job;
+}
+
+static void remmina_sftp_client_list_job_unref( RemminaSFTPListJob *job )
+{
+    if( !g_atomic_int_dec_and_test( &job->refcount ) )
+        return;
+    g_mutex_clear( &job->lock );
+    if( job->entries )
+        g_ptr_array_unref( job->entries );
+    g_free( job->dir );
+    g_free( job->path );
+    g_free( job->error );
+    g_free( job );
+}
+
+static bool remmina_sftp_client_list_job_stale( RemminaSFTPClient *client, RemminaSFTPListJob *job )
+{
+    return job->generation != g_atomic_int_get( &client->list_generation );
+}
+
+static void remmina_sftp_client_list_job_fail( RemminaSFTPListJob *job, char *error )
+{
+    TRACE_CALL( __func__ );
+    g_mutex_lock( &job->lock );
+    job->error = error;
+    job->done = TRUE;
+    g_mutex_unlock( &job->lock );
+}
+
+static void remmina_sftp_client_list_job_append( RemminaSFTPListJob *job, GPtrArray *batch, bool done )
+{
+    guint i;
+
+    g_mutex_lock( &job->lock );
+    for( i = 0; i < batch->len; i++ )
+        g_ptr_array_add( job->entries, g_ptr_array_index( batch, i ) );
+    job->done = done;
+    g_mutex_unlock( &job->lock );
+    g_ptr_array_set_size( batch, 0 );
+}
+
+static void remmina_sftp_client_list_worker( gpointer data, gpointer user_data )
+{
+    TRACE_CALL( __func__ );
+    RemminaSFTPListJob *job = (RemminaSFTPListJob *)data;
+    RemminaSFTPClient *client = REMMINA_SFTP_CLIENT( user_data );
+    RemminaSSH *ssh = REMMINA_SSH( client->sftp );
+    RemminaSFTPListEntry *entry;
+    sftp_attributes sftpattr;
     sftp_dir sftpdir;
-    GtkWidget *dialog;
+    GPtrArray *batch;
+    char *path_conv;
+    char *path;
+    char *tmp;
+    bool eof;
+
+    if( remmina_sftp_client_list_job_stale( client, job ) )
+    {
+        remmina_sftp_client_list_job_unref( job );
+        return;
+    }
+
+    tmp = remmina_ssh_unconvert( ssh, job->dir );
+    g_mutex_lock( &client->list_mutex );
+    path_conv = sftp_canonicalize_path( client->sftp->sftp_sess, tmp );
+    if( !path_conv )
+    {
+        remmina_sftp_client_list_job_fail(
+            job,
+            g_strdup_printf( _( "Could not open the folder “%s”. %s" ), job->dir, ssh_get_error( ssh->session ) ) );
+        g_mutex_unlock( &client->list_mutex );
+        g_free( tmp );
+        remmina_sftp_client_list_job_unref( job );
+        return;
+    }
+    g_free( tmp );
 
-    sftpdir = sftp_opendir( client->sftp->sftp_sess, (char *)dir );
+    sftpdir = sftp_opendir( client->sftp->sftp_sess, path_conv );
+    path = remmina_ssh_convert( ssh, path_conv );
     if( !sftpdir )
     {
-        dialog = gtk_message_dialog_new( GTK_WINDOW( gtk_widget_get_toplevel( GTK_WIDGET( client ) ) ),
-                                         GTK_DIALOG_MODAL,
-                                         GTK_MESSAGE_ERROR,
-                                         GTK_BUTTONS_OK,
-                                         _( "Could not open the folder “%s”. %s" ),
-                                         dir,
-                                         ssh_get_error( REMMINA_SSH( client->sftp )->session ) );
-        gtk_dialog_run( GTK_DIALOG( dialog ) );
-        gtk_widget_destroy( dialog );
+        remmina_sftp_client_list_job_fail(
+            job,
+            g_strdup_printf( _( "Could not open the folder “%s”. %s" ), path, ssh_get_error( ssh->session ) ) );
+        g_mutex_unlock( &client->list_mutex );
+        g_free( path );
+        g_free( path_conv );
+        remmina_sftp_client_list_job_unref( job );
+        return;
+    }
+    g_mutex_unlock( &client->list_mutex );
+    g_free( path_conv );
+
+    g_mutex_lock( &job->lock );
+    job->path = path;
+    g_mutex_unlock( &job->lock );
+
+    batch = g_ptr_array_sized_new( REMMINA_SFTP_LIST_WORKER_BATCH );
+    for( ;; )
+    {
+        if( remmina_sftp_client_list_job_stale( client, job ) )
+            break;
+
+        g_mutex_lock( &client->list_mutex );
+        sftpattr = sftp_readdir( client->sftp->sftp_sess, sftpdir );
+        if( !sftpattr )
+        {
+            eof = sftp_dir_eof( sftpdir );
+            if( !eof )
+            {
+                remmina_sftp_client_list_job_append( job, batch, FALSE );
+                remmina_sftp_client_list_job_fail(
+                    job,
+                    g_strdup_printf( _( "Could not read from the folder. %s" ), ssh_get_error( ssh->session ) ) );
+            }
+            g_mutex_unlock( &client->list_mutex );
+            if( eof )
+                remmina_sftp_client_list_job_append( job, batch, TRUE );
+            break;
+        }
+        g_mutex_unlock( &client->list_mutex );
+
+        if( g_strcmp0( sftpattr->name, "." ) != 0 && g_strcmp0( sftpattr->name, ".." ) != 0 )
+        {
+            entry = g_new( RemminaSFTPListEntry, 1 );
+            GET_SFTPATTR_TYPE( sftpattr, entry->type );
+            entry->name = remmina_ssh_convert( ssh, sftpattr->name );
+            entry->size = (gfloat)sftpattr->size;
+            entry->owner = g_strdup( sftpattr->owner );
+            entry->group = g_strdup( sftpattr->group );
+            entry->permissions = sftpattr->permissions;
+            g_ptr_array_add( batch, entry );
+            if( batch->len >= REMMINA_SFTP_LIST_WORKER_BATCH )
+                remmina_sftp_client_list_job_append( job, batch, FALSE );
+        }
+        sftp_attributes_free( sftpattr );
+    }
+    g_ptr_array_free( batch, TRUE );
+
+    g_mutex_lock( &client->list_mutex );
+    sftp_closedir( sftpdir );
+    g_mutex_unlock( &client->list_mutex );
+
+    remmina_sftp_client_list_job_unref( job );
+}
+
+static gboolean remmina_sftp_client_list_cache_expired( gpointer key, gpointer value, gpointer user_data )
+{
+    RemminaSFTPListCache *cache = (RemminaSFTPListCache *)value;
+
+    return *(gint64 *)user_data - cache->timestamp > (gint64)REMMINA_SFTP_LIST_CACHE_TTL * G_USEC_PER_SEC;
+}
+
+static void remmina_sftp_client_list_cache_store( RemminaSFTPClient *client, const char *path, GPtrArray *entries )
+{
+    TRACE_CALL( __func__ );
+    RemminaSFTPListCache *cache;
+    gint64 now = g_get_monotonic_time();
+
+    g_hash_table_foreach_remove( client->list_cache, remmina_sftp_client_list_cache_expired, &now );
+
+    cache = g_new( RemminaSFTPListCache, 1 );
+    cache->timestamp = now;
+    cache->entries = g_ptr_array_ref( entries );
+    g_hash_table_replace( client->list_cache, g_strdup( path ), cache );
+}
+
+static GPtrArray *remmina_sftp_client_list_cache_lookup( RemminaSFTPClient *client, const char *path )
+{
+    TRACE_CALL( __func__ );
+    RemminaSFTPListCache *cache;
+    gint64 now = g_get_monotonic_time();
+
+    cache = (RemminaSFTPListCache *)g_hash_table_lookup( client->list_cache, path );
+    if( !cache )
+        return NULL;
+    if( remmina_sftp_client_list_cache_expired( NULL, cache, &now ) )
+    {
+        g_hash_table_remove( client->list_cache, path );
         return NULL;
     }
-    return sftpdir;
+    return cache->entries;
 }
 
-static int remmina_sftp_client_sftp_session_closedir( RemminaSFTPClient *client, sftp_dir sftpdir )
+static void remmina_sftp_client_list_show_error( RemminaSFTPClient *client, const char *error )
 {
     TRACE_CALL( __func__ );
     GtkWidget *dialog;
 
-    if( !sftp_dir_eof( sftpdir ) )
+    dialog = gtk_message_dialog_new( GTK_WINDOW( gtk_widget_get_toplevel( GTK_WIDGET( client ) ) ),
+                                     GTK_DIALOG_MODAL,
+                                     GTK_MESSAGE_ERROR,
+                                     GTK_BUTTONS_OK,
+                                     "%s",
+                                     error );
+    gtk_widget_show( dialog );
+    g_signal_connect( G_OBJECT( dialog ), "response", G_CALLBACK( gtk_widget_destroy ), NULL );
+}
+
+static void remmina_sftp_client_list_cancel( RemminaSFTPClient *client )
+{
+    TRACE_CALL( __func__ );
+    g_atomic_int_inc( &client->list_generation );
+    if( client->list_source )
     {
-        dialog = gtk_message_dialog_new( GTK_WINDOW( gtk_widget_get_toplevel( GTK_WIDGET( client ) ) ),
-                                         GTK_DIALOG_MODAL,
-                                         GTK_MESSAGE_ERROR,
-                                         GTK_BUTTONS_OK,
-                                         _( "Could not read from the folder. %s" ),
-                                         ssh_get_error( REMMINA_SSH( client->sftp )->session ) );
-        gtk_dialog_run( GTK_DIALOG( dialog ) );
-        gtk_widget_destroy( dialog );
-        return FALSE;
+        g_source_remove( client->list_source );
+        client->list_source = 0;
     }
-    sftp_closedir( sftpdir );
-    return TRUE;
+    if( client->list_job )
+    {
+        remmina_sftp_client_list_job_unref( client->list_job );
+        client->list_job = NULL;
+    }
+}
+
+static gboolean remmina_sftp_client_list_feed( gpointer data )
+{
+    TRACE_CALL( __func__ );
+    RemminaSFTPClient *client = REMMINA_SFTP_CLIENT( data );
+    RemminaSFTPListJob *job = client->list_job;
+    RemminaSFTPListEntry *entry;
+    gint64 deadline;
+    char *path;
+    char *error;
+    bool done;
+
+    if( !job->started )
+    {
+        g_mutex_lock( &job->lock );
+        path = g_strdup( job->path );
+        error = job->done && !job->path ? g_strdup( job->error ) : NULL;
+        g_mutex_unlock( &job->lock );
+
+        if( error )
+        {
+            /* The folder could not be opened, keep showing the current one */
+            client->list_source = 0;
+            remmina_sftp_client_list_cancel( client );
+            remmina_sftp_client_list_show_error( client, error );
+            g_free( error );
+            return G_SOURCE_REMOVE;
+        }
+        if( !path )
+            return G_SOURCE_CONTINUE;
+
+        job->started = TRUE;
+        remmina_ftp_client_clear_file_list( REMMINA_FTP_CLIENT( client ) );
+        /* Changing the folder combo may emit open-dir again for the same path, which is ignored */
+        remmina_ftp_client_set_dir( REMMINA_FTP_CLIENT( client ), path );
+        g_free( path );
+        if( client->list_job != job )
+            return G_SOURCE_REMOVE;
+    }
+
+    deadline = g_get_monotonic_time() + REMMINA_SFTP_LIST_FEED_SLICE;
+    g_mutex_lock( &job->lock );
+    while( job->shown < job->entries->len && g_get_monotonic_time() < deadline )
+    {
+        entry = (RemminaSFTPListEntry *)g_ptr_array_index( job->entries, job->shown++ );
+        remmina_ftp_client_add_file( REMMINA_FTP_CLIENT( client ),
+                                     REMMINA_FTP_FILE_COLUMN_TYPE,
+                                     entry->type,
+                                     REMMINA_FTP_FILE_COLUMN_NAME,
+                                     entry->name,
+                                     REMMINA_FTP_FILE_COLUMN_SIZE,
+                                     entry->size,
+                                     REMMINA_FTP_FILE_COLUMN_USER,
+                                     entry->owner,
+                                     REMMINA_FTP_FILE_COLUMN_GROUP,
+                                     entry->group,
+                                     REMMINA_FTP_FILE_COLUMN_PERMISSION,
+                                     entry->permissions,
+                                     -1 );
+    }
+    done = job->done && job->shown == job->entries->len;
+    error = done ? g_strdup( job->error ) : NULL;
+    g_mutex_unlock( &job->lock );
+
+    if( !done )
+        return G_SOURCE_CONTINUE;
+
+    if( error )
+        remmina_sftp_client_list_show_error( client, error );
+    else if( !job->from_cache )
+        remmina_sftp_client_list_cache_store( client, job->path, job->entries );
+    g_free( error );
+
+    client->list_source = 0;
+    client->list_job = NULL;
+    remmina_sftp_client_list_job_unref( job );
+    return G_SOURCE_REMOVE;
 }
 
 static void remmina_sftp_client_on_opendir( RemminaSFTPClient *client, const char *dir, gpointer data )
 {
     TRACE_CALL( __func__ );
-    sftp_dir sftpdir;
-    sftp_attributes sftpattr;
-    GtkWidget *dialog;
+    RemminaSFTPListJob *job;
+    GPtrArray *entries = NULL;
+    GError *err = NULL;
     char *newdir;
-    char *newdir_conv;
+    char *key = NULL;
     char *tmp;
-    gint type;
+    bool busy;
 
     if( client->sftp == NULL )
         return;
 
+    tmp = remmina_ftp_client_get_dir( REMMINA_FTP_CLIENT( client ) );
     if( !dir || dir[0] == '\0' )
     {
         newdir = g_strdup( "." );
@@ -862,80 +1206,77 @@ static void remmina_sftp_client_on_opendir( RemminaSFTPClient *client, const cha
     else if( dir[0] == '/' )
     {
         newdir = g_strdup( dir );
+        key = g_strdup( dir );
     }
-    else
+    else if( tmp )
     {
-        tmp = remmina_ftp_client_get_dir( REMMINA_FTP_CLIENT( client ) );
-        if( tmp )
-        {
-            newdir = remmina_public_combine_path( tmp, dir );
-            g_free( tmp );
-        }
-        else
-        {
-            newdir = g_strdup_printf( "./%s", dir );
-        }
+        newdir = remmina_public_combine_path( tmp, dir );
+        /* The current folder is canonical, so its parent and children can be looked up
+         * in the cache as they are. "." is a refresh and always goes to the server. */
+        if( g_strcmp0( dir, ".." ) == 0 )
+            key = g_path_get_dirname( tmp );
+        else if( g_strcmp0( dir, "." ) != 0 && !strchr( dir, '/' ) )
+            key = g_strdup( newdir );
     }
-
-    tmp = remmina_ssh_unconvert( REMMINA_SSH( client->sftp ), newdir );
-    newdir_conv = sftp_canonicalize_path( client->sftp->sftp_sess, tmp );
-    g_free( tmp );
-    g_free( newdir );
-    newdir = remmina_ssh_convert( REMMINA_SSH( client->sftp ), newdir_conv );
-    if( !newdir )
+    else
     {
-        dialog = gtk_message_dialog_new( NULL,
-                                         GTK_DIALOG_MODAL,
-                                         GTK_MESSAGE_ERROR,
-                                         GTK_BUTTONS_OK,
-                                         _( "Could not open the folder “%s”. %s" ),
-                                         dir,
-                                         ssh_get_error( REMMINA_SSH( client->sftp )->session ) );
-        gtk_widget_show( dialog );
-        g_signal_connect( G_OBJECT( dialog ), "response", G_CALLBACK( gtk_widget_destroy ), NULL );
-        g_free( newdir_conv );
-        return;
+        newdir = g_strdup_printf( "./%s", dir );
     }
+    g_free( tmp );
 
-    sftpdir = remmina_sftp_client_sftp_session_opendir( client, newdir_conv );
-    g_free( newdir_conv );
-    if( !sftpdir )
+    job = client->list_job;
+    if( job && key )
     {
-        g_free( newdir );
-        return;
+        g_mutex_lock( &job->lock );
+        busy = g_strcmp0( key, job->dir ) == 0 || g_strcmp0( key, job->path ) == 0;
+        g_mutex_unlock( &job->lock );
+        if( busy )
+        {
+            /* Already being listed */
+            g_free( newdir );
+            g_free( key );
+            return;
+        }
     }
 
-    remmina_ftp_client_clear_file_list( REMMINA_FTP_CLIENT( client ) );
+    remmina_sftp_client_list_cancel( client );
+
+    if( key )
+        entries = remmina_sftp_client_list_cache_lookup( client, key );
 
-    while( ( sftpattr = sftp_readdir( client->sftp->sftp_sess, sftpdir ) ) )
+    job = remmina_sftp_client_list_job_new( client, newdir );
+    if( entries )
     {
-        if( g_strcmp0( sftpattr->name, "." ) != 0 && g_strcmp0( sftpattr->name, ".." ) != 0 )
+        job->from_cache = TRUE;
+        job->path = g_strdup( key );
+        job->entries = g_ptr_array_ref( entries );
+        job->done = TRUE;
+    }
+    else
+    {
+        job->entries = g_ptr_array_new_with_free_func( remmina_sftp_client_list_entry_free );
+        if( !client->list_pool )
+            client->list_pool = g_thread_pool_new( remmina_sftp_client_list_worker, client, 1, FALSE, NULL );
+        g_atomic_int_inc( &job->refcount );
+        if( !g_thread_pool_push( client->list_pool, job, &err ) )
         {
-            GET_SFTPATTR_TYPE( sftpattr, type );
-
-            tmp = remmina_ssh_convert( REMMINA_SSH( client->sftp ), sftpattr->name );
-            remmina_ftp_client_add_file( REMMINA_FTP_CLIENT( client ),
-                                         REMMINA_FTP_FILE_COLUMN_TYPE,
-                                         type,
-                                         REMMINA_FTP_FILE_COLUMN_NAME,
-                                         tmp,
-                                         REMMINA_FTP_FILE_COLUMN_SIZE,
-                                         (gfloat)sftpattr->size,
-                                         REMMINA_FTP_FILE_COLUMN_USER,
-                                         sftpattr->owner,
-                                         REMMINA_FTP_FILE_COLUMN_GROUP,
-                                         sftpattr->group,
-                                         REMMINA_FTP_FILE_COLUMN_PERMISSION,
-                                         sftpattr->permissions,
-                                         -1 );
-            g_free( tmp );
+            REMMINA_WARNING( "Unable to start the folder listing worker: %s", err ? err->message : "" );
+            g_clear_error( &err );
+            remmina_sftp_client_list_worker( job, client );
         }
-        sftp_attributes_free( sftpattr );
     }
-    remmina_sftp_client_sftp_session_closedir( client, sftpdir );
-
-    remmina_ftp_client_set_dir( REMMINA_FTP_CLIENT( client ), newdir );
     g_free( newdir );
+    g_free( key );
+
+    client->list_job = job;
+    client->list_source = g_timeout_add( REMMINA_SFTP_LIST_FEED_INTERVAL, remmina_sftp_client_list_feed, client );
+}
+
+static int remmina_sftp_client_list_invalidate( RemminaSFTPClient *client )
+{
+    TRACE_CALL( __func__ );
+    g_hash_table_remove_all( client->list_cache );
+    return FALSE;
 }
 
 static void remmina_sftp_client_on_newtask( RemminaSFTPClient *client, gpointer data )
@@ -982,6 +1323,7 @@ static int remmina_sftp_client_on_deletefile( RemminaSFTPClient *client, gint ty
     char *tmp;
 
     tmp = remmina_ssh_unconvert( REMMINA_SSH( client->sftp ), name );
+    g_mutex_lock( &client->list_mutex );
     switch( type )
     {
         case REMMINA_FTP_FILE_TYPE_DIR:
@@ -992,6 +1334,7 @@ static int remmina_sftp_client_on_deletefile( RemminaSFTPClient *client, gint ty
             ret = sftp_unlink( client->sftp->sftp_sess, tmp );
             break;
     }
+    g_mutex_unlock( &client->list_mutex );
     g_free( tmp );
 
     if( ret != 0 )
@@ -1017,6 +1360,13 @@ static void remmina_sftp_client_init( RemminaSFTPClient *client )
     client->thread = 0;
     client->taskid = 0;
     client->thread_abort = FALSE;
+    client->list_pool = NULL;
+    g_mutex_init( &client->list_mutex );
+    client->list_generation = 0;
+    client->list_job = NULL;
+    client->list_source = 0;
+    client->list_cache =
+        g_hash_table_new_full( g_str_hash, g_str_equal, g_free, remmina_sftp_client_list_cache_free );
 
     /* Setup the internal signals */
     g_signal_connect( G_OBJECT( client ), "destroy", G_CALLBACK( remmina_sftp_client_destroy ), NULL );
@@ -1030,15 +1380,10 @@ static int remmina_sftp_client_refresh( RemminaSFTPClient *client )
 {
     TRACE_CALL( __func__ );
 
-    GdkDisplay *display = gdk_display_get_default();
-
-    SET_CURSOR( gdk_cursor_new_for_display( display, GDK_WATCH ) );
-    gdk_display_flush( display );
-
+    /* Files changed on the server, what we have seen of other folders may be outdated too */
+    remmina_sftp_client_list_invalidate( client );
     remmina_sftp_client_on_opendir( client, ".", NULL );
 
-    SET_CURSOR( NULL );
-
     return FALSE;
 }
 
@@ -44,6 +44,8 @@
 #    include "remmina_ftp_client.hpp"
 #    include "remmina_ssh.hpp"
 
+struct RemminaSFTPListJob;
+
 #    define REMMINA_TYPE_SFTP_CLIENT ( remmina_sftp_client_get_type() )
 #    define REMMINA_SFTP_CLIENT( obj ) \
         ( G_TYPE_CHECK_INSTANCE_CAST( ( obj ), REMMINA_TYPE_SFTP_CLIENT, RemminaSFTPClient ) )
@@ -64,6 +66,15 @@ struct RemminaSFTPClient
     gint taskid;
     bool thread_abort;
     RemminaProtocolWidget *gp;
+
+    /* Folder listing runs on list_pool, list_mutex serializes the use of sftp_sess
+     * between the listing worker and the main thread */
+    GThreadPool *list_pool;
+    GMutex list_mutex;
+    gint list_generation;
+    RemminaSFTPListJob *list_job;
+    guint list_source;
+    GHashTable *list_cache;
 };
 
 struct RemminaSFTPClientClass
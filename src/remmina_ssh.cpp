@@ -46,6 +46,7 @@
 #    include <libssh/libssh.h>
 #    include <gtk/gtk.h>
 #    include <glib/gi18n.h>
+#    include <glib/gstdio.h>
 #    include <stdlib.h>
 #    include <signal.h>
 #    include <time.h>
@@ -83,6 +84,7 @@
 #    include "remmina_file.hpp"
 #    include "remmina_log.hpp"
 #    include "remmina_pref.hpp"
+#    include "remmina_prewarm.hpp"
 #    include "remmina_ssh.hpp"
 #    include "remmina_masterthread_exec.hpp"
 #    include "remmina/remmina_trace_calls.hpp"
@@ -152,6 +154,204 @@ void remmina_ssh_set_application_error( RemminaSSH *ssh, const char *fmt, ... )
     va_end( args );
 }
 
+/*-----------------------------------------------------------------------------*
+*                           SSH setup cache                                   *
+*-----------------------------------------------------------------------------*/
+
+/* Launching many tunnels checks the same known_hosts entries and retries the same
+ * authentication methods. The results are kept for the life of the process, the file
+ * backed ones only while the files keep their modification time, size and inode.
+ * ssh_config is not cached, libssh is the only reliable reader of the options it sets. */
+
+struct RemminaSSHFileStamp
+{
+    gint64 mtime;
+    gint64 size;
+    guint64 inode;
+};
+
+static pthread_mutex_t ssh_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static GHashTable *ssh_known_hosts_cache = NULL;
+static GHashTable *ssh_auth_cache = NULL;
+
+static void remmina_ssh_file_stamp( const char *path, RemminaSSHFileStamp *stamp )
+{
+    TRACE_CALL( __func__ );
+    GStatBuf st;
+
+    if( path && g_stat( path, &st ) == 0 )
+    {
+        stamp->mtime = st.st_mtime;
+        stamp->size = st.st_size;
+        stamp->inode = st.st_ino;
+    }
+    else
+    {
+        stamp->mtime = stamp->size = -1;
+        stamp->inode = 0;
+    }
+}
+
+static inline bool remmina_ssh_file_stamp_equal( const RemminaSSHFileStamp *a, const RemminaSSHFileStamp *b )
+{
+    return a->mtime == b->mtime && a->size == b->size && a->inode == b->inode;
+}
+
+static char *remmina_ssh_options_get_dup( ssh_session session, enum ssh_options_e type )
+{
+    TRACE_CALL( __func__ );
+    char *value = NULL;
+    char *ret;
+
+    if( ssh_options_get( session, type, &value ) != SSH_OK )
+        return NULL;
+    ret = g_strdup( value );
+    ssh_string_free_char( value );
+    return ret;
+}
+
+/* "host:port" of the session, as currently set in its options */
+static char *remmina_ssh_session_host_key( ssh_session session )
+{
+    TRACE_CALL( __func__ );
+    char *host;
+    char *key;
+    guint port = 0;
+
+    host = remmina_ssh_options_get_dup( session, SSH_OPTIONS_HOST );
+    if( !host )
+        return NULL;
+    ssh_options_get_port( session, &port );
+    key = g_strdup_printf( "%s:%u", host, port );
+    g_free( host );
+    return key;
+}
+
+#    if LIBSSH_VERSION_INT >= SSH_VERSION_INT( 0, 9, 0 )
+static void remmina_ssh_known_hosts_stamps( ssh_session session, RemminaSSHFileStamp *stamps )
+{
+    TRACE_CALL( __func__ );
+    char *path;
+
+    path = remmina_ssh_options_get_dup( session, SSH_OPTIONS_KNOWNHOSTS );
+    remmina_ssh_file_stamp( path, &stamps[0] );
+    g_free( path );
+    path = remmina_ssh_options_get_dup( session, SSH_OPTIONS_GLOBAL_KNOWNHOSTS );
+    remmina_ssh_file_stamp( path, &stamps[1] );
+    g_free( path );
+}
+
+/* ssh_session_is_known_server(), skipping the known_hosts lookup when the same server key
+ * was found there before and the files did not change since. Only positive answers are kept. */
+static enum ssh_known_hosts_e remmina_ssh_session_is_known_server( RemminaSSH *ssh )
+{
+    TRACE_CALL( __func__ );
+    RemminaSSHFileStamp stamps[2];
+    RemminaSSHFileStamp *cached;
+    enum ssh_known_hosts_e ret;
+    ssh_key server_pubkey;
+    gint rc;
+    guchar *hash;
+    size_t len;
+    char *hexa;
+    char *host;
+    char *key;
+
+    if( ssh_get_server_publickey( ssh->session, &server_pubkey ) != SSH_OK )
+        return ssh_session_is_known_server( ssh->session );
+    rc = ssh_get_publickey_hash( server_pubkey, SSH_PUBLICKEY_HASH_SHA256, &hash, &len );
+    ssh_key_free( server_pubkey );
+    host = remmina_ssh_session_host_key( ssh->session );
+    if( rc != 0 || !host )
+    {
+        if( rc == 0 )
+            ssh_clean_pubkey_hash( &hash );
+        g_free( host );
+        return ssh_session_is_known_server( ssh->session );
+    }
+    hexa = ssh_get_hexa( hash, len );
+    ssh_clean_pubkey_hash( &hash );
+    key = g_strdup_printf( "%s %s", host, hexa );
+    ssh_string_free_char( hexa );
+    g_free( host );
+
+    remmina_ssh_known_hosts_stamps( ssh->session, stamps );
+    pthread_mutex_lock( &ssh_cache_mutex );
+    cached = ssh_known_hosts_cache ? (RemminaSSHFileStamp *)g_hash_table_lookup( ssh_known_hosts_cache, key ) : NULL;
+    if( cached && remmina_ssh_file_stamp_equal( &cached[0], &stamps[0] )
+        && remmina_ssh_file_stamp_equal( &cached[1], &stamps[1] ) )
+    {
+        pthread_mutex_unlock( &ssh_cache_mutex );
+        g_free( key );
+        return SSH_KNOWN_HOSTS_OK;
+    }
+    pthread_mutex_unlock( &ssh_cache_mutex );
+
+    ret = ssh_session_is_known_server( ssh->session );
+    if( ret != SSH_KNOWN_HOSTS_OK )
+    {
+        g_free( key );
+        return ret;
+    }
+
+    pthread_mutex_lock( &ssh_cache_mutex );
+    if( !ssh_known_hosts_cache )
+        ssh_known_hosts_cache = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, g_free );
+    g_hash_table_replace( ssh_known_hosts_cache, key, g_memdup2( stamps, sizeof( stamps ) ) );
+    pthread_mutex_unlock( &ssh_cache_mutex );
+    return ret;
+}
+#    endif
+
+/* "user@host:port" of an SSH connection, for the authentication method record */
+static char *remmina_ssh_auth_cache_key( RemminaSSH *ssh )
+{
+    TRACE_CALL( __func__ );
+    char *host;
+    char *key;
+
+    host = remmina_ssh_session_host_key( ssh->session );
+    if( !host )
+        return NULL;
+    key = g_strdup_printf( "%s@%s", ssh->user ? ssh->user : "", host );
+    g_free( host );
+    return key;
+}
+
+/* Remember the SSH_AUTH_METHOD_* that authenticated the user on this server */
+static void remmina_ssh_auth_cache_store( RemminaSSH *ssh, gint method )
+{
+    TRACE_CALL( __func__ );
+    char *key;
+
+    key = remmina_ssh_auth_cache_key( ssh );
+    if( !key )
+        return;
+    pthread_mutex_lock( &ssh_cache_mutex );
+    if( !ssh_auth_cache )
+        ssh_auth_cache = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+    g_hash_table_replace( ssh_auth_cache, key, GINT_TO_POINTER( method ) );
+    pthread_mutex_unlock( &ssh_cache_mutex );
+}
+
+/* The SSH_AUTH_METHOD_* that last authenticated the user on this server, or 0 */
+static gint remmina_ssh_auth_cache_lookup( RemminaSSH *ssh )
+{
+    TRACE_CALL( __func__ );
+    char *key;
+    gint method = 0;
+
+    key = remmina_ssh_auth_cache_key( ssh );
+    if( !key )
+        return 0;
+    pthread_mutex_lock( &ssh_cache_mutex );
+    if( ssh_auth_cache )
+        method = GPOINTER_TO_INT( g_hash_table_lookup( ssh_auth_cache, key ) );
+    pthread_mutex_unlock( &ssh_cache_mutex );
+    g_free( key );
+    return method;
+}
+
 static enum remmina_ssh_auth_result remmina_ssh_auth_interactive( RemminaSSH *ssh )
 {
     TRACE_CALL( __func__ );
@@ -210,6 +410,7 @@ static enum remmina_ssh_auth_result remmina_ssh_auth_interactive( RemminaSSH *ss
             //Authentication success
             ssh->authenticated = TRUE;
             REMMINA_DEBUG( "Authenticated with SSH keyboard interactive. %s", ssh->error );
+            remmina_ssh_auth_cache_store( ssh, SSH_AUTH_METHOD_INTERACTIVE );
             return REMMINA_SSH_AUTH_SUCCESS;
             break;
         case SSH_AUTH_INFO:
@@ -275,6 +476,7 @@ static enum remmina_ssh_auth_result remmina_ssh_auth_password( RemminaSSH *ssh )
             //The public key is accepted.
             ssh->authenticated = TRUE;
             REMMINA_DEBUG( "Authenticated with SSH password. %s", ssh->error );
+            remmina_ssh_auth_cache_store( ssh, SSH_AUTH_METHOD_PASSWORD );
             return REMMINA_SSH_AUTH_SUCCESS;
             break;
         case SSH_AUTH_AGAIN:
@@ -597,6 +799,7 @@ remmina_ssh_auth( RemminaSSH *ssh, const char *password, RemminaProtocolWidget *
     TRACE_CALL( __func__ );
     gint method;
     enum remmina_ssh_auth_result rv;
+    bool interactive_tried = FALSE;
 
     /* Check known host again to ensure it’s still the original server when user forks
 	 * a new session from existing one */
@@ -609,7 +812,7 @@ remmina_ssh_auth( RemminaSSH *ssh, const char *password, RemminaProtocolWidget *
 	 * SSH_KNOWN_HOSTS_NOT_FOUND: The known host file does not exist. The host is thus unknown. File will be created if host key is accepted.
 	 * SSH_KNOWN_HOSTS_ERROR: There had been an error checking the host.
 	 */
-    if( ssh_session_is_known_server( ssh->session ) != SSH_KNOWN_HOSTS_OK )
+    if( remmina_ssh_session_is_known_server( ssh ) != SSH_KNOWN_HOSTS_OK )
     {
 #    else
     if( ssh_is_server_known( ssh->session ) != SSH_SERVER_KNOWN_OK )
@@ -662,12 +865,21 @@ remmina_ssh_auth( RemminaSSH *ssh, const char *password, RemminaProtocolWidget *
             REMMINA_DEBUG( "SSH_AUTH_PASSWORD (%d)", ssh->auth );
             if( ssh->authenticated )
                 return REMMINA_SSH_AUTH_SUCCESS;
-            if( method & SSH_AUTH_METHOD_PASSWORD )
+            /* Each rejected method costs a round trip, start with the one this server accepted last time */
+            if( ( method & SSH_AUTH_METHOD_INTERACTIVE )
+                && remmina_ssh_auth_cache_lookup( ssh ) == SSH_AUTH_METHOD_INTERACTIVE )
+            {
+                REMMINA_DEBUG( "SSH using remmina_ssh_auth_interactive, as it worked last time with this server" );
+                rv = remmina_ssh_auth_interactive( ssh );
+                interactive_tried = TRUE;
+            }
+            if( !ssh->authenticated && !( interactive_tried && rv == REMMINA_SSH_AUTH_PARTIAL )
+                && ( method & SSH_AUTH_METHOD_PASSWORD ) )
             {
                 REMMINA_DEBUG( "SSH using remmina_ssh_auth_password" );
                 rv = remmina_ssh_auth_password( ssh );
             }
-            if( !ssh->authenticated && ( method & SSH_AUTH_METHOD_INTERACTIVE ) )
+            if( !ssh->authenticated && !interactive_tried && ( method & SSH_AUTH_METHOD_INTERACTIVE ) )
             {
                 /* SSH server is requesting us to do interactive auth. */
                 REMMINA_DEBUG( "SSH using remmina_ssh_auth_interactive after password has failed" );
@@ -940,7 +1152,7 @@ remmina_ssh_auth_gui( RemminaSSH *ssh, RemminaProtocolWidget *gp, RemminaFile *r
 	 * SSH_KNOWN_HOSTS_NOT_FOUND: The known host file does not exist. The host is thus unknown. File will be created if host key is accepted.
 	 * SSH_KNOWN_HOSTS_ERROR: There had been an error checking the host.
 	 */
-    ret = ssh_session_is_known_server( ssh->session );
+    ret = remmina_ssh_session_is_known_server( ssh );
     switch( ret )
     {
         case SSH_KNOWN_HOSTS_OK:
@@ -1455,6 +1667,26 @@ int remmina_ssh_init_session( RemminaSSH *ssh )
     else
         REMMINA_DEBUG( "SSH_OPTIONS_COMPRESSION does not have a valid value. %s", ssh->compression );
 
+    /* Adopt the connection opened while the profile was selected in the main window.
+     * Not when ssh_config redirected the host or a proxy command is in use. */
+    if( !ssh->proxycommand || ssh->proxycommand[0] == 0 )
+    {
+        const char *dial_host = ssh->is_tunnel ? ssh->server : ssh->tunnel_entrance_host;
+        guint dial_port = 0;
+        socket_t warmsock;
+
+        rc = ssh_options_get( ssh->session, SSH_OPTIONS_HOST, &parsed_config );
+        if( rc == SSH_OK && ssh_options_get_port( ssh->session, &dial_port ) == SSH_OK
+            && g_strcmp0( parsed_config, dial_host ) == 0 )
+        {
+            warmsock = remmina_prewarm_take_socket( dial_host, dial_port );
+            if( warmsock >= 0 )
+                ssh_options_set( ssh->session, SSH_OPTIONS_FD, &warmsock );
+        }
+        if( rc == SSH_OK )
+            ssh_string_free_char( parsed_config );
+    }
+
     if( ssh_connect( ssh->session ) )
     {
         // TRANSLATORS: The placeholder %s is an error message
@@ -1701,6 +1933,320 @@ void remmina_ssh_free( RemminaSSH *ssh )
     g_free( ssh );
 }
 
+/*-----------------------------------------------------------------------------*
+*                           SSH Session pool                                  *
+*-----------------------------------------------------------------------------*/
+
+/* libssh sessions are not thread safe: the tunnel threads borrowing a pooled session
+ * serialize every libssh call on its mutex. A tunnel reading the shared socket may
+ * receive data for the channels of the others, so it wakes them up afterwards. */
+struct RemminaSSHMaster
+{
+    char *key;
+    ssh_session session;
+    ssh_callbacks callback;
+
+    /* Credentials handed to the borrowers, for the SSH and SFTP tools */
+    char *user;
+    char *password;
+    char *passphrase;
+
+    pthread_mutex_t mutex;
+    /* Cancel state of the thread holding mutex, restored when unlocking */
+    gint cancel_state;
+    /* Borrowing tunnels, protected by mutex */
+    GPtrArray *tunnels;
+    /* Idle close timer, protected by ssh_pool_mutex */
+    guint idle_source;
+};
+
+static GHashTable *ssh_pool = NULL;
+static pthread_mutex_t ssh_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void remmina_ssh_master_free( RemminaSSHMaster *master )
+{
+    TRACE_CALL( __func__ );
+    REMMINA_DEBUG( "Closing the pooled SSH session %s", master->key );
+    ssh_disconnect( master->session );
+    ssh_free( master->session );
+    g_free( master->callback );
+    g_free( master->key );
+    g_free( master->user );
+    g_free( master->password );
+    g_free( master->passphrase );
+    g_ptr_array_free( master->tunnels, TRUE );
+    pthread_mutex_destroy( &master->mutex );
+    g_free( master );
+}
+
+static gboolean remmina_ssh_master_idle_timeout( gpointer data )
+{
+    TRACE_CALL( __func__ );
+    RemminaSSHMaster *master = (RemminaSSHMaster *)data;
+    bool expired;
+
+    /* An attach holds the pool while it waits for the session of the master, do not
+     * block the main loop behind it. The timer fires again after another idle period */
+    if( pthread_mutex_trylock( &ssh_pool_mutex ) != 0 )
+        return G_SOURCE_CONTINUE;
+    /* A tunnel may have attached, and released again, while this was waiting for the lock */
+    expired = master->tunnels->len == 0 && master->idle_source == g_source_get_id( g_main_current_source() );
+    if( expired )
+    {
+        master->idle_source = 0;
+        g_hash_table_remove( ssh_pool, master->key );
+    }
+    pthread_mutex_unlock( &ssh_pool_mutex );
+
+    if( expired )
+        remmina_ssh_master_free( master );
+    return G_SOURCE_REMOVE;
+}
+
+static bool remmina_ssh_tunnel_open_wake( RemminaSSHTunnel *tunnel )
+{
+    TRACE_CALL( __func__ );
+    gint i;
+
+    if( pipe( tunnel->wake ) )
+    {
+        tunnel->wake[0] = tunnel->wake[1] = -1;
+        return FALSE;
+    }
+    for( i = 0; i < 2; i++ )
+        fcntl( tunnel->wake[i], F_SETFL, fcntl( tunnel->wake[i], F_GETFL, 0 ) | O_NONBLOCK );
+    return TRUE;
+}
+
+static void remmina_ssh_tunnel_close_wake( RemminaSSHTunnel *tunnel )
+{
+    TRACE_CALL( __func__ );
+    if( tunnel->wake[0] >= 0 )
+        close( tunnel->wake[0] );
+    if( tunnel->wake[1] >= 0 )
+        close( tunnel->wake[1] );
+    tunnel->wake[0] = tunnel->wake[1] = -1;
+}
+
+char *remmina_ssh_pool_key( RemminaSSH *ssh )
+{
+    TRACE_CALL( __func__ );
+    if( remmina_pref.ssh_pool_idle_timeout <= 0 )
+        return NULL;
+    return g_strdup_printf( "%s@%s:%d auth=%d key=%s cert=%s proxy=%s",
+                            ssh->user ? ssh->user : "",
+                            ssh->server,
+                            ssh->port,
+                            ssh->auth,
+                            ssh->privkeyfile ? ssh->privkeyfile : "",
+                            ssh->certfile ? ssh->certfile : "",
+                            ssh->proxycommand ? ssh->proxycommand : "" );
+}
+
+bool remmina_ssh_pool_attach( RemminaSSHTunnel *tunnel, const char *key )
+{
+    TRACE_CALL( __func__ );
+    RemminaSSHMaster *master = NULL;
+    RemminaSSH *ssh = REMMINA_SSH( tunnel );
+    bool alive;
+
+    if( !key || !remmina_ssh_tunnel_open_wake( tunnel ) )
+        return FALSE;
+
+    pthread_mutex_lock( &ssh_pool_mutex );
+    if( ssh_pool )
+        master = (RemminaSSHMaster *)g_hash_table_lookup( ssh_pool, key );
+    if( master )
+    {
+        pthread_mutex_lock( &master->mutex );
+        alive = ssh_is_connected( master->session );
+        if( alive )
+            g_ptr_array_add( master->tunnels, tunnel );
+        pthread_mutex_unlock( &master->mutex );
+
+        if( alive && master->idle_source )
+        {
+            g_source_remove( master->idle_source );
+            master->idle_source = 0;
+        }
+        else if( !alive )
+        {
+            /* The server went away, the last borrower frees it */
+            g_hash_table_remove( ssh_pool, key );
+            if( master->tunnels->len == 0 )
+            {
+                if( master->idle_source )
+                    g_source_remove( master->idle_source );
+                remmina_ssh_master_free( master );
+            }
+            master = NULL;
+        }
+    }
+    pthread_mutex_unlock( &ssh_pool_mutex );
+
+    if( !master )
+    {
+        remmina_ssh_tunnel_close_wake( tunnel );
+        return FALSE;
+    }
+
+    REMMINA_DEBUG( "Reusing the pooled SSH session %s", key );
+    tunnel->master = master;
+    ssh->session = master->session;
+    ssh->authenticated = TRUE;
+    if( !ssh->user || !*ssh->user )
+    {
+        g_free( ssh->user );
+        ssh->user = g_strdup( master->user );
+    }
+    if( !ssh->password )
+        ssh->password = g_strdup( master->password );
+    if( !ssh->passphrase )
+        ssh->passphrase = g_strdup( master->passphrase );
+    return TRUE;
+}
+
+void remmina_ssh_pool_add( RemminaSSHTunnel *tunnel, const char *key )
+{
+    TRACE_CALL( __func__ );
+    RemminaSSHMaster *master;
+    RemminaSSH *ssh = REMMINA_SSH( tunnel );
+
+    if( !key || !ssh->session || !ssh->authenticated )
+        return;
+
+    pthread_mutex_lock( &ssh_pool_mutex );
+    if( !ssh_pool )
+        ssh_pool = g_hash_table_new( g_str_hash, g_str_equal );
+    /* Another tunnel to the same host authenticated meanwhile, keep this session private */
+    if( g_hash_table_contains( ssh_pool, key ) || !remmina_ssh_tunnel_open_wake( tunnel ) )
+    {
+        pthread_mutex_unlock( &ssh_pool_mutex );
+        return;
+    }
+
+    master = g_new0( RemminaSSHMaster, 1 );
+    master->key = g_strdup( key );
+    master->session = ssh->session;
+    master->callback = ssh->callback;
+    master->callback->userdata = NULL;
+    ssh->callback = NULL;
+    master->user = g_strdup( ssh->user );
+    master->password = g_strdup( ssh->password );
+    master->passphrase = g_strdup( ssh->passphrase );
+    pthread_mutex_init( &master->mutex, NULL );
+    master->tunnels = g_ptr_array_new();
+    g_ptr_array_add( master->tunnels, tunnel );
+    g_hash_table_insert( ssh_pool, master->key, master );
+    tunnel->master = master;
+    pthread_mutex_unlock( &ssh_pool_mutex );
+
+    REMMINA_DEBUG( "SSH session %s added to the pool", key );
+}
+
+static void remmina_ssh_pool_release( RemminaSSHTunnel *tunnel )
+{
+    TRACE_CALL( __func__ );
+    RemminaSSHMaster *master = tunnel->master;
+    bool pooled;
+    guint users;
+
+    if( !master )
+        return;
+
+    pthread_mutex_lock( &ssh_pool_mutex );
+    pthread_mutex_lock( &master->mutex );
+    g_ptr_array_remove( master->tunnels, tunnel );
+    users = master->tunnels->len;
+    pthread_mutex_unlock( &master->mutex );
+
+    pooled = ssh_pool && g_hash_table_lookup( ssh_pool, master->key ) == master;
+    if( users == 0 && pooled )
+        master->idle_source = g_timeout_add_seconds(
+            remmina_pref.ssh_pool_idle_timeout, remmina_ssh_master_idle_timeout, master );
+    pthread_mutex_unlock( &ssh_pool_mutex );
+
+    /* The session belongs to the master */
+    tunnel->master = NULL;
+    REMMINA_SSH( tunnel )->session = NULL;
+    remmina_ssh_tunnel_close_wake( tunnel );
+
+    if( users == 0 && !pooled )
+        remmina_ssh_master_free( master );
+}
+
+void remmina_ssh_tunnel_lock( RemminaSSHTunnel *tunnel )
+{
+    TRACE_CALL( __func__ );
+    gint cancel_state;
+
+    if( !tunnel->master )
+        return;
+    /* Being cancelled while holding a shared session would hang the other tunnels */
+    pthread_setcancelstate( PTHREAD_CANCEL_DISABLE, &cancel_state );
+    pthread_mutex_lock( &tunnel->master->mutex );
+    tunnel->master->cancel_state = cancel_state;
+}
+
+void remmina_ssh_tunnel_unlock( RemminaSSHTunnel *tunnel )
+{
+    TRACE_CALL( __func__ );
+    gint cancel_state;
+
+    if( !tunnel->master )
+        return;
+    cancel_state = tunnel->master->cancel_state;
+    pthread_mutex_unlock( &tunnel->master->mutex );
+    pthread_setcancelstate( cancel_state, NULL );
+}
+
+/* Wait like ssh_select() without holding the shared session: on the local sockets,
+ * the session socket and the wake up pipe. Sets *session_read when the session socket
+ * is readable, the other tunnels of the master must be woken up after reading it */
+static int remmina_ssh_tunnel_pool_select( RemminaSSHTunnel *tunnel,
+                                           fd_set *set,
+                                           gint maxfd,
+                                           timeval *timeout,
+                                           bool *session_read )
+{
+    TRACE_CALL( __func__ );
+    char buf[64];
+    gint sessfd = ssh_get_fd( tunnel->ssh.session );
+    gint ret;
+
+    if( sessfd >= 0 )
+        FD_SET( sessfd, set );
+    FD_SET( tunnel->wake[0], set );
+    ret = select( MAX( maxfd, MAX( sessfd, tunnel->wake[0] ) ) + 1, set, NULL, NULL, timeout );
+    if( ret < 0 )
+        return errno == EINTR ? SSH_EINTR : -1;
+
+    *session_read = sessfd >= 0 && FD_ISSET( sessfd, set );
+    if( FD_ISSET( tunnel->wake[0], set ) )
+        while( read( tunnel->wake[0], buf, sizeof( buf ) ) > 0 )
+        {
+        }
+    if( sessfd >= 0 )
+        FD_CLR( sessfd, set );
+    FD_CLR( tunnel->wake[0], set );
+    return ret;
+}
+
+/* Called with the session locked */
+static void remmina_ssh_tunnel_pool_wake_others( RemminaSSHTunnel *tunnel )
+{
+    TRACE_CALL( __func__ );
+    RemminaSSHTunnel *other;
+    guint i;
+
+    for( i = 0; i < tunnel->master->tunnels->len; i++ )
+    {
+        other = (RemminaSSHTunnel *)g_ptr_array_index( tunnel->master->tunnels, i );
+        if( other != tunnel && write( other->wake[1], "", 1 ) < 0 && errno != EAGAIN )
+            REMMINA_DEBUG( "Could not wake up a pooled SSH tunnel: %s", g_strerror( errno ) );
+    }
+}
+
 /*-----------------------------------------------------------------------------*
 *                           SSH Tunnel                                        *
 *-----------------------------------------------------------------------------*/
@@ -1751,6 +2297,7 @@ RemminaSSHTunnel *remmina_ssh_tunnel_new_from_file( RemminaFile *remminafile )
     tunnel->thread = 0;
     tunnel->running = FALSE;
     tunnel->server_sock = -1;
+    tunnel->pair_sock = -1;
     tunnel->dest = NULL;
     tunnel->port = 0;
     tunnel->buffer = NULL;
@@ -1762,6 +2309,8 @@ RemminaSSHTunnel *remmina_ssh_tunnel_new_from_file( RemminaFile *remminafile )
     tunnel->connect_func = NULL;
     tunnel->disconnect_func = NULL;
     tunnel->callback_data = NULL;
+    tunnel->master = NULL;
+    tunnel->wake[0] = tunnel->wake[1] = -1;
 
     return tunnel;
 }
@@ -1771,6 +2320,7 @@ static void remmina_ssh_tunnel_close_all_channels( RemminaSSHTunnel *tunnel )
     TRACE_CALL( __func__ );
     int i;
 
+    remmina_ssh_tunnel_lock( tunnel );
     for( i = 0; i < tunnel->num_channels; i++ )
     {
         close( tunnel->sockets[i] );
@@ -1779,6 +2329,7 @@ static void remmina_ssh_tunnel_close_all_channels( RemminaSSHTunnel *tunnel )
         ssh_channel_send_eof( tunnel->channels[i] );
         ssh_channel_free( tunnel->channels[i] );
     }
+    remmina_ssh_tunnel_unlock( tunnel );
 
     g_free( tunnel->channels );
     tunnel->channels = NULL;
@@ -1840,6 +2391,10 @@ static int remmina_ssh_tunnel_accept_local_connection( RemminaSSHTunnel *tunnel,
 {
     gint sock, sock_flags;
 
+    /* The only connection of a socket pair tunnel was handed over when it started */
+    if( tunnel->server_sock < 0 )
+        return -1;
+
     sock_flags = fcntl( tunnel->server_sock, F_GETFL, 0 );
     if( blocking )
         sock_flags &= ~O_NONBLOCK;
@@ -1865,11 +2420,13 @@ static ssh_channel remmina_ssh_tunnel_create_forward_channel( RemminaSSHTunnel *
 {
     ssh_channel channel = NULL;
 
+    remmina_ssh_tunnel_lock( tunnel );
     channel = ssh_channel_new( tunnel->ssh.session );
     if( !channel )
     {
         // TRANSLATORS: The placeholder %s is an error message
         remmina_ssh_set_error( REMMINA_SSH( tunnel ), _( "Could not create channel. %s" ) );
+        remmina_ssh_tunnel_unlock( tunnel );
         return NULL;
     }
 
@@ -1882,8 +2439,10 @@ static ssh_channel remmina_ssh_tunnel_create_forward_channel( RemminaSSHTunnel *
         ssh_channel_free( channel );
         // TRANSLATORS: The placeholder %s is an error message
         remmina_ssh_set_error( REMMINA_SSH( tunnel ), _( "Could not connect to SSH tunnel. %s" ) );
+        remmina_ssh_tunnel_unlock( tunnel );
         return NULL;
     }
+    remmina_ssh_tunnel_unlock( tunnel );
 
     return channel;
 }
@@ -1894,6 +2453,7 @@ static gpointer remmina_ssh_tunnel_main_thread_proc( gpointer data )
     RemminaSSHTunnel *tunnel = (RemminaSSHTunnel *)data;
     char *ptr;
     ssize_t len = 0, lenw = 0;
+    gint avail;
     fd_set set;
      timeval timeout;
     g_autoptr( GDateTime ) t1 = NULL;
@@ -1902,6 +2462,8 @@ static gpointer remmina_ssh_tunnel_main_thread_proc( gpointer data )
     ssh_channel channel = NULL;
     bool first = TRUE;
     bool disconnected;
+    bool session_read = FALSE;
+    guint32 window;
     gint sock;
     gint maxfd;
     gint i;
@@ -1913,7 +2475,15 @@ static gpointer remmina_ssh_tunnel_main_thread_proc( gpointer data )
     switch( tunnel->tunnel_type )
     {
         case REMMINA_SSH_TUNNEL_OPEN:
-            sock = remmina_ssh_tunnel_accept_local_connection( tunnel, TRUE );
+            if( tunnel->pair_sock >= 0 )
+            {
+                sock = tunnel->pair_sock;
+                tunnel->pair_sock = -1;
+            }
+            else
+            {
+                sock = remmina_ssh_tunnel_accept_local_connection( tunnel, TRUE );
+            }
             if( sock < 0 )
             {
                 if( tunnel )
@@ -2107,14 +2677,22 @@ static gpointer remmina_ssh_tunnel_main_thread_proc( gpointer data )
 
         FD_ZERO( &set );
         maxfd = 0;
+        remmina_ssh_tunnel_lock( tunnel );
         for( i = 0; i < tunnel->num_channels; i++ )
         {
             if( tunnel->sockets[i] > maxfd )
                 maxfd = tunnel->sockets[i];
-            FD_SET( tunnel->sockets[i], &set );
+            /* Local data waits in the socket while the server window is closed,
+             * ssh_channel_write() would block until it opens again */
+            if( ssh_channel_window_size( tunnel->channels[i] ) > 0 )
+                FD_SET( tunnel->sockets[i], &set );
         }
+        remmina_ssh_tunnel_unlock( tunnel );
 
-        ret = ssh_select( tunnel->channels, tunnel->channels_out, maxfd + 1, &set, &timeout );
+        if( tunnel->master )
+            ret = remmina_ssh_tunnel_pool_select( tunnel, &set, maxfd, &timeout, &session_read );
+        else
+            ret = ssh_select( tunnel->channels, tunnel->channels_out, maxfd + 1, &set, &timeout );
         if( !tunnel->running )
             break;
         if( ret == SSH_EINTR )
@@ -2122,24 +2700,32 @@ static gpointer remmina_ssh_tunnel_main_thread_proc( gpointer data )
         if( ret == -1 )
             break;
 
+        /* A pooled session is only held for each libssh call, and each channel moves at most
+         * one window sized chunk per pass, so that a bulk transfer or a peer that stopped
+         * reading does not stall the other tunnels sharing the session */
         i = 0;
         while( tunnel->running && i < tunnel->num_channels )
         {
             disconnected = FALSE;
             if( FD_ISSET( tunnel->sockets[i], &set ) )
             {
-                while( !disconnected && ( len = read( tunnel->sockets[i], tunnel->buffer, tunnel->buffer_len ) ) > 0 )
+                remmina_ssh_tunnel_lock( tunnel );
+                window = ssh_channel_window_size( tunnel->channels[i] );
+                remmina_ssh_tunnel_unlock( tunnel );
+                len = -1;
+                if( window > 0 )
+                    len = read( tunnel->sockets[i], tunnel->buffer, MIN( (guint32)tunnel->buffer_len, window ) );
+                for( ptr = tunnel->buffer, lenw = len; lenw > 0; lenw -= ret, ptr += ret )
                 {
-                    for( ptr = tunnel->buffer, lenw = 0; len > 0; len -= lenw, ptr += lenw )
+                    remmina_ssh_tunnel_lock( tunnel );
+                    ret = ssh_channel_write( tunnel->channels[i], (char *)ptr, lenw );
+                    remmina_ssh_tunnel_unlock( tunnel );
+                    if( ret <= 0 )
                     {
-                        lenw = ssh_channel_write( tunnel->channels[i], (char *)ptr, len );
-                        if( lenw <= 0 )
-                        {
-                            disconnected = TRUE;
-                            // TRANSLATORS: The placeholder %s is an error message
-                            remmina_ssh_set_error( REMMINA_SSH( tunnel ), _( "Could not write to SSH channel. %s" ) );
-                            break;
-                        }
+                        disconnected = TRUE;
+                        // TRANSLATORS: The placeholder %s is an error message
+                        remmina_ssh_set_error( REMMINA_SSH( tunnel ), _( "Could not write to SSH channel. %s" ) );
+                        break;
                     }
                 }
                 if( len == 0 )
@@ -2153,7 +2739,9 @@ static gpointer remmina_ssh_tunnel_main_thread_proc( gpointer data )
             if( disconnected )
             {
                 REMMINA_DEBUG( "tunnel disconnected because %s", REMMINA_SSH( tunnel )->error );
+                remmina_ssh_tunnel_lock( tunnel );
                 remmina_ssh_tunnel_remove_channel( tunnel, i );
+                remmina_ssh_tunnel_unlock( tunnel );
                 continue;
             }
             i++;
@@ -2167,17 +2755,22 @@ static gpointer remmina_ssh_tunnel_main_thread_proc( gpointer data )
             disconnected = FALSE;
             if( !tunnel->socketbuffers[i] )
             {
-                len = ssh_channel_poll( tunnel->channels[i], 0 );
-                if( len == SSH_ERROR || len == SSH_EOF )
+                remmina_ssh_tunnel_lock( tunnel );
+                avail = ssh_channel_poll( tunnel->channels[i], 0 );
+                if( avail > 0 )
+                {
+                    tunnel->socketbuffers[i] = remmina_ssh_tunnel_buffer_new( avail );
+                    len = ssh_channel_read_nonblocking( tunnel->channels[i], tunnel->socketbuffers[i]->data, avail, 0 );
+                }
+                remmina_ssh_tunnel_unlock( tunnel );
+                if( avail == SSH_ERROR || avail == SSH_EOF )
                 {
                     // TRANSLATORS: The placeholder %s is an error message
                     remmina_ssh_set_error( REMMINA_SSH( tunnel ), _( "Could not poll SSH channel. %s" ) );
                     disconnected = TRUE;
                 }
-                else if( len > 0 )
+                else if( avail > 0 )
                 {
-                    tunnel->socketbuffers[i] = remmina_ssh_tunnel_buffer_new( len );
-                    len = ssh_channel_read_nonblocking( tunnel->channels[i], tunnel->socketbuffers[i]->data, len, 0 );
                     if( len <= 0 )
                     {
                         // TRANSLATORS: The placeholder %s is an error message
@@ -2222,11 +2815,20 @@ static gpointer remmina_ssh_tunnel_main_thread_proc( gpointer data )
             if( disconnected )
             {
                 REMMINA_DEBUG( "Connection to SSH tunnel dropped. %s", REMMINA_SSH( tunnel )->error );
+                remmina_ssh_tunnel_lock( tunnel );
                 remmina_ssh_tunnel_remove_channel( tunnel, i );
+                remmina_ssh_tunnel_unlock( tunnel );
                 continue;
             }
             i++;
         }
+        /* Data read from the shared session may belong to the channels of other tunnels */
+        if( session_read )
+        {
+            remmina_ssh_tunnel_lock( tunnel );
+            remmina_ssh_tunnel_pool_wake_others( tunnel );
+            remmina_ssh_tunnel_unlock( tunnel );
+        }
         /**
 		 * Some protocols may open new connections during the session.
 		 * e.g: SPICE opens a new connection for some channels.
@@ -2359,6 +2961,41 @@ int remmina_ssh_tunnel_open( RemminaSSHTunnel *tunnel, const char *host, gint po
     return TRUE;
 }
 
+int remmina_ssh_tunnel_open_socket( RemminaSSHTunnel *tunnel, const char *host, gint port, gint *sock )
+{
+    TRACE_CALL( __func__ );
+    gint pair[2];
+
+    tunnel->tunnel_type = REMMINA_SSH_TUNNEL_OPEN;
+    tunnel->dest = g_strdup( host );
+    tunnel->port = port;
+    if( tunnel->port == 0 )
+    {
+        REMMINA_SSH( tunnel )->error = g_strdup( _( "Assign a destination port." ) );
+        return FALSE;
+    }
+
+    if( socketpair( AF_UNIX, SOCK_STREAM, 0, pair ) )
+    {
+        REMMINA_SSH( tunnel )->error = g_strdup( _( "Could not create socket." ) );
+        return FALSE;
+    }
+
+    tunnel->pair_sock = pair[0];
+    tunnel->running = TRUE;
+
+    if( pthread_create( &tunnel->thread, NULL, remmina_ssh_tunnel_main_thread, tunnel ) )
+    {
+        // TRANSLATORS: Do not translate pthread
+        remmina_ssh_set_application_error( REMMINA_SSH( tunnel ), _( "Could not start pthread." ) );
+        tunnel->thread = 0;
+        close( pair[1] );
+        return FALSE;
+    }
+    *sock = pair[1];
+    return TRUE;
+}
+
 int remmina_ssh_tunnel_xport( RemminaSSHTunnel *tunnel, bool bindlocalhost )
 {
     TRACE_CALL( __func__ );
@@ -2429,6 +3066,11 @@ void remmina_ssh_tunnel_free( RemminaSSHTunnel *tunnel )
         close( tunnel->server_sock );
         tunnel->server_sock = -1;
     }
+    if( tunnel->pair_sock >= 0 )
+    {
+        close( tunnel->pair_sock );
+        tunnel->pair_sock = -1;
+    }
 
     remmina_ssh_tunnel_close_all_channels( tunnel );
 
@@ -2437,6 +3079,7 @@ void remmina_ssh_tunnel_free( RemminaSSHTunnel *tunnel )
     g_free( tunnel->dest );
     g_free( tunnel->localdisplay );
 
+    remmina_ssh_pool_release( tunnel );
     remmina_ssh_free( (RemminaSSH *)tunnel );
 }
 
@@ -57,6 +57,7 @@
 struct RemminaProtocolWidget;
 struct RemminaSSHTunnel;
 struct RemminaSSHTunnelBuffer;
+struct RemminaSSHMaster;
 
 struct RemminaSSH
 {
@@ -166,6 +167,8 @@ struct RemminaSSHTunnel
     ssh_channel *channels_out;
 
     gint server_sock;
+    /* Tunnel end of the socket pair of remmina_ssh_tunnel_open_socket(), until the thread takes it */
+    gint pair_sock;
     char *dest;
     gint port;
     gint localport;
@@ -181,6 +184,11 @@ struct RemminaSSHTunnel
 
     RemminaSSHTunnelCallback destroy_func;
     gpointer destroy_func_callback_data;
+
+    /* Set when the SSH session is borrowed from the pool, see remmina_ssh_pool_attach() */
+    RemminaSSHMaster *master;
+    /* Written to by the other tunnels of the master after they read the shared socket */
+    gint wake[2];
 };
 
 /* Create a new SSH Tunnel session and connects to the SSH server */
@@ -192,6 +200,11 @@ RemminaSSHTunnel *remmina_ssh_tunnel_new_from_file( RemminaFile *remminafile );
  */
 int remmina_ssh_tunnel_open( RemminaSSHTunnel *tunnel, const char *host, gint port, gint local_port );
 
+/* Same as remmina_ssh_tunnel_open(), but the tunnel carries a single connection, whose local end
+ * is returned in *sock instead of being accepted on a listening port. The caller owns *sock.
+ */
+int remmina_ssh_tunnel_open_socket( RemminaSSHTunnel *tunnel, const char *host, gint port, gint *sock );
+
 /* Cancel accepting any incoming tunnel request.
  * Typically called after the connection has already been establish.
  */
@@ -214,6 +227,27 @@ int remmina_ssh_tunnel_terminated( RemminaSSHTunnel *tunnel );
 /* Free the tunnel */
 void remmina_ssh_tunnel_free( RemminaSSHTunnel *tunnel );
 
+/* Serialize libssh calls on the session of the tunnel when it is shared through the pool.
+ * Needed before using REMMINA_SSH( tunnel )->session outside of the tunnel thread */
+void remmina_ssh_tunnel_lock( RemminaSSHTunnel *tunnel );
+void remmina_ssh_tunnel_unlock( RemminaSSHTunnel *tunnel );
+
+/*-----------------------------------------------------------------------------*
+*                           SSH Session pool                                  *
+*-----------------------------------------------------------------------------*/
+
+/* Authenticated sessions shared by the direct tunnels going through the same jump host,
+ * like OpenSSH ControlMaster. Idle sessions are closed after ssh_pool_idle_timeout seconds */
+
+/* Pool key of a tunnel not connected yet, or NULL when pooling is disabled */
+char *remmina_ssh_pool_key( RemminaSSH *ssh );
+
+/* Borrow the pooled session for key, returns FALSE when there is none */
+bool remmina_ssh_pool_attach( RemminaSSHTunnel *tunnel, const char *key );
+
+/* Give the freshly authenticated session of tunnel to the pool, the tunnel keeps using it */
+void remmina_ssh_pool_add( RemminaSSHTunnel *tunnel, const char *key );
+
 /*-----------------------------------------------------------------------------*
 *                           SSH sFTP                                          *
 *-----------------------------------------------------------------------------*/
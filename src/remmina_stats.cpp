@@ -148,6 +148,7 @@
 #include "remmina_file_manager.hpp"
 #include "remmina_icon.hpp"
 #include "remmina_log.hpp"
+#include "remmina_masterthread_exec.hpp"
 #include "remmina_pref.hpp"
 #include "remmina_sysinfo.hpp"
 #include "remmina_utils.hpp"
@@ -853,6 +854,63 @@ JsonNode *remmina_stats_get_kiosk_mode()
     return r;
 }
 
+/**
+ * Add a json member MAINTHREADQUEUE with the counters of the queue of calls
+ * made from other threads to the main thread.
+ *
+ * @return a JSON Node structure with the counters and the queue latency histogram
+ *
+ */
+JsonNode *remmina_stats_get_mainthread_queue()
+{
+    TRACE_CALL( __func__ );
+
+    JsonBuilder *b;
+    JsonNode *r;
+    RemminaMTExecStats stats;
+    char name[16];
+    gint i;
+
+    remmina_masterthread_exec_get_stats( &stats );
+
+    b = json_builder_new();
+    json_builder_begin_object( b );
+    json_builder_set_member_name( b, "posted" );
+    json_builder_add_int_value( b, stats.posted );
+    json_builder_set_member_name( b, "waited" );
+    json_builder_add_int_value( b, stats.waited );
+    json_builder_set_member_name( b, "batches" );
+    json_builder_add_int_value( b, stats.batches );
+    json_builder_set_member_name( b, "max_batch" );
+    json_builder_add_int_value( b, stats.max_batch );
+    json_builder_set_member_name( b, "lock_acquisitions" );
+    json_builder_add_int_value( b, stats.lock_acquisitions );
+    json_builder_set_member_name( b, "lock_contended" );
+    json_builder_add_int_value( b, stats.lock_contended );
+
+    /* Only the buckets used, keyed by their upper bound in us */
+    json_builder_set_member_name( b, "latency_us" );
+    json_builder_begin_object( b );
+    for( i = 0; i < REMMINA_MT_EXEC_LATENCY_BUCKETS; i++ )
+    {
+        if( stats.latency[i] == 0 )
+            continue;
+        if( i == REMMINA_MT_EXEC_LATENCY_BUCKETS - 1 )
+            g_snprintf( name, sizeof( name ), "more" );
+        else
+            g_snprintf( name, sizeof( name ), "%u", 1u << i );
+        json_builder_set_member_name( b, name );
+        json_builder_add_int_value( b, stats.latency[i] );
+    }
+    json_builder_end_object( b );
+
+    json_builder_end_object( b );
+    r = json_builder_get_root( b );
+    g_object_unref( b );
+
+    return r;
+}
+
 /**
  * Get all statistics in JSON format to send periodically to the PHP server.
  * The caller should free the returned buffer with g_free()
@@ -917,6 +975,10 @@ JsonNode *remmina_stats_get_all()
     json_builder_set_member_name( b, "KIOSK" );
     json_builder_add_value( b, n );
 
+    n = remmina_stats_get_mainthread_queue();
+    json_builder_set_member_name( b, "MAINTHREADQUEUE" );
+    json_builder_add_value( b, n );
+
     json_builder_end_object( b );
     n = json_builder_get_root( b );
     g_object_unref( b );